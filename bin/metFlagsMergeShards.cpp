@@ -0,0 +1,214 @@
+// Merges the outputs of a sharded flag reprocessing (scripts/metFlagsShardedReprocess.py) into the
+// output of the equivalent serial job, see METFlagsShardMerge.h for the ordering rules.
+//
+// Each input is a METFlagsShardWriter file, optionally followed by ":" and the profile file of
+// EcalDeadCellEventFlagProducer of the same shard. The merged file has the same trees as a shard
+// file, so merged files can be merged again; the merged profile tree ("filter") goes to the
+// --profile file. --digest prints a hash of the merged content: a sharded and a serial run of
+// the same inputs give the same digest.
+//
+// usage: metFlagsMergeShards -o <merged.root> [--profile <mergedProfile.root>] [--digest]
+//                            <shard.root>[:<profile.root>] ...
+
+#include "MyAnalysis/METFlags/interface/METFlagsShardMerge.h"
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace {
+
+  bool readShard(const std::string &fileName, METFlagsShardMerger &merger, std::string &error){
+
+    TFile file(fileName.c_str(), "READ");
+    if( file.IsZombie() ){ error = "cannot open " + fileName; return false; }
+
+    TTree *events = dynamic_cast<TTree*>(file.Get("events"));
+    TTree *lumis = dynamic_cast<TTree*>(file.Get("lumis"));
+    TTree *runs = dynamic_cast<TTree*>(file.Get("runs"));
+    TTree *meta = dynamic_cast<TTree*>(file.Get("meta"));
+    if( !events || !lumis || !runs || !meta ){ error = fileName + " is not a METFlagsShardWriter file"; return false; }
+
+    std::vector<std::string> *summaryNames = 0;
+    meta->SetBranchAddress("summaryNames", &summaryNames);
+    if( meta->GetEntries() != 1 || meta->GetEntry(0) <= 0 ){ error = fileName + " has no summary names"; return false; }
+    const bool namesOk = merger.setSummaryNames(*summaryNames);
+    delete summaryNames;
+    if( !namesOk ){ error = fileName + " : " + merger.error(); return false; }
+
+    METFlagsShardEvent evt;
+    ULong64_t event, bitword;
+    events->SetBranchAddress("run", &evt.run); events->SetBranchAddress("lumi", &evt.lumi);
+    events->SetBranchAddress("event", &event); events->SetBranchAddress("bitword", &bitword);
+    events->SetBranchAddress("fileIndex", &evt.fileIndex); events->SetBranchAddress("seq", &evt.seq);
+    for(Long64_t ie=0; ie<events->GetEntries(); ie++){
+       events->GetEntry(ie);
+       evt.event = event; evt.bitword = bitword;
+       merger.addEvent(evt);
+    }
+
+    UInt_t run, lumi;
+    std::vector<unsigned int> *values = 0;
+    lumis->SetBranchAddress("run", &run); lumis->SetBranchAddress("lumi", &lumi); lumis->SetBranchAddress("values", &values);
+    bool ok = true;
+    for(Long64_t il=0; ok && il<lumis->GetEntries(); il++){
+       lumis->GetEntry(il);
+       ok = merger.addLumi(run, lumi, std::vector<uint32_t>(values->begin(), values->end()));
+    }
+    delete values;
+    if( !ok ){ error = fileName + " : " + merger.error(); return false; }
+
+    METFlagsShardRun info;
+    std::vector<std::string> *flagNames = 0;
+    runs->SetBranchAddress("run", &run); runs->SetBranchAddress("tableVersion", &info.tableVersion); runs->SetBranchAddress("flagNames", &flagNames);
+    for(Long64_t ir=0; ok && ir<runs->GetEntries(); ir++){
+       runs->GetEntry(ir);
+       info.flagNames = *flagNames;
+       ok = merger.addRun(run, info);
+    }
+    delete flagNames;
+    if( !ok ){ error = fileName + " : " + merger.error(); return false; }
+
+    return true;
+  }
+
+  bool readProfile(const std::string &fileName, METFlagsShardMerger &merger, std::string &error){
+
+    TFile file(fileName.c_str(), "READ");
+    TTree *tree = file.IsZombie() ? 0 : dynamic_cast<TTree*>(file.Get("filter"));
+    if( !tree ){ error = fileName + " is not an EcalDeadCellEventFlagProducer profile file"; return false; }
+
+// Same branch types as the profile tree of EcalDeadCellEventFlagProducer
+    Int_t run, event, lumi;
+    std::vector<int> *flags = 0;
+    std::vector<std::string> *strs = 0;
+    tree->SetBranchAddress("run", &run); tree->SetBranchAddress("event", &event); tree->SetBranchAddress("lumi", &lumi);
+    tree->SetBranchAddress("cutFlowFlag", &flags); tree->SetBranchAddress("cutFlowStr", &strs);
+
+    for(Long64_t ir=0; ir<tree->GetEntries(); ir++){
+       tree->GetEntry(ir);
+       METFlagsProfileRow row;
+       row.run = run; row.lumi = lumi; row.event = event;
+       row.cutFlowFlag = *flags; row.cutFlowStr = *strs;
+       merger.addProfileRow(row);
+    }
+    delete flags; delete strs;
+    return true;
+  }
+
+  bool writeMerged(const std::string &fileName, const METFlagsShardMerger &merger){
+
+    TFile file(fileName.c_str(), "RECREATE");
+    if( file.IsZombie() ) return false;
+
+    METFlagsShardEvent evt;
+    ULong64_t event, bitword;
+    TTree *events = new TTree("events", "flag results per event");
+    events->Branch("run", &evt.run, "run/i"); events->Branch("lumi", &evt.lumi, "lumi/i");
+    events->Branch("event", &event, "event/l"); events->Branch("bitword", &bitword, "bitword/l");
+    events->Branch("fileIndex", &evt.fileIndex, "fileIndex/i"); events->Branch("seq", &evt.seq, "seq/i");
+    for(unsigned int ie=0; ie<merger.events().size(); ie++){
+       evt = merger.events()[ie]; event = evt.event; bitword = evt.bitword;
+       events->Fill();
+    }
+
+    UInt_t run, lumi;
+    std::vector<unsigned int> values, *valuesPtr = &values;
+    TTree *lumis = new TTree("lumis", "lumi summaries");
+    lumis->Branch("run", &run, "run/i"); lumis->Branch("lumi", &lumi, "lumi/i"); lumis->Branch("values", &valuesPtr);
+    for(std::map<METFlagsShardMerger::LumiKey, std::vector<uint32_t> >::const_iterator it = merger.lumis().begin(); it != merger.lumis().end(); ++it){
+       run = it->first.first; lumi = it->first.second; values.assign(it->second.begin(), it->second.end());
+       lumis->Fill();
+    }
+
+    UInt_t tableVersion;
+    std::vector<std::string> flagNames, *flagNamesPtr = &flagNames;
+    TTree *runs = new TTree("runs", "bitword layout per run");
+    runs->Branch("run", &run, "run/i"); runs->Branch("tableVersion", &tableVersion, "tableVersion/i"); runs->Branch("flagNames", &flagNamesPtr);
+    for(std::map<uint32_t, METFlagsShardRun>::const_iterator it = merger.runs().begin(); it != merger.runs().end(); ++it){
+       run = it->first; tableVersion = it->second.tableVersion; flagNames = it->second.flagNames;
+       runs->Fill();
+    }
+
+    std::vector<std::string> summaryNames = merger.summaryNames(), *summaryNamesPtr = &summaryNames;
+    TTree *meta = new TTree("meta", "names of the lumi summaries");
+    meta->Branch("summaryNames", &summaryNamesPtr);
+    meta->Fill();
+
+    file.Write();
+    file.Close();
+    return true;
+  }
+
+  bool writeProfile(const std::string &fileName, const METFlagsShardMerger &merger){
+
+    TFile file(fileName.c_str(), "RECREATE");
+    if( file.IsZombie() ) return false;
+
+    Int_t run, event, lumi;
+    std::vector<int> flags, *flagsPtr = &flags;
+    std::vector<std::string> strs, *strsPtr = &strs;
+    TTree *tree = new TTree("filter", "filter profile");
+    tree->Branch("run", &run, "run/I"); tree->Branch("event", &event, "event/I"); tree->Branch("lumi", &lumi, "lumi/I");
+    tree->Branch("cutFlowFlag", &flagsPtr); tree->Branch("cutFlowStr", &strsPtr);
+    for(unsigned int ir=0; ir<merger.profileRows().size(); ir++){
+       const METFlagsProfileRow &row = merger.profileRows()[ir];
+       run = row.run; event = row.event; lumi = row.lumi; flags = row.cutFlowFlag; strs = row.cutFlowStr;
+       tree->Fill();
+    }
+
+    file.Write();
+    file.Close();
+    return true;
+  }
+
+  void usage(const char *name){
+    fprintf(stderr, "usage: %s -o <merged.root> [--profile <mergedProfile.root>] [--digest] <shard.root>[:<profile.root>] ...\n", name);
+  }
+}
+
+int main(int argc, char **argv){
+
+  std::string outputName, profileName;
+  bool printDigest = false;
+  std::vector<std::string> inputs;
+
+  for(int ia=1; ia<argc; ia++){
+     const std::string arg = argv[ia];
+     if( arg == "-o" && ia+1 < argc ) outputName = argv[++ia];
+     else if( arg == "--profile" && ia+1 < argc ) profileName = argv[++ia];
+     else if( arg == "--digest" ) printDigest = true;
+     else if( !arg.empty() && arg[0] == '-' ){ usage(argv[0]); return 1; }
+     else inputs.push_back(arg);
+  }
+  if( outputName.empty() || inputs.empty() ){ usage(argv[0]); return 1; }
+
+  METFlagsShardMerger merger;
+  bool hasProfiles = false;
+  std::string error;
+  for(unsigned int ii=0; ii<inputs.size(); ii++){
+     const std::string::size_type colon = inputs[ii].find(':');
+     const std::string shardName = inputs[ii].substr(0, colon);
+     bool ok = readShard(shardName, merger, error);
+     if( ok && colon != std::string::npos ){ ok = readProfile(inputs[ii].substr(colon + 1), merger, error); hasProfiles = true; }
+     if( !ok ){ fprintf(stderr, "%s\n", error.c_str()); return 1; }
+  }
+
+  if( !merger.finalize() ){ fprintf(stderr, "%s\n", merger.error().c_str()); return 1; }
+
+  if( !writeMerged(outputName, merger) ){ fprintf(stderr, "cannot write %s\n", outputName.c_str()); return 1; }
+  if( hasProfiles && !profileName.empty() && !writeProfile(profileName, merger) ){
+     fprintf(stderr, "cannot write %s\n", profileName.c_str()); return 1;
+  }
+
+  printf("merged %u shards : %u events, %u lumis, %u runs\n", (unsigned int)inputs.size(), (unsigned int)merger.events().size(),
+         (unsigned int)merger.lumis().size(), (unsigned int)merger.runs().size());
+  if( printDigest ) printf("digest %016llx\n", (unsigned long long)merger.digest());
+
+  return 0;
+}
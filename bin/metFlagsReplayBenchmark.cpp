@@ -0,0 +1,217 @@
+// Standalone replay benchmark of the MET flag algorithms.
+//
+// Replays a fixture written by METFlagsFixtureRecorder through the framework-free algorithm
+// cores and reports, per algorithm, the distribution of the per-event time (ns) and the number
+// of heap allocations per event:
+//   TP   : evaluateDeadCellTP        (EcalDeadCellEventFlagProducer, TP method)
+//   HIT  : EcalDeadTowerEtSum        (EcalDeadCellEventFlagProducer, recovered rechit method)
+//   DR   : SimpleDRStagePlan, jet selection, jet-MET dphi and dead cell dR (simpleDRFlagProducer)
+//   CSC  : endpoints, features and halo cuts of every cosmic track (CSCHaloFlagProducer, reco level)
+//
+// usage: metFlagsReplayBenchmark <fixture> [-n iterations] [--et-cut GeV] [--dr-cut dR]
+//                                [--dphi-cut dphi] [--dr-status status] [--jet-pt GeV] [--jet-eta eta]
+
+#include "MyAnalysis/METFlags/interface/METFlagsReplayFixture.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadCellAlgos.h"
+#include "MyAnalysis/METFlags/interface/CSCHaloTrackAlgo.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// Every heap allocation of the process goes through these
+static unsigned long long gAllocations = 0;
+
+void* operator new(std::size_t size) {
+  ++gAllocations;
+  void *p = std::malloc(size ? size : 1);
+  if( !p ) throw std::bad_alloc();
+  return p;
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+  struct Options {
+    int iterations;
+    double etCut, drCut, dphiCut;
+    int drStatus;
+    double jetPt, jetEta;
+  };
+
+  long long nowNs(){
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000LL + ts.tv_nsec;
+  }
+
+  class AlgoStats {
+   public:
+    explicit AlgoStats(const char *name) : name_(name), allocations_(0) {}
+
+    void add(long long ns, unsigned long long allocations){ times_.push_back(ns); allocations_ += allocations; }
+
+    void print() const {
+      if( times_.empty() ) return;
+      std::vector<long long> sorted(times_);
+      std::sort(sorted.begin(), sorted.end());
+      double sum = 0;
+      for(unsigned int i=0; i<sorted.size(); i++) sum += sorted[i];
+      printf("%-4s %10u %10.0f %10lld %10lld %10lld %10lld %12.2f\n", name_, (unsigned int)sorted.size(), sum/sorted.size(),
+             percentile(sorted, 0.50), percentile(sorted, 0.90), percentile(sorted, 0.99), sorted.back(),
+             double(allocations_)/sorted.size());
+    }
+
+   private:
+    static long long percentile(const std::vector<long long> &sorted, double q){
+      unsigned int idx = (unsigned int)(q*(sorted.size()-1) + 0.5);
+      return sorted[idx];
+    }
+
+    const char *name_;
+    std::vector<long long> times_;
+    unsigned long long allocations_;
+  };
+
+  // Results are accumulated here so that the compiler can not drop the work
+  volatile long long gSink = 0;
+
+  void runTP(const EcalDeadChannelTable &table, const EcalDeadChannelSelection &deadChannels, const METFlagsReplayEvent &evt, const Options &opt){
+    ReplayTPSource tps(evt.tps);
+    gSink += evaluateDeadCellTP(table, deadChannels, tps, opt.etCut, true);
+  }
+
+  void runHIT(const EcalDeadChannelTable &table, const EcalDeadChannelSelection &deadChannels, EcalDeadTowerEtSum &sum, const METFlagsReplayEvent &evt, const Options &opt){
+    sum.reset(table, deadChannels, 13, true);
+    for(unsigned int ih=0; ih<evt.ebHits.size(); ih++) sum.add(evt.ebHits[ih].rawId, evt.ebHits[ih].energy, evt.ebHits[ih].isRecovered);
+    for(unsigned int ih=0; ih<evt.eeHits.size(); ih++) sum.add(evt.eeHits[ih].rawId, evt.eeHits[ih].energy, evt.eeHits[ih].isRecovered);
+    gSink += sum.status(opt.etCut);
+  }
+
+// The plan is a member of simpleDRFlagProducer, its jet lists reused from event to event
+  void runDR(const EcalDeadChannelTable &table, const EcalDeadChannelSelection &evaluatedChannels, const METFlagsReplayEvent &evt, SimpleDRStagePlan &plan){
+    int dPhiToMETstatus = 0, deadCellStatus = 0, boundaryStatus = 0;
+    plan.run(evt.jets, evt.metPhi, table, evaluatedChannels, dPhiToMETstatus, deadCellStatus, boundaryStatus);
+    gSink += deadCellStatus;
+  }
+
+  void runCSC(const CSCHaloTrackCuts &cuts, const METFlagsReplayEvent &evt){
+    int nHaloTracks = 0;
+    for(unsigned int it=0; it<evt.tracks.size(); it++){
+       const ReplayCosmicTrack &trk = evt.tracks[it];
+       CSCTrackEndpoints endpoints;
+// As CSCHaloFlagProducer : endpoints ordered by |z|, positions looked up for those two only
+       for(unsigned int ih=0; ih<trk.hits.size(); ih++) endpoints.addCandidate(std::abs(trk.hits[ih].z), ih);
+       if( endpoints.nHits() < cuts.min_csc_hits ) continue;
+       endpoints.setPositions(trk.hits[endpoints.innerIndex()], trk.hits[endpoints.outerIndex()]);
+       const CSCHaloTrackFeatures features = computeHaloTrackFeatures(endpoints, trk.outerMomentumTheta, trk.normChi2);
+       if( passesHaloTrackCuts(features, cuts) ) nHaloTracks++;
+    }
+    gSink += nHaloTracks;
+  }
+
+  // Defaults of CSCHaloFlagProducer_cfi
+  CSCHaloTrackCuts defaultHaloTrackCuts(){
+    CSCHaloTrackCuts cuts;
+    cuts.deta_threshold = 0.1; cuts.dphi_threshold = 1.0;
+    cuts.min_outer_theta = 0.1; cuts.max_outer_theta = 3.0;
+    cuts.min_inner_radius = 0.; cuts.max_inner_radius = 99999.;
+    cuts.min_outer_radius = 0.; cuts.max_outer_radius = 99999.;
+    cuts.norm_chi2_threshold = 8.; cuts.max_dr_over_dz = 0.13;
+    cuts.min_csc_hits = 3;
+    return cuts;
+  }
+
+  void usage(const char *prog){
+    fprintf(stderr, "usage: %s <fixture> [-n iterations] [--et-cut GeV] [--dr-cut dR] [--dphi-cut dphi]"
+                    " [--dr-status status] [--jet-pt GeV] [--jet-eta eta]\n", prog);
+  }
+}
+
+int main(int argc, char **argv){
+
+  if( argc < 2 ){ usage(argv[0]); return 1; }
+
+// Defaults of the producer configurations
+  Options opt;
+  opt.iterations = 10;
+  opt.etCut = 63.75; opt.drCut = 0.3; opt.dphiCut = 0.5; opt.drStatus = -12;
+  opt.jetPt = 30; opt.jetEta = 9999;
+
+  std::string fixtureName;
+  for(int ia=1; ia<argc; ia++){
+     const std::string arg = argv[ia];
+     const bool hasValue = ia+1 < argc;
+     if( arg == "-n" && hasValue ) opt.iterations = std::atoi(argv[++ia]);
+     else if( arg == "--et-cut" && hasValue ) opt.etCut = std::atof(argv[++ia]);
+     else if( arg == "--dr-cut" && hasValue ) opt.drCut = std::atof(argv[++ia]);
+     else if( arg == "--dphi-cut" && hasValue ) opt.dphiCut = std::atof(argv[++ia]);
+     else if( arg == "--dr-status" && hasValue ) opt.drStatus = std::atoi(argv[++ia]);
+     else if( arg == "--jet-pt" && hasValue ) opt.jetPt = std::atof(argv[++ia]);
+     else if( arg == "--jet-eta" && hasValue ) opt.jetEta = std::atof(argv[++ia]);
+     else if( arg[0] != '-' && fixtureName.empty() ) fixtureName = arg;
+     else { usage(argv[0]); return 1; }
+  }
+  if( fixtureName.empty() || opt.iterations <= 0 ){ usage(argv[0]); return 1; }
+
+  METFlagsReplayFixture fixture;
+  if( !fixture.read(fixtureName) ){ fprintf(stderr, "%s\n", fixture.error().c_str()); return 2; }
+
+  printf("fixture : %s  masked channels : %u  towers : %u  events : %u  iterations : %d\n", fixtureName.c_str(),
+         fixture.table.size(), (unsigned int)fixture.table.towers().size(), (unsigned int)fixture.events.size(), opt.iterations);
+
+  const CSCHaloTrackCuts cuts = defaultHaloTrackCuts();
+  EcalDeadTowerEtSum sum;
+
+// Built once per run in the producers
+  EcalDeadChannelSelection deadChannels, evaluatedChannels;
+  deadChannels.build(fixture.table, 13);
+  evaluatedChannels.build(fixture.table, opt.drStatus);
+
+// Defaults of simpleDRFlagProducer_cfi for the cracks, which are off
+  SimpleDRStagePlan plan;
+  plan.build(opt.jetPt, opt.jetEta, opt.dphiCut, opt.drCut, false, 1.3, 1.7, 2.8, 3.2);
+
+  AlgoStats tpStats("TP"), hitStats("HIT"), drStats("DR"), cscStats("CSC");
+
+  for(int iter=0; iter<opt.iterations; iter++){
+     for(unsigned int ie=0; ie<fixture.events.size(); ie++){
+        const METFlagsReplayEvent &evt = fixture.events[ie];
+        long long t0; unsigned long long a0;
+
+        a0 = gAllocations; t0 = nowNs();
+        runTP(fixture.table, deadChannels, evt, opt);
+        tpStats.add(nowNs() - t0, gAllocations - a0);
+
+        a0 = gAllocations; t0 = nowNs();
+        runHIT(fixture.table, deadChannels, sum, evt, opt);
+        hitStats.add(nowNs() - t0, gAllocations - a0);
+
+        a0 = gAllocations; t0 = nowNs();
+        runDR(fixture.table, evaluatedChannels, evt, plan);
+        drStats.add(nowNs() - t0, gAllocations - a0);
+
+        a0 = gAllocations; t0 = nowNs();
+        runCSC(cuts, evt);
+        cscStats.add(nowNs() - t0, gAllocations - a0);
+     }
+  }
+
+  printf("%-4s %10s %10s %10s %10s %10s %10s %12s\n", "algo", "events", "mean[ns]", "p50[ns]", "p90[ns]", "p99[ns]", "max[ns]", "allocs/evt");
+  tpStats.print();
+  hitStats.print();
+  drStats.print();
+  cscStats.print();
+
+  return 0;
+}
@@ -0,0 +1,41 @@
+// Prints a skip bitmap written by the skipBitmapDir option of the flag producers: the GUID and
+// the number of entries of the input file it belongs to, the number of tagged entries and,
+// with --entries, the tagged entry numbers one per line (to feed an entry-based skim).
+//
+// usage: metFlagsSkipBitmapDump <bitmap.mfeb> [--entries]
+
+#include "MyAnalysis/METFlags/interface/METFlagsEntryBitmap.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv){
+
+  if( argc < 2 || ( argc > 2 && std::strcmp(argv[2], "--entries") != 0 ) ){
+     fprintf(stderr, "usage: %s <bitmap.mfeb> [--entries]\n", argv[0]);
+     return 1;
+  }
+
+  METFlagsEntryBitmap bitmap;
+  std::string guid;
+  uint64_t nEntries = 0;
+  if( !bitmap.read(argv[1], guid, nEntries) ){
+     fprintf(stderr, "%s\n", bitmap.error().c_str());
+     return 1;
+  }
+
+  if( argc > 2 ){
+     std::vector<uint64_t> entries;
+     bitmap.entries(entries);
+     for(unsigned int ie=0; ie<entries.size(); ie++) printf("%llu\n", (unsigned long long)entries[ie]);
+     return 0;
+  }
+
+  printf("guid     : %s\n", guid.c_str());
+  printf("entries  : %llu\n", (unsigned long long)nEntries);
+  printf("tagged   : %llu\n", (unsigned long long)bitmap.cardinality());
+  printf("size     : %llu bytes\n", (unsigned long long)bitmap.sizeInBytes());
+  return 0;
+}
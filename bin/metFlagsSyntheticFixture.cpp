@@ -0,0 +1,388 @@
+// Synthetic replay fixture generator for stress-testing the MET flag algorithms.
+//
+// Writes a fixture in the METFlagsReplayFixture format (see src/METFlagsReplayFixture.cc) with a
+// dead channel table and events at configurable densities, to be replayed by metFlagsReplayBenchmark:
+//   dead channels : whole dead trigger towers plus isolated dead crystals in EB and EE. The baseline
+//                   (--masked-scale 1) is of the order of the masked channels of a real run,
+//                   --masked-scale up to 10 (or more) multiplies it
+//   TP digis      : the TPs of every dead tower plus --tp-occupancy of the other towers, with a
+//                   fraction --hot-tower-fraction of the dead-tower TPs above the default Et cut
+//   rechits       : pileup-driven EB/EE occupancy plus a recovered rechit for a fraction
+//                   --recovered-fraction of the dead crystals
+//   jets/MET      : a few hard jets plus pileup jets, --pileup up to 200; a fraction --dead-jet-fraction
+//                   of the events has a hard jet on a dead crystal with the MET along it
+//   cosmic tracks : Poisson(--cosmics) stand-alone tracks per event, half of them beam-halo like
+//
+// The crystal positions are the nominal ones and the EE crystals are grouped into towers by the
+// nominal EE tower eta/phi boundaries: the fixture is meant for timing, not for physics.
+// The same --seed always gives the same fixture.
+//
+// usage: metFlagsSyntheticFixture <output> [--events N] [--masked-scale S] [--pileup PU] [--seed N]
+//                                 [--tp-occupancy f] [--hot-tower-fraction f] [--recovered-fraction f]
+//                                 [--dead-jet-fraction f] [--cosmics mean] [--events-per-lumi N]
+
+#include "MyAnalysis/METFlags/interface/METFlagsReplayFixture.h"
+
+#include "DataFormats/EcalDetId/interface/EBDetId.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
+#include "DataFormats/EcalDetId/interface/EcalTrigTowerDetId.h"
+#include "DataFormats/EcalDetId/interface/EcalSubdetector.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <algorithm>
+
+namespace {
+
+  struct Options {
+    unsigned int events;
+    double maskedScale;
+    double pileup;
+    unsigned long long seed;
+    double tpOccupancy, hotTowerFraction, recoveredFraction, deadJetFraction;
+    double cosmics;
+    unsigned int eventsPerLumi;
+  };
+
+  // splitmix64 : small, fast and identical on every platform, unlike std::rand
+  class Random {
+   public:
+    explicit Random(unsigned long long seed) : state_(seed) {}
+
+    unsigned long long next(){
+      unsigned long long z = (state_ += 0x9E3779B97F4A7C15ULL);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      return z ^ (z >> 31);
+    }
+    // [0, 1)
+    double uniform(){ return (next() >> 11) * (1.0/9007199254740992.0); }
+    double uniform(double lo, double hi){ return lo + (hi-lo)*uniform(); }
+    unsigned int index(unsigned int n){ return (unsigned int)(uniform()*n); }
+    double exponential(double mean){ return -mean*std::log(1. - uniform()); }
+    double gaussian(double mean, double sigma){
+      const double u1 = 1. - uniform(), u2 = uniform();
+      return mean + sigma*std::sqrt(-2.*std::log(u1))*std::cos(2.*M_PI*u2);
+    }
+    unsigned int poisson(double mean){
+      if( mean <= 0 ) return 0;
+      if( mean > 30 ){ const double n = gaussian(mean, std::sqrt(mean)) + 0.5; return n < 0 ? 0 : (unsigned int)n; }
+      const double limit = std::exp(-mean);
+      unsigned int n = 0; double p = uniform();
+      while( p > limit ){ n++; p *= uniform(); }
+      return n;
+    }
+
+   private:
+    unsigned long long state_;
+  };
+
+  struct Crystal {
+    uint32_t rawId, ttRawId;
+    int subdet, ix, iy, iz;
+    double eta, phi;
+  };
+
+  double wrapPhi(double phi){
+    while( phi > M_PI ) phi -= 2*M_PI;
+    while( phi <= -M_PI ) phi += 2*M_PI;
+    return phi;
+  }
+
+  // Nominal EE trigger tower eta boundaries, tower ieta 18 to 28
+  const double eeTowerEtaEdges[] = { 1.479, 1.566, 1.653, 1.740, 1.830, 1.930, 2.043, 2.172, 2.322, 2.500, 2.650, 3.0 };
+
+  int eeTowerIeta(double absEta){
+    for(int ie=0; ie<11; ie++) if( absEta < eeTowerEtaEdges[ie+1] ) return 18 + ie;
+    return 28;
+  }
+
+  void buildCrystals(std::vector<Crystal> &crystals){
+
+    for( int ieta=-85; ieta<=85; ieta++ ){
+       for( int iphi=1; iphi<=360; iphi++ ){
+          if(! EBDetId::validDetId( ieta, iphi ) )  continue;
+          const EBDetId detid( ieta, iphi, EBDetId::ETAPHIMODE );
+          Crystal c;
+          c.rawId = detid.rawId(); c.ttRawId = detid.tower().rawId();
+          c.subdet = 1; c.ix = ieta; c.iy = iphi; c.iz = 0;
+          c.eta = (ieta > 0 ? 1 : -1)*(std::abs(ieta) - 0.5)*0.0174;
+          c.phi = wrapPhi((iphi - 10.5)*M_PI/180.);
+          crystals.push_back(c);
+       }
+    }
+
+// EE crystals : 2.862 cm pitch at |z| = 317 cm
+    for( int ix=1; ix<=100; ix++ ){
+       for( int iy=1; iy<=100; iy++ ){
+          for( int iz=-1; iz<=1; iz+=2 ){
+             if(! EEDetId::validDetId( ix, iy, iz ) )  continue;
+             const EEDetId detid( ix, iy, iz, EEDetId::XYMODE );
+             const double x = (ix - 50.5)*2.862, y = (iy - 50.5)*2.862, z = iz*317.;
+             const double theta = std::atan2(std::sqrt(x*x + y*y), z);
+             Crystal c;
+             c.rawId = detid.rawId();
+             c.subdet = 2; c.ix = ix; c.iy = iy; c.iz = iz;
+             c.eta = -std::log(std::tan(theta/2.));
+             c.phi = std::atan2(y, x);
+             const int ttIphi = 1 + (int)((c.phi < 0 ? c.phi + 2*M_PI : c.phi)/(2*M_PI)*72) % 72;
+             c.ttRawId = EcalTrigTowerDetId( iz, EcalEndcap, eeTowerIeta(std::fabs(c.eta)), ttIphi ).rawId();
+             crystals.push_back(c);
+          }
+       }
+    }
+  }
+
+  // Status codes of the dead crystals : mostly dead without/with TP (14/13), some lower codes
+  int deadStatus(Random &rnd){
+    const double u = rnd.uniform();
+    if( u < 0.45 ) return 14;
+    if( u < 0.85 ) return 13;
+    if( u < 0.95 ) return 12;
+    return 3;
+  }
+
+  void buildTable(const Options &opt, const std::vector<Crystal> &crystals,
+                  const std::map<uint32_t, std::vector<unsigned int> > &towerCrystals, Random &rnd, EcalDeadChannelTable &table){
+
+// Baseline : 24 dead EB towers, 8 dead EE towers, 200 isolated EB and 150 isolated EE crystals
+    const unsigned int nEBTowers = (unsigned int)(24*opt.maskedScale + 0.5), nEETowers = (unsigned int)(8*opt.maskedScale + 0.5);
+    const unsigned int nEBSingles = (unsigned int)(200*opt.maskedScale + 0.5), nEESingles = (unsigned int)(150*opt.maskedScale + 0.5);
+
+    std::vector<unsigned int> ebCrystals, eeCrystals;
+    for(unsigned int ic=0; ic<crystals.size(); ic++) (crystals[ic].subdet == 1 ? ebCrystals : eeCrystals).push_back(ic);
+
+    std::set<unsigned int> dead;
+    std::set<uint32_t> deadTowers;
+    for(unsigned int it=0; it<nEBTowers + nEETowers; it++){
+       const std::vector<unsigned int> &pool = it < nEBTowers ? ebCrystals : eeCrystals;
+// Give up on towers rather than loop forever when asked for more than there are
+       for(int attempt=0; attempt<100; attempt++){
+          const uint32_t ttRawId = crystals[pool[rnd.index(pool.size())]].ttRawId;
+          if( !deadTowers.insert(ttRawId).second ) continue;
+          const std::vector<unsigned int> &members = towerCrystals.find(ttRawId)->second;
+          dead.insert(members.begin(), members.end());
+          break;
+       }
+    }
+    for(unsigned int is=0; is<nEBSingles + nEESingles; is++){
+       const std::vector<unsigned int> &pool = is < nEBSingles ? ebCrystals : eeCrystals;
+       dead.insert(pool[rnd.index(pool.size())]);
+    }
+
+    table.clear();
+    for(std::set<unsigned int>::const_iterator id = dead.begin(); id != dead.end(); ++id){
+       const Crystal &c = crystals[*id];
+       EcalDeadChannelTable::Channel chn;
+       chn.rawId = c.rawId; chn.ttRawId = c.ttRawId;
+       chn.subdet = c.subdet; chn.ix = c.ix; chn.iy = c.iy; chn.iz = c.iz;
+       chn.status = deadStatus(rnd);
+       chn.eta = c.eta; chn.phi = c.phi; chn.theta = 2.*std::atan(std::exp(-c.eta));
+       chn.zside = c.subdet == 1 ? (c.ix > 0 ? 1 : -1) : c.iz;
+       chn.tower = 0;
+       table.addChannel(chn);
+    }
+    table.finalize();
+
+    for(unsigned int it=0; it<table.towers().size(); it++){
+       table.setTowerConstituents(it, towerCrystals.find(table.towers()[it].rawId)->second.size());
+    }
+  }
+
+  ReplayTP makeTP(uint32_t ttRawId, unsigned int compressedEt){
+    ReplayTP tp;
+    tp.ttRawId = ttRawId;
+    tp.compressedEt = compressedEt > 255 ? 255 : compressedEt;
+// Linear 0.25 GeV LSB, as the nominal TPG scale
+    tp.et = tp.compressedEt*0.25;
+    return tp;
+  }
+
+  void fillTPs(const Options &opt, const EcalDeadChannelTable &table, const std::vector<uint32_t> &allTowers,
+               Random &rnd, METFlagsReplayEvent &evt){
+
+    std::set<uint32_t> done;
+    for(unsigned int it=0; it<table.towers().size(); it++){
+       const uint32_t ttRawId = table.towers()[it].rawId;
+       const bool hot = rnd.uniform() < opt.hotTowerFraction;
+       const unsigned int compressedEt = hot ? 256 + (unsigned int)rnd.exponential(40.) : (unsigned int)rnd.exponential(2. + 0.05*opt.pileup);
+       evt.tps.push_back(makeTP(ttRawId, compressedEt));
+       done.insert(ttRawId);
+    }
+
+    const unsigned int nOthers = rnd.poisson(opt.tpOccupancy*allTowers.size());
+    for(unsigned int ip=0; ip<nOthers; ip++){
+       const uint32_t ttRawId = allTowers[rnd.index(allTowers.size())];
+       if( !done.insert(ttRawId).second ) continue;
+       evt.tps.push_back(makeTP(ttRawId, 1 + (unsigned int)rnd.exponential(4. + 0.1*opt.pileup)));
+    }
+    std::sort(evt.tps.begin(), evt.tps.end());
+  }
+
+  void fillRecHits(const Options &opt, const EcalDeadChannelTable &table, const std::vector<Crystal> &crystals,
+                   Random &rnd, METFlagsReplayEvent &evt){
+
+// Zero-suppressed occupancy grows with pileup
+    const unsigned int nHits = rnd.poisson(1500. + 60.*opt.pileup);
+    for(unsigned int ih=0; ih<nHits; ih++){
+       const Crystal &c = crystals[rnd.index(crystals.size())];
+       const ReplayRecHit hit = { c.rawId, (float)rnd.exponential(c.subdet == 1 ? 0.4 : 1.5), false };
+       (c.subdet == 1 ? evt.ebHits : evt.eeHits).push_back(hit);
+    }
+
+    for(unsigned int ic=0; ic<table.channels().size(); ic++){
+       if( rnd.uniform() >= opt.recoveredFraction ) continue;
+       const EcalDeadChannelTable::Channel &chn = table.channels()[ic];
+       const ReplayRecHit hit = { chn.rawId, (float)rnd.exponential(5.), true };
+       (chn.subdet == 1 ? evt.ebHits : evt.eeHits).push_back(hit);
+    }
+  }
+
+  FlagJet makeJet(double pt, double eta, double phi){
+    FlagJet jet = { pt, eta, phi };
+    return jet;
+  }
+
+  void fillJetsAndMET(const Options &opt, const EcalDeadChannelTable &table, Random &rnd, METFlagsReplayEvent &evt){
+
+    const unsigned int nHard = 2 + rnd.index(5);
+    for(unsigned int ij=0; ij<nHard; ij++){
+       evt.jets.push_back(makeJet(30. + rnd.exponential(60.), rnd.uniform(-2.5, 2.5), rnd.uniform(-M_PI, M_PI)));
+    }
+
+// Pileup jets : soft and forward-spread, a few of them above the 30 GeV selection at high pileup
+    const unsigned int nPU = rnd.poisson(0.6*opt.pileup);
+    for(unsigned int ij=0; ij<nPU; ij++){
+       evt.jets.push_back(makeJet(5. + rnd.exponential(7.), rnd.uniform(-4.7, 4.7), rnd.uniform(-M_PI, M_PI)));
+    }
+
+    evt.metPt = rnd.exponential(20. + 0.2*opt.pileup);
+    evt.metPhi = rnd.uniform(-M_PI, M_PI);
+
+    if( !table.empty() && rnd.uniform() < opt.deadJetFraction ){
+       const EcalDeadChannelTable::Channel &chn = table.channels()[rnd.index(table.size())];
+       evt.jets.push_back(makeJet(50. + rnd.exponential(100.), chn.eta, chn.phi));
+       evt.metPt += 30. + rnd.exponential(50.);
+       evt.metPhi = chn.phi;
+    }
+
+// Jet collections come pt-ordered
+    std::vector<std::pair<double, unsigned int> > order;
+    for(unsigned int ij=0; ij<evt.jets.size(); ij++) order.push_back(std::make_pair(-evt.jets[ij].pt, ij));
+    std::sort(order.begin(), order.end());
+    std::vector<FlagJet> sorted;
+    for(unsigned int ij=0; ij<order.size(); ij++) sorted.push_back(evt.jets[order[ij].second]);
+    evt.jets.swap(sorted);
+  }
+
+  void fillCosmics(const Options &opt, Random &rnd, METFlagsReplayEvent &evt){
+
+// CSC station z positions (cm)
+    static const double stationZ[] = { 600., 700., 830., 940., 1020. };
+
+    const unsigned int nTracks = rnd.poisson(opt.cosmics);
+    for(unsigned int it=0; it<nTracks; it++){
+       ReplayCosmicTrack trk;
+       const bool halo = rnd.uniform() < 0.5;
+       const double side = rnd.uniform() < 0.5 ? -1. : 1.;
+       const double r0 = rnd.uniform(150., 650.), phi0 = rnd.uniform(-M_PI, M_PI);
+       trk.normChi2 = rnd.exponential(halo ? 2. : 5.);
+       trk.outerMomentumTheta = halo ? (side > 0 ? rnd.uniform(0., 0.05) : M_PI - rnd.uniform(0., 0.05)) : rnd.uniform(0.2, M_PI - 0.2);
+
+       const unsigned int nHits = 2 + rnd.index(4*6);
+       for(unsigned int ih=0; ih<nHits; ih++){
+          const double z = side*(stationZ[rnd.index(5)] + rnd.uniform(-10., 10.));
+// halo : parallel to the beam line;  others : spread in r and phi
+          const double r = halo ? r0 + rnd.gaussian(0., 2.) : rnd.uniform(100., 700.);
+          const double phi = halo ? phi0 + rnd.gaussian(0., 0.005) : rnd.uniform(-M_PI, M_PI);
+          const CSCHitPosition hit = { (float)(r*std::cos(phi)), (float)(r*std::sin(phi)), (float)z };
+          trk.hits.push_back(hit);
+       }
+       evt.tracks.push_back(trk);
+    }
+  }
+
+  void usage(const char *prog){
+    fprintf(stderr, "usage: %s <output> [--events N] [--masked-scale S] [--pileup PU] [--seed N] [--tp-occupancy f]"
+                    " [--hot-tower-fraction f] [--recovered-fraction f] [--dead-jet-fraction f] [--cosmics mean]"
+                    " [--events-per-lumi N]\n", prog);
+  }
+}
+
+int main(int argc, char **argv){
+
+  Options opt;
+  opt.events = 1000;
+  opt.maskedScale = 1.;
+  opt.pileup = 20.;
+  opt.seed = 12345;
+  opt.tpOccupancy = 0.05;
+  opt.hotTowerFraction = 0.01;
+  opt.recoveredFraction = 0.5;
+  opt.deadJetFraction = 0.05;
+  opt.cosmics = 0.1;
+  opt.eventsPerLumi = 100;
+
+  std::string outputName;
+  for(int ia=1; ia<argc; ia++){
+     const std::string arg = argv[ia];
+     const bool hasValue = ia+1 < argc;
+     if( arg == "--events" && hasValue ) opt.events = std::strtoul(argv[++ia], 0, 10);
+     else if( arg == "--masked-scale" && hasValue ) opt.maskedScale = std::atof(argv[++ia]);
+     else if( arg == "--pileup" && hasValue ) opt.pileup = std::atof(argv[++ia]);
+     else if( arg == "--seed" && hasValue ) opt.seed = std::strtoull(argv[++ia], 0, 10);
+     else if( arg == "--tp-occupancy" && hasValue ) opt.tpOccupancy = std::atof(argv[++ia]);
+     else if( arg == "--hot-tower-fraction" && hasValue ) opt.hotTowerFraction = std::atof(argv[++ia]);
+     else if( arg == "--recovered-fraction" && hasValue ) opt.recoveredFraction = std::atof(argv[++ia]);
+     else if( arg == "--dead-jet-fraction" && hasValue ) opt.deadJetFraction = std::atof(argv[++ia]);
+     else if( arg == "--cosmics" && hasValue ) opt.cosmics = std::atof(argv[++ia]);
+     else if( arg == "--events-per-lumi" && hasValue ) opt.eventsPerLumi = std::strtoul(argv[++ia], 0, 10);
+     else if( arg[0] != '-' && outputName.empty() ) outputName = arg;
+     else { usage(argv[0]); return 1; }
+  }
+  if( outputName.empty() || opt.maskedScale < 0 || opt.pileup < 0 || opt.eventsPerLumi == 0 ){ usage(argv[0]); return 1; }
+
+  Random rnd(opt.seed);
+
+  std::vector<Crystal> crystals;
+  buildCrystals(crystals);
+
+  std::map<uint32_t, std::vector<unsigned int> > towerCrystals;
+  for(unsigned int ic=0; ic<crystals.size(); ic++) towerCrystals[crystals[ic].ttRawId].push_back(ic);
+  std::vector<uint32_t> allTowers;
+  for(std::map<uint32_t, std::vector<unsigned int> >::const_iterator it = towerCrystals.begin(); it != towerCrystals.end(); ++it) allTowers.push_back(it->first);
+
+  METFlagsReplayFixture fixture;
+  buildTable(opt, crystals, towerCrystals, rnd, fixture.table);
+
+  fixture.events.resize(opt.events);
+  unsigned long long nTPs = 0, nHits = 0, nJets = 0, nTracks = 0;
+  for(unsigned int ie=0; ie<opt.events; ie++){
+     METFlagsReplayEvent &evt = fixture.events[ie];
+     evt.run = 1;
+     evt.lumi = 1 + ie/opt.eventsPerLumi;
+     evt.event = ie + 1;
+
+     fillTPs(opt, fixture.table, allTowers, rnd, evt);
+     fillRecHits(opt, fixture.table, crystals, rnd, evt);
+     fillJetsAndMET(opt, fixture.table, rnd, evt);
+     fillCosmics(opt, rnd, evt);
+
+     nTPs += evt.tps.size(); nHits += evt.ebHits.size() + evt.eeHits.size();
+     nJets += evt.jets.size(); nTracks += evt.tracks.size();
+  }
+
+  if( !fixture.write(outputName) ){ fprintf(stderr, "%s\n", fixture.error().c_str()); return 2; }
+
+  const double nEvents = opt.events ? opt.events : 1;
+  printf("wrote %s : masked channels %u in %u towers, %u events, per event : TPs %.1f  rechits %.1f  jets %.1f  cosmic tracks %.2f\n",
+         outputName.c_str(), fixture.table.size(), (unsigned int)fixture.table.towers().size(), opt.events,
+         nTPs/nEvents, nHits/nEvents, nJets/nEvents, nTracks/nEvents);
+
+  return 0;
+}
@@ -1,129 +1,90 @@
 #ifndef CSC_HALO_FILTER_H
 #define CSC_HALO_FILTER_H
 
-#include "FWCore/Framework/interface/EDProducer.h"
-
-#include "DataFormats/Candidate/interface/CandidateFwd.h"
-#include "DataFormats/Candidate/interface/Candidate.h"
-#include "DataFormats/CLHEP/interface/AlgebraicObjects.h"
-#include "DataFormats/Common/interface/Handle.h"
-#include "DataFormats/Common/interface/View.h"
-#include "DataFormats/Common/interface/TriggerResults.h"
-#include "DataFormats/CSCDigi/interface/CSCCorrelatedLCTDigiCollection.h"
-#include "DataFormats/CSCDigi/interface/CSCWireDigi.h"
-#include "DataFormats/CSCDigi/interface/CSCWireDigiCollection.h"
-#include "DataFormats/CSCDigi/interface/CSCStripDigi.h"
-#include "DataFormats/CSCDigi/interface/CSCStripDigiCollection.h"
-#include "DataFormats/CSCDigi/interface/CSCComparatorDigi.h"
-#include "DataFormats/CSCDigi/interface/CSCComparatorDigiCollection.h"
-#include "DataFormats/CSCDigi/interface/CSCALCTDigi.h"
-#include "DataFormats/CSCDigi/interface/CSCALCTDigiCollection.h"
-#include "DataFormats/CSCRecHit/interface/CSCRecHit2D.h"
-#include "DataFormats/CSCRecHit/interface/CSCSegmentCollection.h"
-#include "DataFormats/CSCRecHit/interface/CSCRecHit2DCollection.h"
-#include "DataFormats/CSCRecHit/interface/CSCSegment.h"
+#include "FWCore/Framework/interface/one/EDProducer.h"
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/LuminosityBlock.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/ESHandle.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
 #include "DataFormats/DetId/interface/DetId.h"
-#include "DataFormats/GeometrySurface/interface/Cylinder.h"
-#include "DataFormats/GeometrySurface/interface/Plane.h"
-#include "DataFormats/GeometrySurface/interface/Cone.h"
+#include "DataFormats/GeometrySurface/interface/BoundPlane.h"
 #include "DataFormats/GeometryVector/interface/GlobalPoint.h"
-#include "DataFormats/GeometryVector/interface/GlobalVector.h"
 #include "DataFormats/GeometryVector/interface/LocalPoint.h"
-#include "DataFormats/GeometryVector/interface/LocalVector.h"
-#include "DataFormats/L1CSCTrackFinder/interface/L1CSCTrackCollection.h"
-#include "DataFormats/L1CSCTrackFinder/interface/L1CSCStatusDigiCollection.h"
-#include "DataFormats/L1GlobalMuonTrigger/interface/L1MuRegionalCand.h"
-#include "DataFormats/L1GlobalMuonTrigger/interface/L1MuGMTReadoutRecord.h"
-#include "DataFormats/L1GlobalMuonTrigger/interface/L1MuGMTReadoutCollection.h"
-#include "DataFormats/Math/interface/LorentzVector.h"
-#include "DataFormats/MuonDetId/interface/CSCIndexer.h"
+#include "DataFormats/MuonDetId/interface/MuonSubdetId.h"
 #include "DataFormats/MuonDetId/interface/CSCDetId.h"
-#include "DataFormats/MuonDetId/interface/RPCDetId.h"
-#include "DataFormats/MuonDetId/interface/DTWireId.h"
 #include "DataFormats/MuonReco/interface/MuonFwd.h"
 #include "DataFormats/MuonReco/interface/Muon.h"
-#include "DataFormats/RecoCandidate/interface/RecoCandidate.h"
-#include "DataFormats/TrackingRecHit/interface/RecSegment.h"
-#include "DataFormats/TrackerRecHit2D/interface/SiPixelRecHitCollection.h"
-#include "DataFormats/TrackerRecHit2D/interface/SiStripRecHit2DCollection.h"
-#include "DataFormats/TrackerRecHit2D/interface/SiStripMatchedRecHit2DCollection.h"
+#include "DataFormats/CSCDigi/interface/CSCALCTDigiCollection.h"
 #include "DataFormats/TrackReco/interface/TrackFwd.h"
 #include "DataFormats/TrackReco/interface/Track.h"
-#include "DataFormats/TrajectorySeed/interface/TrajectorySeedCollection.h"
-#include "FWCore/Framework/interface/Frameworkfwd.h"
-#include "FWCore/Framework/interface/EDAnalyzer.h"
-#include "FWCore/Framework/interface/Event.h"
-#include "FWCore/Framework/interface/MakerMacros.h"
-#include "FWCore/Framework/interface/EventSetup.h"
-#include "FWCore/Framework/interface/ESHandle.h"
-#include "FWCore/Common/interface/TriggerNames.h"
-#include "FWCore/MessageLogger/interface/MessageLogger.h"
-#include "FWCore/ParameterSet/interface/ParameterSet.h"
-#include "FWCore/PluginManager/interface/ModuleDef.h"
+#include "DataFormats/TrackReco/interface/TrackExtra.h"
+#include "DataFormats/TrackingRecHit/interface/TrackingRecHit.h"
 
-#include "Geometry/CommonDetUnit/interface/TrackingGeometry.h"
-#include "Geometry/CommonDetUnit/interface/GlobalTrackingGeometry.h"
 #include "Geometry/CommonDetUnit/interface/GeomDet.h"
 #include "Geometry/CSCGeometry/interface/CSCGeometry.h"
 #include "Geometry/CSCGeometry/interface/CSCChamber.h"
 #include "Geometry/CSCGeometry/interface/CSCLayer.h"
 #include "Geometry/CSCGeometry/interface/CSCLayerGeometry.h"
 #include "Geometry/Records/interface/MuonGeometryRecord.h"
-#include "L1Trigger/CSCTrackFinder/interface/CSCSectorReceiverLUT.h"
-#include "L1Trigger/CSCTrackFinder/interface/CSCSectorReceiverLUT.h"
-#include "L1Trigger/CSCCommonTrigger/interface/CSCTriggerGeometry.h"
-#include "MagneticField/Records/interface/IdealMagneticFieldRecord.h"
-#include "MagneticField/Engine/interface/MagneticField.h"
-
-#include "RecoMuon/TrackingTools/interface/MuonServiceProxy.h"
-#include "RecoMuon/TrackingTools/interface/MuonPatternRecoDumper.h"
-#include "RecoMuon/TransientTrackingRecHit/interface/MuonTransientTrackingRecHitBuilder.h"
-#include "RecoMuon/TransientTrackingRecHit/interface/MuonTransientTrackingRecHit.h"
-
-#include "TrackingTools/GeomPropagators/interface/Propagator.h"
-#include "TrackingTools/GeomPropagators/interface/AnalyticalPropagator.h"
-#include "TrackPropagation/SteppingHelixPropagator/interface/SteppingHelixPropagator.h"
-#include "TrackingTools/TransientTrack/interface/TransientTrack.h"
-#include "TrackingTools/Records/interface/TrackingComponentsRecord.h"
-#include "TrackingTools/TrackAssociator/interface/TrackDetectorAssociator.h"
 
 #include "DataFormats/METReco/interface/BeamHaloSummary.h"
-//Root Classes
-
-#include "TH1F.h"
-#include "TH2F.h"
-#include "TH1I.h"
-#include "TFile.h"
-#include "TDirectory.h"
-#include "TTree.h"
-#include "TStyle.h"
-#include "TCanvas.h"
-#include "TString.h"
-#include "TMath.h"
-#include "TLorentzVector.h"
-#include "TLegend.h"
+#include "DataFormats/METReco/interface/CSCHaloData.h"
+#include "MyAnalysis/METFlags/interface/CSCHaloTrackFeatures.h"
+#include "MyAnalysis/METFlags/interface/CSCHaloTrackAlgo.h"
+#include "MyAnalysis/METFlags/interface/CSCMuonExtrapolation.h"
+#include "MyAnalysis/METFlags/interface/METFlagsStats.h"
+#include "MyAnalysis/METFlags/interface/METFlagsSidecar.h"
+
 //Standard C++ classes
-#include <iostream>
 #include <string>
-#include <map>
 #include <vector>
-#include <utility>
-#include <ostream>
-#include <fstream>
+#include <memory>
 #include <algorithm>
 #include <cmath>
-#include <memory>
-#include <iomanip>
 
-class CSCHaloFlagProducer : public edm::EDProducer {
+class METFlagsSkipBitmapWriter;
+//only needed by the trigger-level and the full matching, included in the .cc
+class L1MuGMTReadoutCollection;
+class Propagator;
+class TrackingComponentsRecord;
+class TrackDetectorAssociator;
+class TrackAssociatorParameters;
+
+class CSCHaloFlagProducer : public edm::one::EDProducer<edm::one::WatchRuns, edm::one::WatchLuminosityBlocks, edm::EndRunProducer,
+                                                        edm::EndLuminosityBlockProducer, edm::one::WatchInputFiles> {
  public:
   
   explicit CSCHaloFlagProducer(const edm::ParameterSet & iConfig);
-  virtual ~CSCHaloFlagProducer();
+  ~CSCHaloFlagProducer() override;
   
  private:
   
-  virtual void produce(edm::Event & iEvent, const edm::EventSetup & iSetup);
+  void produce(edm::Event & iEvent, const edm::EventSetup & iSetup) override;
+  void endJob() override;
+  void beginRun(const edm::Run & iRun, const edm::EventSetup & iSetup) override;
+  void endRun(const edm::Run & iRun, const edm::EventSetup & iSetup) override;
+  void endRunProduce(edm::Run & iRun, const edm::EventSetup & iSetup) override;
+  void beginLuminosityBlock(const edm::LuminosityBlock & iLumi, const edm::EventSetup & iSetup) override;
+  void endLuminosityBlock(const edm::LuminosityBlock & iLumi, const edm::EventSetup & iSetup) override;
+  void endLuminosityBlockProduce(edm::LuminosityBlock & iLumi, const edm::EventSetup & iSetup) override;
+  void respondToOpenInputFile(const edm::FileBlock & fb) override;
+  void respondToCloseInputFile(const edm::FileBlock & fb) override;
+
+  //halo-to-collision-muon matching of the trigger and digi levels, see CollisionMuonMatching
+  void collisionMuonTracks(const reco::Muon & muon, std::vector<const reco::Track*> & tracks) const;
+  void fullCrossings(const edm::Event & iEvent, const edm::EventSetup & iSetup, const std::vector<const reco::Track*> & tracks,
+		     std::vector<CSCStationCrossing> & crossings);
+  int countHaloTriggers(const L1MuGMTReadoutCollection & readout, const std::vector<CSCStationCrossing> & fast,
+			const std::vector<CSCStationCrossing> & full);
+  int countHaloDigis(const CSCALCTDigiCollection & alcts, const CSCGeometry & geometry, const std::vector<CSCTrackState> & states,
+		     const std::vector<CSCStationCrossing> & full);
+  int wireGroupDistance(const CSCLayer & layer, int keyWireGroup, const CSCHitPosition & pos) const;
+  CSCHitPosition globalHitPosition(const CSCGeometry & geometry, const TrackingRecHit & hit) const;
 
   edm::InputTag IT_L1MuGMTReadout;
   edm::InputTag IT_ALCTDigi;
@@ -133,6 +94,18 @@ class CSCHaloFlagProducer : public edm::EDProducer {
   edm::InputTag IT_CSCSegment;
   edm::InputTag IT_CSCHaloData;
   edm::InputTag IT_BeamHaloSummary;
+
+  //inputs read by the configured filter levels only; tokens of the other inputs are left uninitialized
+  edm::EDGetTokenT<reco::BeamHaloSummary> beamHaloSummaryToken_;
+  edm::EDGetTokenT<reco::TrackCollection> saCosmicMuonToken_;
+  edm::EDGetTokenT<reco::CSCHaloData> cscHaloDataToken_;
+  edm::ESGetToken<CSCGeometry, MuonGeometryRecord> cscGeometryToken_;
+  edm::EDGetTokenT<reco::MuonCollection> collisionMuonToken_;
+  edm::EDGetTokenT<L1MuGMTReadoutCollection> l1MuGMTReadoutToken_;
+  edm::EDGetTokenT<CSCALCTDigiCollection> alctDigiToken_;
+  edm::ESGetToken<CSCGeometry, MuonGeometryRecord> stationPlanesGeometryToken_;
+  edm::ESGetToken<CSCGeometry, MuonGeometryRecord> layerZGeometryToken_;
+  edm::ESGetToken<Propagator, TrackingComponentsRecord> propagatorToken_;
   bool FilterCSCLoose;
   bool FilterCSCTight;
 
@@ -140,6 +113,9 @@ class CSCHaloFlagProducer : public edm::EDProducer {
   bool FilterTriggerLevel; //requires L1MuGMTReadoutCollection
   bool FilterRecoLevel;    //requires Cosmic reco::TrackCollection
 
+  //store one CSCHaloTrackFeatures record per cosmic SA track (instance "HaloTrackFeatures")
+  bool produceTrackFeatures;
+
   //min value of deta between innermost and outermost hit of cosmic reco::Track in CSCs
   float deta_threshold;  
   //max value of dphi between innermost and outermost hit of cosmic reco::Track in CSCs
@@ -161,6 +137,13 @@ class CSCHaloFlagProducer : public edm::EDProducer {
   //max value of dr/dz calculated using innermost and outermose rechit from cosmic reco::Track in CSCs
   float max_dr_over_dz;
 
+  //the reco-level cuts above, as used by passesHaloTrackCuts
+  CSCHaloTrackCuts haloTrackCuts;
+
+  //|z| of the CSC layers, filled at beginRun : the endpoints of the cosmic tracks are chosen
+  //from the layer of their rechits and only these two rechits are transformed to global
+  CSCLayerZTable layerZTable;
+
   //expected local BX number of ALCT Digi for collision induced LCTs (3 for Data, 6 for MC)
   int expected_BX;
 
@@ -171,12 +154,44 @@ class CSCHaloFlagProducer : public edm::EDProducer {
   //dwire window for matching collision muon hits to early ALCT Digis
   int matching_dwire_threshold; 
 
+  //veto of the L1 halo triggers and early ALCT digis caused by collision muons:
+  //  kNoMatching       : the counts of reco::CSCHaloData are used as they are
+  //  kFastMatching     : muon outer states extrapolated to the CSC stations by CSCMuonExtrapolator
+  //  kFullMatching     : TrackDetectorAssociator with the SteppingHelixPropagatorAny propagator
+  //  kValidateMatching : both, the associator decides and the agreement is reported at endJob
+  enum CollisionMuonMatching { kNoMatching = 0, kFastMatching, kFullMatching, kValidateMatching };
+  CollisionMuonMatching collisionMuonMatching;
+  CSCMuonExtrapolator fastExtrapolator;
+  CSCStationPlanes stationPlanes;
+  CSCMatchingAgreement matchingAgreement;
+  //made only for kFullMatching and kValidateMatching
+  std::unique_ptr<TrackDetectorAssociator> trackAssociator_;
+  std::unique_ptr<TrackAssociatorParameters> parameters_;
+
+  //per-event scratch of the matching, kept between events so that their storage is reused
+  std::vector<const reco::Track*> matchingTracks_;
+  std::vector<CSCTrackState> matchingStates_;
+  std::vector<CSCStationCrossing> matchingFast_, matchingFull_;
+
   int min_nHaloDigis;
   int min_nHaloTriggers;
   int min_nHaloTracks; 
   
-  TrackDetectorAssociator trackAssociator_;
-  TrackAssociatorParameters parameters_;
+  //processed and halo-tagged events of the current lumi and run, stored as lumi and run products
+  unsigned int lumiProcessedCnt, lumiTaggedCnt;
+  unsigned int runProcessedCnt, runTaggedCnt;
+
+  //stage timing and per-lumi counters, null unless enableStats
+  std::unique_ptr<METFlagsStats> stats_;
+  std::string statsFileName_;
+  METFlagsScratchWatch scratchWatch_;
+
+  //cached pass decisions, null unless sidecarInput or sidecarOutput. Only the ideal geometry is
+  //used, so the conditions hash is constant
+  std::unique_ptr<METFlagsSidecar> sidecar_;
+
+  //entry numbers of the halo-tagged events per input file, null unless skipBitmapDir
+  std::unique_ptr<METFlagsSkipBitmapWriter> skipBitmap_;
 
 
 
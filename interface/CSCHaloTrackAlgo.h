@@ -0,0 +1,103 @@
+#ifndef CSC_HALO_TRACK_ALGO_H
+#define CSC_HALO_TRACK_ALGO_H
+
+// Framework-free core of the reco-level CSC halo selection of CSCHaloFlagProducer:
+// innermost / outermost CSC rechit selection along a cosmic stand-alone track, the derived
+// CSCHaloTrackFeatures and the halo-like cuts applied on them.
+
+#include "MyAnalysis/METFlags/interface/CSCHaloTrackFeatures.h"
+
+#include <vector>
+
+struct CSCHitPosition {
+  float x, y, z;
+};
+
+// Same definitions as the GlobalPoint accessors
+float cscPointEta(const CSCHitPosition &p);
+float cscPointPhi(const CSCHitPosition &p);
+
+struct CSCHaloTrackCuts {
+  //min value of deta between innermost and outermost hit of cosmic reco::Track in CSCs
+  float deta_threshold;
+  //max value of dphi between innermost and outermost hit of cosmic reco::Track in CSCs
+  float dphi_threshold;
+  //min / max value of outer-momentum theta for cosmic reco::Track in CSCs
+  float min_outer_theta;
+  float max_outer_theta;
+  //min / max value of innermost constituent rechit radius for cosmic reco::Track in CSCs
+  float min_inner_radius;
+  float max_inner_radius;
+  //min / max value of outermost constituent rechit radius for cosmic reco::Track in CSCs
+  float min_outer_radius;
+  float max_outer_radius;
+  //threshold on chi2 of cosmic reco::Track in CSCs
+  float norm_chi2_threshold;
+  //max value of dr/dz calculated using innermost and outermose rechit from cosmic reco::Track in CSCs
+  float max_dr_over_dz;
+  //min number of CSC rechits on the track
+  int min_csc_hits;
+};
+
+// Keeps the CSC rechits with the smallest |z| (closest to the calorimetry) and the largest |z|.
+// Hits are either added with their global position, or as candidates known by their |z| and
+// index only : the positions of the two selected candidates are then set by setPositions
+class CSCTrackEndpoints {
+ public:
+  CSCTrackEndpoints() { reset(); }
+
+  void reset();
+  void add(const CSCHitPosition &hit);
+  void addCandidate(float absZ, int hitIndex);
+
+  int nHits() const { return nHits_; }
+  const CSCHitPosition& inner() const { return inner_; }
+  const CSCHitPosition& outer() const { return outer_; }
+
+  // Indices of the innermost and outermost candidates, -1 without candidate
+  int innerIndex() const { return innerIndex_; }
+  int outerIndex() const { return outerIndex_; }
+  void setPositions(const CSCHitPosition &inner, const CSCHitPosition &outer) { inner_ = inner; outer_ = outer; }
+
+ private:
+  float innermost_global_z, outermost_global_z;
+  CSCHitPosition inner_, outer_;
+  int innerIndex_, outerIndex_;
+  int nHits_;
+};
+
+// |z| of the CSC layers, indexed like CSCDetId : endcap 1-2, station 1-4, ring 1-4, chamber 1-36
+// and layer 1-6, layer 0 being the chamber itself. The layers are planes of constant z, so the
+// |z| of a rechit is the one of its layer
+class CSCLayerZTable {
+ public:
+  CSCLayerZTable() { clear(); }
+
+  void clear();
+  void setAbsZ(int endcap, int station, int ring, int chamber, int layer, float absZ);
+
+  // 0 for an unknown layer
+  float absZ(int endcap, int station, int ring, int chamber, int layer) const {
+    const int idx = index_(endcap, station, ring, chamber, layer);
+    return idx >= 0 ? absZ_[idx] : 0.;
+  }
+
+ private:
+  enum { kEndcaps = 2, kStations = 4, kRings = 4, kChambers = 36, kLayers = 7 };
+
+  static int index_(int endcap, int station, int ring, int chamber, int layer) {
+    if( endcap < 1 || endcap > kEndcaps || station < 1 || station > kStations || ring < 1 || ring > kRings
+        || chamber < 1 || chamber > kChambers || layer < 0 || layer >= kLayers ) return -1;
+    return ((((endcap-1)*kStations + station-1)*kRings + ring-1)*kChambers + chamber-1)*kLayers + layer;
+  }
+
+  std::vector<float> absZ_;
+};
+
+// Features of a track from its CSC endpoints; the kPassesHaloCuts flag is left unset
+CSCHaloTrackFeatures computeHaloTrackFeatures(const CSCTrackEndpoints &endpoints, float outerMomentumTheta, float normChi2);
+
+// Halo-like selection, in the order the cuts were historically applied
+bool passesHaloTrackCuts(const CSCHaloTrackFeatures &features, const CSCHaloTrackCuts &cuts);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef CSC_HALO_TRACK_FEATURES_H
+#define CSC_HALO_TRACK_FEATURES_H
+
+// Compact per-track record of the quantities the reco-level CSC halo cuts are applied on.
+// One record is stored per cosmic stand-alone muon track, in the order of the input collection,
+// so that any set of thresholds can be re-applied downstream without the track extras or the
+// CSC geometry.
+
+class CSCHaloTrackFeatures {
+ public:
+
+  enum Flags { kHasCSCEndpoints = 0x1, kPassesHaloCuts = 0x2 };
+
+  CSCHaloTrackFeatures() :
+    deta(0.), dphi(0.), theta(0.), innerR(0.), innerZ(0.), outerR(0.), outerZ(0.), normChi2(0.),
+    nCSCHits(0), flags(0) {}
+
+  //|eta| difference between outermost and innermost CSC rechit
+  float deta;
+  //phi difference between outermost and innermost CSC rechit, in [0, pi]
+  float dphi;
+  //theta of the outer momentum of the track
+  float theta;
+  //transverse radius and global z of the innermost (smallest |z|) CSC rechit
+  float innerR;
+  float innerZ;
+  //transverse radius and global z of the outermost (largest |z|) CSC rechit
+  float outerR;
+  float outerZ;
+  float normChi2;
+  //number of valid CSC rechits on the track
+  unsigned short nCSCHits;
+  unsigned short flags;
+
+  bool hasCSCEndpoints() const { return flags & kHasCSCEndpoints; }
+  bool passesHaloCuts() const { return flags & kPassesHaloCuts; }
+
+  float dr() const { return innerR > outerR ? innerR - outerR : outerR - innerR; }
+  float dz() const { return innerZ > outerZ ? innerZ - outerZ : outerZ - innerZ; }
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef CSC_MUON_EXTRAPOLATION_H
+#define CSC_MUON_EXTRAPOLATION_H
+
+// Fast extrapolation of collision muons to the CSC stations, used by the trigger- and digi-level
+// halo-to-muon matching of CSCHaloFlagProducer in place of TrackDetectorAssociator when
+// CollisionMuonMatching is "fast". In the endcap muon system the tracks are nearly straight at the
+// precision of the matching windows, so the outer state of the muon is carried to the cached z of
+// each (station, ring) on a straight line, or on a helix in a uniform effective Bz.
+// Framework-free: the producer fills the station planes from CSCGeometry at each run.
+
+#include "MyAnalysis/METFlags/interface/CSCHaloTrackAlgo.h"
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Global position (cm) and momentum (GeV) of a track state
+struct CSCTrackState {
+  float x, y, z;
+  float px, py, pz;
+  int charge;
+};
+
+// Crossing of a track with the chambers of one (endcap, station, ring); chamber is 0 when unknown
+struct CSCStationCrossing {
+  int track;
+  int endcap, station, ring, chamber;
+  CSCHitPosition pos;
+};
+
+// |z| and radial extent of the chambers of each (station, ring), the same in both endcaps up to
+// the sign of z. ME1/1a (ring 4) is part of the ME1/1 chambers and is not a plane of its own.
+class CSCStationPlanes {
+ public:
+
+  enum { kStations = 4, kRings = 3 };
+
+  CSCStationPlanes() { clear(); }
+
+  void clear();
+  // Adds the centre |z| of a chamber and the transverse radii it covers
+  void addChamber(int station, int ring, float absZ, float rMin, float rMax);
+
+  bool has(int station, int ring) const { return ring_(station, ring).n > 0; }
+  // Average |z| of the chambers of the ring
+  float absZ(int station, int ring) const;
+  float rMin(int station, int ring) const { return ring_(station, ring).rMin; }
+  float rMax(int station, int ring) const { return ring_(station, ring).rMax; }
+
+ private:
+
+  struct Ring {
+    double sumZ;
+    int n;
+    float rMin, rMax;
+  };
+
+  const Ring& ring_(int station, int ring) const { return rings_[station-1][ring-1]; }
+
+  Ring rings_[kStations][kRings];
+};
+
+class CSCMuonExtrapolator {
+ public:
+
+  enum Model { kStraightLine = 0, kHelix };
+
+  // bz is the effective field in Tesla between the state and the stations, used by kHelix only
+  explicit CSCMuonExtrapolator(Model model = kStraightLine, float bz = 0.) : model_(model), bz_(bz) {}
+
+  // "straightLine" or "helix"; false for any other name
+  static bool modelFromName(const std::string &name, Model &model);
+
+  Model model() const { return model_; }
+  float bz() const { return bz_; }
+
+  // Position of the track at global z, forwards or backwards from the state (the outer state of a
+  // muon is usually beyond the first stations); false when the track is parallel to the plane
+  bool toZ(const CSCTrackState &state, float z, CSCHitPosition &pos) const;
+
+  // Appends the crossings of the track with the rings on the side of the endcap its pz points to,
+  // in increasing station order; only the ring whose radial extent contains the crossing is kept
+  void crossings(const CSCTrackState &state, int track, const CSCStationPlanes &planes, std::vector<CSCStationCrossing> &out) const;
+
+ private:
+  Model model_;
+  float bz_;
+};
+
+// Smallest |deta| and smallest |dphi| (each on its own, as historically) between a point and a set
+// of positions; dphi is folded in [0, pi]
+struct CSCMatchDistance {
+  CSCMatchDistance() : deta(9999.), dphi(9999.) {}
+  void add(const CSCHitPosition &pos, float eta, float phi);
+  bool within(float detaMax, float dphiMax) const { return deta < detaMax && dphi < dphiMax; }
+  float deta, dphi;
+};
+
+// Agreement of the fast matching with TrackDetectorAssociator, filled when CollisionMuonMatching
+// is "validate": per level the matching decisions of both, per crossing found by both the eta and
+// phi residuals of the fast extrapolation
+class CSCMatchingAgreement {
+ public:
+
+  enum Level { kTrigger = 0, kDigi, kNLevels };
+
+  CSCMatchingAgreement();
+
+  void addDecision(Level level, bool fullMatched, bool fastMatched);
+  void addResidual(const CSCHitPosition &full, const CSCHitPosition &fast);
+
+  uint64_t decisions(Level level) const { return both_[level] + neither_[level] + fullOnly_[level] + fastOnly_[level]; }
+  uint64_t agreed(Level level) const { return both_[level] + neither_[level]; }
+  uint64_t fullOnly(Level level) const { return fullOnly_[level]; }
+  uint64_t fastOnly(Level level) const { return fastOnly_[level]; }
+  uint64_t residuals() const { return nResiduals_; }
+
+  // One line per level and one for the residuals (mean and max of |deta| and dphi, in 1e-3)
+  std::string summary() const;
+
+ private:
+  uint64_t both_[kNLevels], neither_[kNLevels], fullOnly_[kNLevels], fastOnly_[kNLevels];
+  uint64_t nResiduals_;
+  double sumDeta_, sumDphi_;
+  float maxDeta_, maxDphi_;
+};
+
+#endif
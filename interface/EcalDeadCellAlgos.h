@@ -0,0 +1,328 @@
+#ifndef ECAL_DEAD_CELL_ALGOS_H
+#define ECAL_DEAD_CELL_ALGOS_H
+
+// Framework-free cores of the ECAL dead-cell flags, shared by the producers and by the
+// standalone replay benchmark:
+//   selectDeadCellMethod     : TP or recovered rechit method of EcalDeadCellEventFlagProducer (loadEventInfoForFilter)
+//   evaluateDeadCellTP       : TP method of EcalDeadCellEventFlagProducer (setEvtTPstatus)
+//   EcalDeadTowerTPScale     : compressed Et to GeV of the dead towers, built once per run
+//   evaluateDeadCellTPCode   : evaluateDeadCellTP on compressed Et codes
+//   countDeadTowersTP        : number of dead towers above the TP cut, for the lumi summaries
+//   summarizeDeadTowersTP    : max dead tower Et per zside, for cuts applied downstream
+//   evaluateDeadCellTPEvent  : the three above on one event
+//   EcalDeadTowerEtSum       : recovered rechit method of EcalDeadCellEventFlagProducer (setEvtRecHitstatus)
+//   closestDeadChannel       : nearest masked channel of simpleDRFlagProducer (isCloseToBadEcalChannel)
+//   selectJetsCloseToMET     : jet-MET dphi selection of simpleDRFlagProducer (dPhiToMETfunc)
+//   FlagJetCrackLUT          : HB/HE and HE/HF crack bits of the jets of simpleDRFlagProducer (etaToBoundary)
+//   nearestDeadChannels      : nearest masked channel of every jet, for the jet ValueMaps of simpleDRFlagProducer
+//   SimpleDRStagePlan        : the checks of simpleDRFlagProducer in order on one event
+
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTable.h"
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+
+class METFlagsScratchWatch;
+
+// Same conventions as reco::deltaPhi / reco::deltaR
+inline double flagDeltaPhi(double phi1, double phi2){
+  double result = phi1 - phi2;
+  while( result > M_PI ) result -= 2*M_PI;
+  while( result <= -M_PI ) result += 2*M_PI;
+  return result;
+}
+
+inline double flagDeltaR(double eta1, double phi1, double eta2, double phi2){
+  const double deta = eta1 - eta2, dphi = flagDeltaPhi(phi1, phi2);
+  return std::sqrt(deta*deta + dphi*dphi);
+}
+
+// Kinematics of a selected jet; all the jet-based flags need
+struct FlagJet {
+  double pt, eta, phi;
+};
+
+// Method of the dead cell check. If TP is available, always use TP: a RECO file always has ecalTPSkim
+// (at least from 38X for data and 39X for MC). An AOD file only has recovered rechits in the
+// reduced rechit collections after 42X. releaseVersion is the CMSSW_X_Y_... release of the
+// process that made the input.
+enum EcalDeadCellMethod { kDeadCellTPMethod, kDeadCellHITMethod, kDeadCellNoInput, kDeadCellHITBefore42X };
+EcalDeadCellMethod selectDeadCellMethod(bool hasTPDigis, bool hasReducedRecHits, const std::string &releaseVersion);
+
+// TP method: for every masked channel of the selection (EE ones only if doEEfilter), look up the
+// TP of its tower and tag the event when the TP Et is >= etCut.
+// TPSource must provide  bool findEt(uint32_t ttRawId, double &et) const
+// Return value:  + : positive zside  - : negative zside  0 : not tagged
+// The zside is the one of the last channel reaching the cut, so the channels are searched from the
+// end and the search stops at the first one found.
+template<class TPSource>
+int evaluateDeadCellTP(const EcalDeadChannelTable &table, const EcalDeadChannelSelection &selection, const TPSource &tps, double etCut, bool doEEfilter){
+
+  const std::vector<unsigned int> &channels = selection.channels();
+  for(unsigned int ic=selection.nChannels(doEEfilter); ic-- > 0; ){
+
+     const EcalDeadChannelTable::Channel &chn = table.channels()[channels[ic]];
+
+     double tpEt = 0;
+     if( tps.findEt(chn.ttRawId, tpEt) && tpEt >= etCut ) return chn.zside;
+  }
+
+  return 0;
+}
+
+// GeV value of the 256 compressed TP Et codes of every tower of a dead channel table, and the
+// first code at or above an Et cut, so that the TP method compares integers per event instead of
+// converting every TP through the conditions. Codes of a tower whose scale does not increase
+// with the code around the cut are compared in GeV instead.
+class EcalDeadTowerTPScale {
+ public:
+
+  static const unsigned int nCodes = 256;
+
+  EcalDeadTowerTPScale() : etCut_(0) {}
+
+  // Fill with setEt for every tower and code, then setCut once
+  void reset(unsigned int nTowers);
+  void setEt(unsigned int tower, unsigned int code, double et) { et_[tower*nCodes + code] = et; }
+  void setCut(double etCut);
+
+  unsigned int nTowers() const { return threshold_.size(); }
+  double et(unsigned int tower, unsigned int code) const { return et_[tower*nCodes + (code & 0xFF)]; }
+
+  // First code whose Et reaches the cut, nCodes if none
+  unsigned int thresholdCode(unsigned int tower) const { return threshold_[tower]; }
+  bool passes(unsigned int tower, unsigned int code) const {
+    return monotonic_[tower] ? code >= threshold_[tower] : et(tower, code) >= etCut_;
+  }
+
+ private:
+
+  double etCut_;
+  std::vector<double> et_;
+  std::vector<unsigned int> threshold_;
+  std::vector<char> monotonic_;
+};
+
+// Same decision as evaluateDeadCellTP with the cut of scale.setCut()
+// TPCodeSource must provide  bool findCode(uint32_t ttRawId, unsigned int &code) const
+template<class TPCodeSource>
+int evaluateDeadCellTPCode(const EcalDeadChannelTable &table, const EcalDeadChannelSelection &selection, const EcalDeadTowerTPScale &scale, const TPCodeSource &tps, bool doEEfilter){
+
+  const std::vector<unsigned int> &channels = selection.channels();
+  for(unsigned int ic=selection.nChannels(doEEfilter); ic-- > 0; ){
+
+     const EcalDeadChannelTable::Channel &chn = table.channels()[channels[ic]];
+
+     unsigned int code = 0;
+     if( tps.findCode(chn.ttRawId, code) && scale.passes(chn.tower, code) ) return chn.zside;
+  }
+
+  return 0;
+}
+
+// Number of distinct towers with at least one channel that evaluateDeadCellTP would tag on.
+// Only worth calling for tagged events: it is zero otherwise.
+template<class TPSource>
+int countDeadTowersTP(const EcalDeadChannelTable &table, const EcalDeadChannelSelection &selection, const TPSource &tps, double etCut, bool doEEfilter){
+
+  int nTowers = 0;
+
+  const std::vector<unsigned int> &towers = selection.towers(doEEfilter);
+  for(unsigned int it=0; it<towers.size(); it++){
+     double tpEt = 0;
+     if( tps.findEt(table.towers()[towers[it]].rawId, tpEt) && tpEt >= etCut ) nTowers++;
+  }
+
+  return nTowers;
+}
+
+// Dead tower Et of an event before any cut: an event is tagged at a cut X > 0 by the TP or the
+// rechit method exactly when max(maxEtPlus, maxEtMinus) >= X, so a threshold can be changed
+// downstream without rerunning the producer.
+struct EcalDeadTowerEtSummary {
+  // 0 when there is no dead tower on that side
+  double maxEtPlus, maxEtMinus;
+  // towers with Et >= the floor given to addTower
+  int nAboveFloor;
+  // raw id of the tower with the largest Et (the first in raw id order on ties), 0 if none
+  uint32_t hottestRawId;
+  double hottestEt;
+
+  EcalDeadTowerEtSummary() { clear(); }
+
+  void clear() { maxEtPlus = maxEtMinus = 0; nAboveFloor = 0; hottestRawId = 0; hottestEt = 0; }
+
+  void addTower(uint32_t rawId, int zside, double et, double floor) {
+    double &maxEt = zside > 0 ? maxEtPlus : maxEtMinus;
+    if( et > maxEt ) maxEt = et;
+    if( et >= floor ) nAboveFloor++;
+    if( hottestRawId == 0 || et > hottestEt ){ hottestRawId = rawId; hottestEt = et; }
+  }
+};
+
+// Same towers as countDeadTowersTP, without cut
+template<class TPSource>
+void summarizeDeadTowersTP(const EcalDeadChannelTable &table, const EcalDeadChannelSelection &selection, const TPSource &tps, double floor, bool doEEfilter, EcalDeadTowerEtSummary &summary){
+
+  summary.clear();
+
+  const std::vector<unsigned int> &towers = selection.towers(doEEfilter);
+  for(unsigned int it=0; it<towers.size(); it++){
+     const EcalDeadChannelTable::Tower &tower = table.towers()[towers[it]];
+     double tpEt = 0;
+     if( tps.findEt(tower.rawId, tpEt) ) summary.addTower(tower.rawId, tower.zside, tpEt, floor);
+  }
+}
+
+// TP method on one event: the decision of evaluateDeadCellTPCode, the number of dead towers
+// reaching etCut (tagged events only, 0 otherwise) and, when summary is not null, the dead tower
+// Et summary with the floor. etCut must be the cut of scale.setCut().
+template<class TPSource>
+int evaluateDeadCellTPEvent(const EcalDeadChannelTable &table, const EcalDeadChannelSelection &selection, const EcalDeadTowerTPScale &scale, const TPSource &tps,
+                            double etCut, bool doEEfilter, int &nTowersAboveCut, double floor, EcalDeadTowerEtSummary *summary){
+
+  const int tagged = evaluateDeadCellTPCode(table, selection, scale, tps, doEEfilter);
+  nTowersAboveCut = tagged ? countDeadTowersTP(table, selection, tps, etCut, doEEfilter) : 0;
+  if( summary ) summarizeDeadTowersTP(table, selection, tps, floor, doEEfilter, *summary);
+
+  return tagged;
+}
+
+// Recovered rechit method: sum Et = E*sin(theta) of the recovered rechits of the masked channels of
+// the selection (EE ones only if doEEfilter) per trigger tower and tag the event when one tower
+// reaches the cut.
+class EcalDeadTowerEtSum {
+ public:
+
+  EcalDeadTowerEtSum() : table_(0), selection_(0), towerTest_(0), doEEfilter_(true) {}
+
+  void reset(const EcalDeadChannelTable &table, const EcalDeadChannelSelection &selection, int towerTest, bool doEEfilter);
+
+  // Returns -1 when the hit is not used, otherwise the number of crystals of its tower that
+  // do not pass towerTest (diagnostic, the original towerTestCnt)
+  int add(uint32_t rawId, double energy, bool isRecovered);
+  // add() of every rechit of [begin, end); the rechits provide id().rawId(), energy() and isRecovered()
+  template<class RecHitIterator>
+  void addHits(RecHitIterator begin, RecHitIterator end) {
+    for(RecHitIterator hit = begin; hit != end; ++hit) add(hit->id().rawId(), hit->energy(), hit->isRecovered());
+  }
+
+  // Return value:  + : positive zside  - : negative zside  0 : not tagged
+  int status(double etCut) const;
+  // Number of towers whose Et sum reaches the cut
+  int towersAboveCut(double etCut) const;
+  // Et sums of the touched towers, without cut
+  void summarize(double floor, EcalDeadTowerEtSummary &summary) const;
+  // status(etCut), the number of towers reaching it (tagged events only, 0 otherwise) and, when
+  // summary is not null, the summary with the floor
+  int evaluate(double etCut, int &nTowersAboveCut, double floor, EcalDeadTowerEtSummary *summary) const;
+
+  // Towers that received at least one hit, sorted by raw id, and their content
+  const std::vector<unsigned int>& touchedTowers() const;
+  double towerEt(unsigned int tower) const { return towerEt_[tower]; }
+  int towerChannelCount(unsigned int tower) const { return towerChn_[tower]; }
+
+  // The arrays kept between events, for the allocation count of METFlagsStats
+  void watchScratch(METFlagsScratchWatch &watch) const;
+
+ private:
+
+  const EcalDeadChannelTable *table_;
+  const EcalDeadChannelSelection *selection_;
+  int towerTest_;
+  bool doEEfilter_;
+
+  std::vector<double> towerEt_;
+  std::vector<int> towerChn_;
+  std::vector<int> towerTestCnt_;
+  std::vector<char> channelSeen_;
+  std::vector<unsigned int> seen_;
+  mutable std::vector<unsigned int> touched_;
+  mutable bool touchedSorted_;
+};
+
+// Nearest masked channel of the selection to (eta, phi). Returns its position in the table and
+// sets minDist, or returns -1 (minDist = 999) when the selection is empty.
+int closestDeadChannel(const EcalDeadChannelTable &table, const EcalDeadChannelSelection &selection, double eta, double phi, double &minDist);
+
+// Keep the jets within dPhiCutVal of the MET direction; returns the number of kept jets
+int selectJetsCloseToMET(const std::vector<FlagJet> &jets, double metPhi, double dPhiCutVal, std::vector<FlagJet> &closeToMETjets);
+
+// Crack membership by |eta| bin: a bin entirely inside a crack (lo < |eta| < hi) holds its bit,
+// only the bins holding a crack edge compare |eta| to the edges.
+// Status of a jet list: bits 2i (HB/HE) and 2i+1 (HE/HF) for jet i < maxJets, kOverflow when a
+// later jet is in a crack; 0 when no jet is.
+class FlagJetCrackLUT {
+ public:
+
+  enum { kHBHE = 1, kHEHF = 2 };
+  static const unsigned int maxJets = 15;
+  static const int kOverflow = 1 << 30;
+
+  FlagJetCrackLUT() : binWidth_(0.01), maxAbsEta_(0) {}
+
+  void build(double hbheLo, double hbheHi, double hehfLo, double hehfHi);
+
+  unsigned int crackBits(double eta) const {
+    const double absEta = std::abs(eta);
+    if( !(absEta < maxAbsEta_) ) return 0;
+    const unsigned int bin = std::min((unsigned int)(absEta/binWidth_), (unsigned int)bits_.size() - 1);
+    return edgeBin_[bin] ? exactBits(absEta) : bits_[bin];
+  }
+
+  int status(const std::vector<FlagJet> &jets) const;
+
+ private:
+
+  unsigned int exactBits(double absEta) const {
+    return ( absEta > lo_[0] && absEta < hi_[0] ? kHBHE : 0 ) | ( absEta > lo_[1] && absEta < hi_[1] ? kHEHF : 0 );
+  }
+
+  double binWidth_, maxAbsEta_;
+  double lo_[2], hi_[2];
+  std::vector<unsigned char> bits_, edgeBin_;
+};
+
+// Nearest masked channel of the selection to every jet: its dR, status and tower raw id, or 999,
+// -1 and 0 when the selection is empty. The vectors are resized to the number of jets.
+void nearestDeadChannels(const EcalDeadChannelTable &table, const EcalDeadChannelSelection &selection, const std::vector<FlagJet> &jets,
+                         std::vector<float> &dRs, std::vector<int> &statuses, std::vector<unsigned int> &towers);
+
+// Checks of simpleDRFlagProducer as a plan of stages built once from the configuration: the jet
+// selection (pt > ptCut, |eta| < absEtaCut) and the jet-MET dphi cut narrow the jet list, then
+// the dead cell dR check and, with doCracks, the crack check compute their status on the jets
+// left. The plan stops as soon as no jet is left. The jet lists are kept between events so that
+// their storage is reused.
+class SimpleDRStagePlan {
+ public:
+
+  enum Stage { kSelectJets, kDPhiToMET, kDeadCell, kCracks };
+
+  SimpleDRStagePlan() : jetPtCut_(-1), jetAbsEtaCut_(9999), dPhiToMET_(0), dRtoDeadCell_(0) {}
+
+  void build(double jetPtCut, double jetAbsEtaCut, double dPhiToMET, double dRtoDeadCell, bool doCracks,
+             double hbheLo, double hbheHi, double hehfLo, double hehfHi);
+
+  const std::vector<Stage>& stages() const { return stages_; }
+
+  // Statuses of one event, 0 when nothing is found. dPhiToMETstatus is the number of selected
+  // jets close to the MET (diagnostic only), deadCellStatus the number of those close to a masked
+  // channel of the selection, boundaryStatus their crack bits (FlagJetCrackLUT::status)
+  void run(const std::vector<FlagJet> &jets, double metPhi, const EcalDeadChannelTable &table, const EcalDeadChannelSelection &selection,
+           int &dPhiToMETstatus, int &deadCellStatus, int &boundaryStatus);
+
+  // The jet lists kept between events, for the allocation count of METFlagsStats
+  void watchScratch(METFlagsScratchWatch &watch) const;
+
+ private:
+
+  std::vector<Stage> stages_;
+  double jetPtCut_, jetAbsEtaCut_, dPhiToMET_, dRtoDeadCell_;
+  FlagJetCrackLUT crackLUT_;
+  std::vector<FlagJet> stageJets_, keptJets_;
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef ECAL_DEAD_CHANNEL_TABLE_H
+#define ECAL_DEAD_CHANNEL_TABLE_H
+
+// Framework-free table of the masked ECAL channels of a run and of the trigger towers containing
+// them. Replaces the DetId-keyed maps (values, bits and tower) the flag producers used to keep:
+// channels are stored sorted by raw DetId, each one pointing to its tower, and towers are stored
+// sorted by raw EcalTrigTowerDetId with the list of their masked channels.
+// The table only deals with raw ids so that it can be filled from the conditions in a job or
+// from a replay fixture in a standalone executable.
+
+#include <vector>
+#include <cstdlib>
+#include <stdint.h>
+
+class EcalDeadChannelTable {
+ public:
+
+  struct Channel {
+    uint32_t rawId;
+    uint32_t ttRawId;
+    // 1 : EB, 2 : EE
+    int subdet;
+    // EB : (ieta, iphi, 0)   EE : (ix, iy, iz)
+    int ix, iy, iz;
+    int status;
+    double eta, phi, theta;
+    // zside of the trigger tower and position of the tower in towers()
+    int zside;
+    unsigned int tower;
+  };
+
+  struct Tower {
+    uint32_t rawId;
+    int zside;
+    // number of crystals in the tower (masked or not)
+    int nConstituents;
+    // positions in channels() of the masked crystals of the tower
+    std::vector<unsigned int> channels;
+  };
+
+  EcalDeadChannelTable() : maskedStatusThreshold_(0), statusMask_(0) {}
+
+  void clear();
+
+  // Fill with addChannel, then finalize() once to sort and link channels and towers
+  void addChannel(const Channel &channel);
+  void finalize();
+
+  // Removes the channels of removedRawIds, adds the ones of added and relinks the towers; the
+  // constituent counts of the towers already known are kept, new towers have 0
+  void update(const std::vector<uint32_t> &removedRawIds, const std::vector<Channel> &added);
+
+  void setTowerConstituents(unsigned int tower, int nConstituents) { towers_[tower].nConstituents = nConstituents; }
+
+  const std::vector<Channel>& channels() const { return channels_; }
+  const std::vector<Tower>& towers() const { return towers_; }
+
+  unsigned int size() const { return channels_.size(); }
+  bool empty() const { return channels_.empty(); }
+
+  // Position of a channel / tower, -1 if it is not masked
+  int channelIndex(uint32_t rawId) const;
+  int towerIndex(uint32_t ttRawId) const;
+
+  // chnStatus > 0, then exclusive, i.e., only consider status == chnStatus
+  // chnStatus < 0, then inclusive, i.e., consider status >= abs(chnStatus)
+  static bool statusSelected(int status, int chnStatus) {
+    if( chnStatus >0 ) return status == chnStatus;
+    if( chnStatus <0 ) return status >= std::abs(chnStatus);
+    return false;
+  }
+
+  // Number of crystals of a tower that do NOT pass the towerTest status selection
+  int towerTestCount(unsigned int tower, int towerTest) const;
+
+  // Channel selection the table was filled with : (statusCode & statusMask) >= maskedStatusThreshold
+  void setSelection(int maskedStatusThreshold, unsigned int statusMask) { maskedStatusThreshold_ = maskedStatusThreshold; statusMask_ = statusMask; }
+  int maskedStatusThreshold() const { return maskedStatusThreshold_; }
+  unsigned int statusMask() const { return statusMask_; }
+
+  // Hash of the masked channels, their status and the tower constituent counts: equal tables
+  // give equal hashes, whatever IOV they come from
+  uint64_t contentHash() const;
+
+ private:
+
+  std::vector<Channel> channels_;
+  std::vector<Tower> towers_;
+  int maskedStatusThreshold_;
+  unsigned int statusMask_;
+};
+
+// Channels and towers of a table passing one status selector (statusSelected), with the EB ones
+// apart, for the per-event loops of the flags. Built once per run for each selector a module uses,
+// and again whenever the table changes. Both lists keep the order of the table, where the EB
+// channels come before the EE ones (the towers of EB and EE are interleaved).
+class EcalDeadChannelSelection {
+ public:
+
+  EcalDeadChannelSelection() : chnStatus_(0), nEBChannels_(0) {}
+
+  void build(const EcalDeadChannelTable &table, int chnStatus);
+
+  int chnStatus() const { return chnStatus_; }
+
+  // Positions in table.channels() of the selected channels : the first nChannels(false) are the EB ones
+  const std::vector<unsigned int>& channels() const { return channels_; }
+  unsigned int nChannels(bool includeEE) const { return includeEE ? channels_.size() : nEBChannels_; }
+
+  // Positions in table.towers() of the towers with at least one selected channel, in EB and EE or in EB only
+  const std::vector<unsigned int>& towers(bool includeEE) const { return includeEE ? towers_ : ebTowers_; }
+
+  // Whether the channel at position ic of table.channels() is selected
+  bool selected(unsigned int ic) const { return selected_[ic]; }
+
+ private:
+
+  int chnStatus_;
+  std::vector<unsigned int> channels_;
+  unsigned int nEBChannels_;
+  std::vector<unsigned int> towers_, ebTowers_;
+  std::vector<char> selected_;
+};
+
+#endif
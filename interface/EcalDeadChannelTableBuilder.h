@@ -0,0 +1,71 @@
+#ifndef ECAL_DEAD_CHANNEL_TABLE_BUILDER_H
+#define ECAL_DEAD_CHANNEL_TABLE_BUILDER_H
+
+// Fills an EcalDeadChannelTable from the ECAL channel status conditions, the calorimeter
+// geometry and the trigger tower map, for the channels with
+//   (statusCode & statusMask) >= maskedEcalChannelStatusThreshold
+// refer https://twiki.cern.ch/twiki/bin/viewauth/CMS/EcalChannelStatus
+// Only the status items are scanned; the geometry is only queried for the masked channels.
+//
+// The builder remembers the selected status of every crystal, so that the table of the next
+// status payload can be obtained by update(), which only looks up the geometry of the channels
+// that became masked.
+
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTable.h"
+
+#include "CondFormats/EcalObjects/interface/EcalChannelStatus.h"
+#include "Geometry/CaloGeometry/interface/CaloGeometry.h"
+#include "Geometry/CaloTopology/interface/EcalTrigTowerConstituentsMap.h"
+
+#include <vector>
+
+class EcalDeadChannelTableBuilder {
+ public:
+
+  // Channels of the table changed by the last build() or update()
+  struct Diff {
+    bool full;
+    unsigned int added, removed, statusChanged;
+  };
+
+  EcalDeadChannelTableBuilder(int maskedEcalChannelStatusThreshold, unsigned int statusMask) :
+    maskedEcalChannelStatusThreshold_(maskedEcalChannelStatusThreshold), statusMask_(statusMask), built_(false) {
+    diff_.full = false; diff_.added = diff_.removed = diff_.statusChanged = 0;
+  }
+
+  void build(const EcalChannelStatus &ecalStatus, const CaloGeometry &geometry, const EcalTrigTowerConstituentsMap &ttMap,
+             EcalDeadChannelTable &table);
+
+  // Applies the changes of ecalStatus since the last build() or update() to table, which must be
+  // the table they filled. Does a build() when there was none or after reset().
+  void update(const EcalChannelStatus &ecalStatus, const CaloGeometry &geometry, const EcalTrigTowerConstituentsMap &ttMap,
+              EcalDeadChannelTable &table);
+
+  // The next update() is a full build, e.g. when the geometry changed
+  void reset() { built_ = false; }
+
+  const Diff& diff() const { return diff_; }
+
+  int maskedEcalChannelStatusThreshold() const { return maskedEcalChannelStatusThreshold_; }
+  unsigned int statusMask() const { return statusMask_; }
+
+ private:
+
+  // Status of a status item if selected, -1 otherwise
+  int selectedStatus(const EcalChannelStatusCode &item) const {
+    const int status = item.getStatusCode() & statusMask_;
+    return status >= maskedEcalChannelStatusThreshold_ ? status : -1;
+  }
+
+  void setTowerConstituents(const EcalTrigTowerConstituentsMap &ttMap, EcalDeadChannelTable &table) const;
+
+  int maskedEcalChannelStatusThreshold_;
+  unsigned int statusMask_;
+
+// Selected status per hashed index of the last build() or update()
+  bool built_;
+  std::vector<int> ebStatus_, eeStatus_;
+  Diff diff_;
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef ECAL_DEAD_CHANNEL_TABLE_RCD_H
+#define ECAL_DEAD_CHANNEL_TABLE_RCD_H
+
+// EventSetup record of the EcalDeadChannelTable made by EcalDeadChannelTableESProducer. Its IOV
+// changes with the ECAL channel status, the calorimeter geometry or the trigger tower map.
+
+#include "FWCore/Framework/interface/DependentRecordImplementation.h"
+#include "FWCore/Utilities/interface/mplVector.h"
+#include "CondFormats/DataRecord/interface/EcalChannelStatusRcd.h"
+#include "Geometry/Records/interface/CaloGeometryRecord.h"
+#include "Geometry/Records/interface/IdealGeometryRecord.h"
+
+class EcalDeadChannelTableRcd : public edm::eventsetup::DependentRecordImplementation<EcalDeadChannelTableRcd,
+  edm::mpl::Vector<EcalChannelStatusRcd, CaloGeometryRecord, IdealGeometryRecord> > {};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef MET_FLAGS_ENTRY_BITMAP_H
+#define MET_FLAGS_ENTRY_BITMAP_H
+
+// Compressed set of the entry numbers of the tagged events of one input file, so that a skim can
+// skip them by entry number without reading the events.
+// Roaring-style: entries are grouped by their upper bits (key = entry >> 16) and the low 16 bits of
+// each group are kept either as a sorted array (up to kArrayMax values, 2 bytes per entry) or as a
+// 65536-bit bitmap (8 kB), whichever is smaller. Tagged events are rare, so almost all groups are
+// arrays. The file also carries the GUID and the number of entries of the input file, so that a
+// bitmap is never applied to another file. See METFlagsEntryBitmap.cc for the layout.
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+class METFlagsEntryBitmap {
+ public:
+
+  static const uint32_t formatVersion = 1;
+  static const unsigned int kArrayMax = 4096;
+
+  METFlagsEntryBitmap() : cardinality_(0) {}
+
+  void clear() { containers_.clear(); cardinality_ = 0; }
+
+  // Entries normally come in increasing order, which is the fast path
+  void add(uint64_t entry);
+  bool contains(uint64_t entry) const;
+
+  uint64_t cardinality() const { return cardinality_; }
+  bool empty() const { return cardinality_ == 0; }
+
+  // All entries, in increasing order
+  void entries(std::vector<uint64_t> &out) const;
+
+  // Serialized size in bytes, without the header
+  uint64_t sizeInBytes() const;
+
+  // guid and nEntries describe the input file the entry numbers refer to
+  bool write(const std::string &fileName, const std::string &guid, uint64_t nEntries) const;
+  bool read(const std::string &fileName, std::string &guid, uint64_t &nEntries);
+
+  const std::string& error() const { return error_; }
+
+ private:
+
+  struct Container {
+    uint64_t key;
+    uint32_t cardinality;
+    // One of the two is used: array while cardinality <= kArrayMax, bits (1024 words) above
+    std::vector<uint16_t> array;
+    std::vector<uint64_t> bits;
+
+    bool isBitmap() const { return !bits.empty(); }
+    bool operator<(const Container &other) const { return key < other.key; }
+  };
+
+  Container& container(uint64_t key);
+  const Container* findContainer(uint64_t key) const;
+
+  std::vector<Container> containers_;
+  uint64_t cardinality_;
+  mutable std::string error_;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef MET_FLAGS_REPLAY_FIXTURE_H
+#define MET_FLAGS_REPLAY_FIXTURE_H
+
+// Recorded inputs of the MET flag algorithms, to replay them outside of a framework job:
+// the dead channel table of one run plus, per event, the TP digis, the reduced rechits, the jets,
+// the MET and the CSC rechit positions of the cosmic stand-alone tracks.
+// Written by the METFlagsFixtureRecorder module or by metFlagsSyntheticFixture, and read by the
+// replay benchmark. The file is a flat little-endian binary stream, see METFlagsReplayFixture.cc.
+
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTable.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadCellAlgos.h"
+#include "MyAnalysis/METFlags/interface/CSCHaloTrackAlgo.h"
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+struct ReplayTP {
+  uint32_t ttRawId;
+  uint16_t compressedEt;
+  // Et in GeV from the TPG scale of the recorded run
+  float et;
+
+  bool operator<(const ReplayTP &other) const { return ttRawId < other.ttRawId; }
+};
+
+struct ReplayRecHit {
+  uint32_t rawId;
+  float energy;
+  bool isRecovered;
+};
+
+struct ReplayCosmicTrack {
+  float outerMomentumTheta;
+  float normChi2;
+  std::vector<CSCHitPosition> hits;
+};
+
+struct METFlagsReplayEvent {
+  uint32_t run, lumi;
+  uint64_t event;
+  // sorted by tower raw id
+  std::vector<ReplayTP> tps;
+  std::vector<ReplayRecHit> ebHits, eeHits;
+  std::vector<FlagJet> jets;
+  float metPt, metPhi;
+  std::vector<ReplayCosmicTrack> tracks;
+};
+
+// TPSource of evaluateDeadCellTP over the recorded TPs
+class ReplayTPSource {
+ public:
+  explicit ReplayTPSource(const std::vector<ReplayTP> &tps) : tps_(tps) {}
+
+  bool findEt(uint32_t ttRawId, double &et) const {
+    ReplayTP key; key.ttRawId = ttRawId;
+    std::vector<ReplayTP>::const_iterator it = std::lower_bound(tps_.begin(), tps_.end(), key);
+    if( it == tps_.end() || it->ttRawId != ttRawId ) return false;
+    et = it->et;
+    return true;
+  }
+
+ private:
+  const std::vector<ReplayTP> &tps_;
+};
+
+class METFlagsReplayFixture {
+ public:
+
+  static const uint32_t formatVersion = 1;
+
+  EcalDeadChannelTable table;
+  std::vector<METFlagsReplayEvent> events;
+
+  // Both return false on I/O or format errors; error() then describes the problem
+  bool write(const std::string &fileName) const;
+  bool read(const std::string &fileName);
+
+  const std::string& error() const { return error_; }
+
+ private:
+  mutable std::string error_;
+};
+
+#endif
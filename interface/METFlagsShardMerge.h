@@ -0,0 +1,85 @@
+#ifndef MET_FLAGS_SHARD_MERGE_H
+#define MET_FLAGS_SHARD_MERGE_H
+
+// Merge of the outputs of a sharded flag reprocessing (METFlagsShardWriter files and the profile
+// trees of EcalDeadCellEventFlagProducer) into the output of the equivalent serial job.
+// Framework- and ROOT-free; the I/O is done by bin/metFlagsMergeShards.cpp.
+//
+// The result does not depend on how the lumis were split nor on the order the shards are added:
+//   events  : sorted by (fileIndex, run, lumi, seq), the order of the serial job
+//   lumis   : sorted by (run, lumi), the summaries of a lumi seen by several shards (or several
+//             times, when it spans input files) are summed
+//   runs    : sorted by run, the bitword layout must agree between shards
+//   profile : rows in the order of their event in the merged events, unknown events last in
+//             (run, lumi, event) order
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+struct METFlagsShardEvent {
+  uint32_t run, lumi;
+  uint64_t event, bitword;
+  uint32_t fileIndex, seq;
+
+  bool operator<(const METFlagsShardEvent &other) const {
+    if( fileIndex != other.fileIndex ) return fileIndex < other.fileIndex;
+    if( run != other.run ) return run < other.run;
+    if( lumi != other.lumi ) return lumi < other.lumi;
+    return seq < other.seq;
+  }
+};
+
+struct METFlagsShardRun {
+  uint32_t tableVersion;
+  std::vector<std::string> flagNames;
+};
+
+// One row of the "filter" profile tree of EcalDeadCellEventFlagProducer (event is stored on 32 bits)
+struct METFlagsProfileRow {
+  uint32_t run, lumi, event;
+  std::vector<int> cutFlowFlag;
+  std::vector<std::string> cutFlowStr;
+};
+
+class METFlagsShardMerger {
+ public:
+
+  typedef std::pair<uint32_t, uint32_t> LumiKey;
+
+  METFlagsShardMerger() : summaryNamesSet_(false) {}
+
+  // Each returns false and sets error() when the shard contradicts the ones already added
+  bool setSummaryNames(const std::vector<std::string> &names);
+  void addEvent(const METFlagsShardEvent &evt) { events_.push_back(evt); }
+  bool addLumi(uint32_t run, uint32_t lumi, const std::vector<uint32_t> &values);
+  bool addRun(uint32_t run, const METFlagsShardRun &info);
+  void addProfileRow(const METFlagsProfileRow &row) { profile_.push_back(row); }
+
+  // Orders everything; false when two shards wrote the same event (overlapping lumi ranges)
+  bool finalize();
+
+  const std::vector<std::string>& summaryNames() const { return summaryNames_; }
+  const std::vector<METFlagsShardEvent>& events() const { return events_; }
+  const std::map<LumiKey, std::vector<uint32_t> >& lumis() const { return lumis_; }
+  const std::map<uint32_t, METFlagsShardRun>& runs() const { return runs_; }
+  const std::vector<METFlagsProfileRow>& profileRows() const { return profile_; }
+
+  // Hash of the merged content, to compare a sharded and a serial job
+  uint64_t digest() const;
+
+  const std::string& error() const { return error_; }
+
+ private:
+
+  std::vector<std::string> summaryNames_;
+  bool summaryNamesSet_;
+  std::vector<METFlagsShardEvent> events_;
+  std::map<LumiKey, std::vector<uint32_t> > lumis_;
+  std::map<uint32_t, METFlagsShardRun> runs_;
+  std::vector<METFlagsProfileRow> profile_;
+  std::string error_;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef MET_FLAGS_SIDECAR_H
+#define MET_FLAGS_SIDECAR_H
+
+// Persistent cache of the per-event decisions of a flag producer, so that reprocessing the same
+// events with the same configuration and conditions loads the decision instead of recomputing it.
+//
+// A sidecar file holds the hash of the module configuration, one conditions hash per run and the
+// records sorted by (run, lumi, event), each with two ints whose meaning belongs to the producer.
+// A record is only used when the configuration hash of the file and the conditions hash of its
+// run both match the current ones. The file is memory-mapped; lookups bisect a block index (the
+// first key of every block of records), then the block itself. See METFlagsSidecar.cc for the layout.
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+// FNV-1a, to build the configuration and conditions hashes
+uint64_t metFlagsHash(const void *data, std::size_t size, uint64_t hash = 14695981039346656037ULL);
+inline uint64_t metFlagsHash(const std::string &str, uint64_t hash = 14695981039346656037ULL) { return metFlagsHash(str.data(), str.size(), hash); }
+template<class T> uint64_t metFlagsHashValue(const T &value, uint64_t hash = 14695981039346656037ULL) { return metFlagsHash(&value, sizeof(T), hash); }
+
+struct METFlagsSidecarRecord {
+  uint32_t run, lumi;
+  uint64_t event;
+  int32_t value, aux;
+
+  bool operator<(const METFlagsSidecarRecord &other) const {
+    if( run != other.run ) return run < other.run;
+    if( lumi != other.lumi ) return lumi < other.lumi;
+    return event < other.event;
+  }
+};
+
+class METFlagsSidecar {
+ public:
+
+  static const uint32_t formatVersion = 1;
+  static const uint32_t blockSize = 256;
+
+  // Either name may be empty: no lookups / nothing written. They may be the same file: the
+  // still valid records of the input are carried over into the output.
+  METFlagsSidecar(const std::string &inputName, const std::string &outputName, uint64_t configHash);
+  ~METFlagsSidecar();
+
+  // False (and error() set) when the input exists but can not be used; lookups then always miss
+  bool inputValid() const { return inputValid_; }
+  const std::string& error() const { return error_; }
+
+  // Conditions of a run, before its first lookup or record
+  void beginRun(uint32_t run, uint64_t conditionsHash);
+
+  bool lookup(uint32_t run, uint32_t lumi, uint64_t event, int32_t &value, int32_t &aux) const;
+  void record(uint32_t run, uint32_t lumi, uint64_t event, int32_t value, int32_t aux);
+
+  // Writes the output (through a temporary file and a rename); false and error() set on failure
+  bool write();
+
+  unsigned int hits() const { return hits_; }
+  unsigned int misses() const { return misses_; }
+
+ private:
+
+  struct RunConditions {
+    uint32_t run, reserved;
+    uint64_t hash;
+    bool operator<(const RunConditions &other) const { return run < other.run; }
+  };
+
+  bool openInput(const std::string &fileName);
+  bool inputRunMatches(uint32_t run) const;
+
+  std::string outputName_;
+  uint64_t configHash_;
+
+// Input mapping
+  bool inputValid_;
+  void *map_;
+  std::size_t mapSize_;
+  const RunConditions *inRuns_;
+  uint32_t nInRuns_;
+  const METFlagsSidecarRecord *inRecords_;
+  uint64_t nInRecords_;
+  const METFlagsSidecarRecord *inBlockKeys_;
+  uint64_t nInBlocks_;
+
+// Conditions of the current run, and whether the input agrees with them
+  uint32_t currentRun_;
+  bool currentRunValid_;
+
+  std::vector<RunConditions> runs_;
+  std::vector<METFlagsSidecarRecord> records_;
+
+  mutable unsigned int hits_, misses_;
+  std::string error_;
+
+  METFlagsSidecar(const METFlagsSidecar&);
+  METFlagsSidecar& operator=(const METFlagsSidecar&);
+};
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef MET_FLAGS_STATS_H
+#define MET_FLAGS_STATS_H
+
+// Timing and counter instrumentation shared by the flag producers of the package.
+// A producer owns one METFlagsStats when its untracked "enableStats" parameter is set and a null
+// pointer otherwise, so that a disabled module pays one pointer test per stage and per event.
+// Building with -DMETFLAGS_NO_STATS removes even that: the timers below become empty.
+//
+// Each thread accumulates into its own block (per-stage tick counts and calls, a fixed-bucket
+// histogram of the per-event latency, processed/tagged counts per lumi); writeSummary() merges
+// the blocks and writes one JSON object, which the producers do at endJob.
+// Ticks are TSC cycles on x86 and nanoseconds of the monotonic clock elsewhere, see tickUnit().
+// A producer that watches its reused buffers with a METFlagsScratchWatch also gets the number of
+// their reallocations per event in the summary.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+#include <stdint.h>
+#include <pthread.h>
+
+#if !defined(METFLAGS_NO_STATS) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#else
+#include <ctime>
+#endif
+
+class METFlagsStats {
+ public:
+
+  enum Stage { kLoad = 0, kMethodSelect, kTPScan, kHITScan, kDRSearch, kCosmicLoop, kRuleMatch, kSidecar, kMuonMatching, kNStages };
+
+// Latency bucket i counts the events with 2^(i-1) <= ticks < 2^i, the last one everything above
+  static const unsigned int kNLatencyBuckets = 40;
+
+  explicit METFlagsStats(const std::string &moduleLabel);
+  ~METFlagsStats();
+
+  static uint64_t ticks() {
+#if !defined(METFLAGS_NO_STATS) && (defined(__x86_64__) || defined(__i386__))
+    return __rdtsc();
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec)*1000000000ULL + ts.tv_nsec;
+#endif
+  }
+  static const char* tickUnit();
+  static const char* stageName(Stage stage);
+
+  void addStage(Stage stage, uint64_t ticks);
+  void addEvent(unsigned int run, unsigned int lumi, bool tagged, uint64_t latencyTicks);
+  void addScratchAllocations(unsigned int allocations);
+
+  void writeSummary(std::ostream &out) const;
+  // false if the file can not be written
+  bool writeSummary(const std::string &fileName) const;
+
+ private:
+
+  struct LumiCounts {
+    LumiCounts() : processed(0), tagged(0) {}
+    uint64_t processed, tagged;
+  };
+
+  struct Block {
+    Block();
+    uint64_t stageTicks[kNStages], stageCalls[kNStages];
+    uint64_t latency[kNLatencyBuckets];
+    uint64_t scratchEvents, scratchAllocations;
+    std::map<std::pair<unsigned int, unsigned int>, LumiCounts> lumis;
+  };
+
+  Block& local();
+
+  std::string moduleLabel_;
+
+  pthread_key_t key_;
+  mutable pthread_mutex_t mutex_;
+  std::vector<Block*> blocks_;
+
+  METFlagsStats(const METFlagsStats&);
+  METFlagsStats& operator=(const METFlagsStats&);
+};
+
+// Reallocations of the buffers a producer keeps between events: a watched vector whose capacity
+// changed since the previous count() counts as one allocation (one growing twice in an event counts
+// once). The products and the framework allocations are not seen, the replay benchmark counts those.
+// Two vectors whose storage is swapped are watched as a pair, by the sum of their capacities.
+class METFlagsScratchWatch {
+ public:
+  template<class T>
+  void watch(const std::vector<T> &buffer) { watch(buffer, buffer, false); }
+  template<class T>
+  void watch(const std::vector<T> &buffer, const std::vector<T> &swapped) { watch(buffer, swapped, true); }
+  unsigned int count();
+
+ private:
+  struct Buffer {
+    const void *buffer, *swapped;
+    size_t (*capacity)(const void *, const void *);
+    size_t last;
+  };
+  template<class T>
+  void watch(const std::vector<T> &buffer, const std::vector<T> &swapped, bool pair) {
+    Buffer watched = { &buffer, pair ? &swapped : 0, &capacityOf<T>, 0 };
+    watched.last = watched.capacity(watched.buffer, watched.swapped);
+    buffers_.push_back(watched);
+  }
+  template<class T>
+  static size_t capacityOf(const void *buffer, const void *swapped) {
+    return static_cast<const std::vector<T>*>(buffer)->capacity() + ( swapped ? static_cast<const std::vector<T>*>(swapped)->capacity() : 0 );
+  }
+
+  std::vector<Buffer> buffers_;
+};
+
+// Adds the ticks spent between construction and destruction to a stage; no-op for a null stats
+class METFlagsStageTimer {
+ public:
+#ifndef METFLAGS_NO_STATS
+  METFlagsStageTimer(METFlagsStats *stats, METFlagsStats::Stage stage) : stats_(stats), stage_(stage), start_(stats ? METFlagsStats::ticks() : 0) {}
+  ~METFlagsStageTimer() { stop(); }
+  // Ends the stage before the end of the scope
+  void stop() { if( stats_ ) stats_->addStage(stage_, METFlagsStats::ticks() - start_); stats_ = 0; }
+ private:
+  METFlagsStats *stats_;
+  METFlagsStats::Stage stage_;
+  uint64_t start_;
+#else
+  METFlagsStageTimer(METFlagsStats *, METFlagsStats::Stage) {}
+  void stop() {}
+#endif
+};
+
+// Per-event latency and lumi counts: construct at the start of the event, call done() at the end.
+// With a scratch watch, done() also adds the reallocations of the event.
+class METFlagsEventTimer {
+ public:
+#ifndef METFLAGS_NO_STATS
+  explicit METFlagsEventTimer(METFlagsStats *stats, METFlagsScratchWatch *scratch = 0) : stats_(stats), scratch_(scratch), start_(stats ? METFlagsStats::ticks() : 0) {}
+  void done(unsigned int run, unsigned int lumi, bool tagged) {
+    if( !stats_ ) return;
+    stats_->addEvent(run, lumi, tagged, METFlagsStats::ticks() - start_);
+    if( scratch_ ) stats_->addScratchAllocations(scratch_->count());
+  }
+ private:
+  METFlagsStats *stats_;
+  METFlagsScratchWatch *scratch_;
+  uint64_t start_;
+#else
+  explicit METFlagsEventTimer(METFlagsStats *, METFlagsScratchWatch * = 0) {}
+  void done(unsigned int, unsigned int, bool) {}
+#endif
+};
+
+#endif
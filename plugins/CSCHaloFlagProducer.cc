@@ -0,0 +1,838 @@
+#include "MyAnalysis/METFlags/interface/CSCHaloFlagProducer.h"
+#include "DataFormats/Common/interface/Handle.h"
+#include "DataFormats/Common/interface/View.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/Framework/interface/FileBlock.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include "DataFormats/L1GlobalMuonTrigger/interface/L1MuRegionalCand.h"
+#include "DataFormats/L1GlobalMuonTrigger/interface/L1MuGMTReadoutCollection.h"
+#include "TrackingTools/GeomPropagators/interface/Propagator.h"
+#include "TrackingTools/Records/interface/TrackingComponentsRecord.h"
+#include "TrackingTools/TrackAssociator/interface/TrackDetectorAssociator.h"
+#include "TrackingTools/TrackAssociator/interface/TrackAssociatorParameters.h"
+#include "MyAnalysis/METFlags/plugins/METFlagsSkipBitmapWriter.h"
+
+using namespace std;
+using namespace edm;
+using namespace reco;
+CSCHaloFlagProducer::CSCHaloFlagProducer(const edm::ParameterSet & iConfig)
+{
+  IT_L1MuGMTReadout = iConfig.getParameter<edm::InputTag>("L1MuGMTReadoutLabel");
+  IT_ALCTDigi = iConfig.getParameter<edm::InputTag>("ALCTDigiLabel");
+  IT_CollisionMuon = iConfig.getParameter<edm::InputTag>("CollisionMuonLabel");
+  IT_SACosmicMuon = iConfig.getParameter<edm::InputTag>("SACosmicMuonLabel");
+  IT_CSCRecHit = iConfig.getParameter<edm::InputTag>("CSCRecHitLabel");
+  IT_CSCSegment = iConfig.getParameter<edm::InputTag>("CSCSegmentLabel");
+  IT_CSCHaloData = iConfig.getParameter<edm::InputTag>("CSCHaloDataLabel");
+  IT_BeamHaloSummary = iConfig.getParameter<edm::InputTag>("BeamHaloSummaryLabel");
+
+
+  deta_threshold = (float) iConfig.getParameter<double>("Deta");
+  dphi_threshold = (float) iConfig.getParameter<double>("Dphi");
+  min_inner_radius = (float) iConfig.getParameter<double>("InnerRMin");
+  max_inner_radius = (float) iConfig.getParameter<double>("InnerRMax");
+  min_outer_radius = (float) iConfig.getParameter<double>("OuterRMin");
+  max_outer_radius = (float) iConfig.getParameter<double>("OuterRMax");
+  norm_chi2_threshold = (float) iConfig.getParameter<double>("NormChi2");
+  min_outer_theta = (float)iConfig.getParameter<double>("MinOuterMomentumTheta");
+  max_outer_theta = (float)iConfig.getParameter<double>("MaxOuterMomentumTheta");
+  max_dr_over_dz = (float)iConfig.getParameter<double>("MaxDROverDz");
+
+  haloTrackCuts.deta_threshold = deta_threshold;
+  haloTrackCuts.dphi_threshold = dphi_threshold;
+  haloTrackCuts.min_outer_theta = min_outer_theta;
+  haloTrackCuts.max_outer_theta = max_outer_theta;
+  haloTrackCuts.min_inner_radius = min_inner_radius;
+  haloTrackCuts.max_inner_radius = max_inner_radius;
+  haloTrackCuts.min_outer_radius = min_outer_radius;
+  haloTrackCuts.max_outer_radius = max_outer_radius;
+  haloTrackCuts.norm_chi2_threshold = norm_chi2_threshold;
+  haloTrackCuts.max_dr_over_dz = max_dr_over_dz;
+  haloTrackCuts.min_csc_hits = 3;
+ 
+  expected_BX  = (short int) iConfig.getParameter<int>("ExpectedBX") ; 
+  
+  matching_dphi_threshold =  (float)iConfig.getParameter<double>("MatchingDPhiThreshold");
+  matching_deta_threshold =  (float)iConfig.getParameter<double>("MatchingDEtaThreshold");
+  matching_dwire_threshold  = iConfig.getParameter<int>("MatchingDWireThreshold");
+
+  FilterCSCLoose = iConfig.getParameter<bool>("FilterCSCLoose");
+  FilterCSCTight = iConfig.getParameter<bool>("FilterCSCTight");
+
+  FilterTriggerLevel = iConfig.getParameter<bool>("FilterTriggerLevel");
+  FilterDigiLevel = iConfig.getParameter<bool>("FilterDigiLevel");
+  FilterRecoLevel = iConfig.getParameter<bool>("FilterRecoLevel");
+
+  min_nHaloTriggers = FilterTriggerLevel ? iConfig.getUntrackedParameter<int>("MinNumberOfHaloTriggers",1) : 99999;
+  min_nHaloDigis    = FilterDigiLevel ?  iConfig.getUntrackedParameter<int>("MinNumberOfOutOfTimeDigis",1) : 99999;
+  min_nHaloTracks   = FilterRecoLevel ?  iConfig.getUntrackedParameter<int>("MinNumberOfHaloTracks",1) : 99999;
+
+  produceTrackFeatures = iConfig.getUntrackedParameter<bool>("ProduceTrackFeatures",false);
+
+  const std::string matching = iConfig.getUntrackedParameter<std::string>("CollisionMuonMatching","none");
+  if( matching == "none" ) collisionMuonMatching = kNoMatching;
+  else if( matching == "fast" ) collisionMuonMatching = kFastMatching;
+  else if( matching == "full" ) collisionMuonMatching = kFullMatching;
+  else if( matching == "validate" ) collisionMuonMatching = kValidateMatching;
+  else
+    throw cms::Exception("Configuration") << "CSCHaloFlagProducer : unknown CollisionMuonMatching \"" << matching
+					  << "\", expected none, fast, full or validate";
+  //the matching only vetoes trigger and digi candidates
+  if( !FilterTriggerLevel && !FilterDigiLevel )
+    collisionMuonMatching = kNoMatching;
+
+  const std::string fastModel = iConfig.getUntrackedParameter<std::string>("FastMatchingModel","straightLine");
+  const float fastBz = (float)iConfig.getUntrackedParameter<double>("FastMatchingBz",0.);
+  CSCMuonExtrapolator::Model model;
+  if( !CSCMuonExtrapolator::modelFromName(fastModel, model) )
+    throw cms::Exception("Configuration") << "CSCHaloFlagProducer : unknown FastMatchingModel \"" << fastModel << "\", expected straightLine or helix";
+  fastExtrapolator = CSCMuonExtrapolator(model, fastBz);
+
+  // Only the inputs of the configured levels are declared, so nothing else is prefetched
+  if( FilterCSCLoose || FilterCSCTight )
+    beamHaloSummaryToken_ = consumes<reco::BeamHaloSummary>(IT_BeamHaloSummary);
+  if( FilterRecoLevel || produceTrackFeatures )
+    {
+      saCosmicMuonToken_ = consumes<reco::TrackCollection>(IT_SACosmicMuon);
+      layerZGeometryToken_ = esConsumes<CSCGeometry, MuonGeometryRecord, edm::Transition::BeginRun>();
+    }
+  if( FilterRecoLevel || produceTrackFeatures || ( collisionMuonMatching != kNoMatching && FilterDigiLevel ) )
+    cscGeometryToken_ = esConsumes<CSCGeometry, MuonGeometryRecord>();
+  if( FilterDigiLevel || FilterTriggerLevel )
+    cscHaloDataToken_ = consumes<reco::CSCHaloData>(IT_CSCHaloData);
+  if( collisionMuonMatching != kNoMatching )
+    {
+      collisionMuonToken_ = consumes<reco::MuonCollection>(IT_CollisionMuon);
+      if( FilterTriggerLevel )
+	l1MuGMTReadoutToken_ = consumes<L1MuGMTReadoutCollection>(IT_L1MuGMTReadout);
+      if( FilterDigiLevel )
+	alctDigiToken_ = consumes<CSCALCTDigiCollection>(IT_ALCTDigi);
+      if( collisionMuonMatching != kFullMatching )
+	stationPlanesGeometryToken_ = esConsumes<CSCGeometry, MuonGeometryRecord, edm::Transition::BeginRun>();
+      if( collisionMuonMatching != kFastMatching )
+	{
+	  edm::ConsumesCollector iC = consumesCollector();
+	  trackAssociator_.reset( new TrackDetectorAssociator() );
+	  parameters_.reset( new TrackAssociatorParameters() );
+	  parameters_->loadParameters( iConfig.getParameter<edm::ParameterSet>("TrackAssociatorParameters"), iC );
+	  propagatorToken_ = esConsumes<Propagator, TrackingComponentsRecord>(edm::ESInputTag("", "SteppingHelixPropagatorAny"));
+	}
+    }
+
+  if( iConfig.getUntrackedParameter<bool>("enableStats",false) )
+    {
+      const std::string label = iConfig.getParameter<std::string>("@module_label");
+      stats_.reset( new METFlagsStats(label) );
+      statsFileName_ = iConfig.getUntrackedParameter<std::string>("statsFileName", label + "_stats.json");
+      scratchWatch_.watch( matchingTracks_ );
+      scratchWatch_.watch( matchingStates_ );
+      scratchWatch_.watch( matchingFast_ );
+      scratchWatch_.watch( matchingFull_ );
+    }
+
+  const std::string sidecarInput = iConfig.getUntrackedParameter<std::string>("sidecarInput","");
+  const std::string sidecarOutput = iConfig.getUntrackedParameter<std::string>("sidecarOutput","");
+  if( !sidecarInput.empty() || !sidecarOutput.empty() )
+    {
+      //the matching parameters are untracked : they are added to the hash when they change the decisions
+      uint64_t configHash = metFlagsHash(iConfig.id().compactForm());
+      if( collisionMuonMatching == kFastMatching )
+	configHash = metFlagsHashValue(fastBz, metFlagsHash(matching + fastModel, configHash));
+      else if( collisionMuonMatching != kNoMatching )
+	configHash = metFlagsHash(std::string("full"), configHash);
+      sidecar_.reset( new METFlagsSidecar(sidecarInput, sidecarOutput, configHash) );
+      if( !sidecar_->error().empty() )
+	LogWarning("CSCHaloFlagProducer") << "Sidecar input not used : " << sidecar_->error();
+      if( produceTrackFeatures && !sidecarInput.empty() )
+	LogWarning("CSCHaloFlagProducer") << "ProduceTrackFeatures is on : the sidecar decisions are not reused";
+    }
+
+  const std::string skipBitmapDir = iConfig.getUntrackedParameter<std::string>("skipBitmapDir","");
+  if( !skipBitmapDir.empty() )
+    skipBitmap_.reset( new METFlagsSkipBitmapWriter(skipBitmapDir, iConfig.getParameter<std::string>("@module_label")) );
+
+  lumiProcessedCnt = lumiTaggedCnt = runProcessedCnt = runTaggedCnt = 0;
+
+  produces<bool>();
+  produces<unsigned int, edm::Transition::EndLuminosityBlock>("lumiProcessed");
+  produces<unsigned int, edm::Transition::EndLuminosityBlock>("lumiTagged");
+  produces<unsigned int, edm::Transition::EndRun>("runProcessed");
+  produces<unsigned int, edm::Transition::EndRun>("runTagged");
+  if( produceTrackFeatures )
+    produces<std::vector<CSCHaloTrackFeatures> >("HaloTrackFeatures");
+}
+
+
+CSCHaloFlagProducer::~CSCHaloFlagProducer(){}
+
+void CSCHaloFlagProducer::produce(edm::Event & iEvent, const edm::EventSetup & iSetup) 
+{
+  METFlagsEventTimer evtTimer( stats_.get(), &scratchWatch_ );
+
+  bool pass=false;
+
+  if( sidecar_.get() && !produceTrackFeatures )
+    {
+      METFlagsStageTimer sidecarTimer( stats_.get(), METFlagsStats::kSidecar );
+      int32_t value = 0, aux = 0;
+      if( sidecar_->lookup(iEvent.id().run(), iEvent.luminosityBlock(), iEvent.id().event(), value, aux) )
+	{
+	  sidecarTimer.stop();
+	  pass = value;
+	  lumiProcessedCnt++; runProcessedCnt++;
+	  if( !pass ) { lumiTaggedCnt++; runTaggedCnt++; }
+	  if( skipBitmap_.get() ) skipBitmap_->tag( iEvent.id(), !pass );
+	  std::unique_ptr<bool> pOut( new bool(pass) );
+	  iEvent.put( std::move(pOut) );
+	  evtTimer.done( iEvent.id().run(), iEvent.luminosityBlock(), !pass );
+	  return;
+	}
+    }
+
+  if( FilterCSCLoose || FilterCSCTight ) 
+    {
+      edm::Handle<BeamHaloSummary> TheBeamHaloSummary;
+      iEvent.getByToken(beamHaloSummaryToken_,TheBeamHaloSummary);
+
+      const BeamHaloSummary & TheSummary = (*TheBeamHaloSummary.product() );
+      
+      if( FilterCSCLoose ) 
+	pass = !TheSummary.CSCLooseHaloId();
+      else 
+	pass = !TheSummary.CSCTightHaloId();
+    }
+  
+
+  METFlagsStageTimer loadTimer( stats_.get(), METFlagsStats::kLoad );
+
+  //Get CSC Geometry and Cosmic Stand-Alone Muons
+  edm::ESHandle<CSCGeometry> TheCSCGeometry;
+  edm::Handle<reco::TrackCollection> TheSACosmicMuons;
+  if( FilterRecoLevel || produceTrackFeatures )
+    {
+      TheCSCGeometry = iSetup.getHandle(cscGeometryToken_);
+      iEvent.getByToken( saCosmicMuonToken_, TheSACosmicMuons);
+    }
+
+  //Get CSC Segments
+  //edm::Handle<CSCSegmentCollection> TheCSCSegments;
+  //iEvent.getByLabel(IT_CSCSegment, TheCSCSegments);
+  
+  //Get CSC RecHits
+  //Handle<CSCRecHit2DCollection> TheCSCRecHits;
+  //iEvent.getByLabel(IT_CSCRecHit, TheCSCRecHits);
+  
+  edm::Handle<reco::CSCHaloData> TheCSCDataHandle;
+  if( FilterDigiLevel || FilterTriggerLevel )
+    iEvent.getByToken(cscHaloDataToken_,TheCSCDataHandle);
+
+
+  int nHaloCands  = 0;
+  int nHaloDigis  = 0;
+  int nHaloTracks = 0;
+
+  if(TheCSCDataHandle.isValid())                                                                                                                        
+    {                                                                                                                                                     
+      const reco::CSCHaloData & CSCData = (*TheCSCDataHandle.product());                                                                                    
+      nHaloDigis = CSCData.NumberOfOutOfTimeTriggers() ;                                                                                                    
+      nHaloCands = CSCData.NumberOfHaloTriggers();
+    }      
+
+  loadTimer.stop();
+
+  //veto the halo triggers and early digis of reco::CSCHaloData that a collision muon explains
+  if( collisionMuonMatching != kNoMatching )
+    {
+      METFlagsStageTimer matchingTimer( stats_.get(), METFlagsStats::kMuonMatching );
+
+      edm::Handle<reco::MuonCollection> TheCollisionMuons;
+      iEvent.getByToken(collisionMuonToken_, TheCollisionMuons);
+
+      //outer states of the collision muon tracks and their CSC crossings, from the fast
+      //extrapolation and/or the associator
+      std::vector<CSCTrackState> & states = matchingStates_;
+      std::vector<CSCStationCrossing> & fast = matchingFast_;
+      std::vector<CSCStationCrossing> & full = matchingFull_;
+      states.clear(); fast.clear(); full.clear();
+      if( TheCollisionMuons.isValid() )
+	{
+	  std::vector<const reco::Track*> & tracks = matchingTracks_;
+	  tracks.clear();
+	  for( reco::MuonCollection::const_iterator iMuon = TheCollisionMuons->begin(); iMuon != TheCollisionMuons->end(); iMuon++ )
+	    collisionMuonTracks( *iMuon, tracks );
+
+	  if( collisionMuonMatching != kFullMatching )
+	    for( unsigned int it = 0; it < tracks.size(); it++ )
+	      {
+		const reco::Track & track = *tracks[it];
+		CSCTrackState state = { (float)track.outerX(), (float)track.outerY(), (float)track.outerZ(),
+					(float)track.outerPx(), (float)track.outerPy(), (float)track.outerPz(), track.charge() };
+		states.push_back( state );
+		fastExtrapolator.crossings( state, it, stationPlanes, fast );
+	      }
+	  if( collisionMuonMatching != kFastMatching )
+	    fullCrossings( iEvent, iSetup, tracks, full );
+
+	  if( collisionMuonMatching == kValidateMatching )
+	    for( unsigned int ic = 0; ic < full.size(); ic++ )
+	      for( unsigned int jc = 0; jc < fast.size(); jc++ )
+		if( fast[jc].track == full[ic].track && fast[jc].endcap == full[ic].endcap && fast[jc].station == full[ic].station
+		    && fast[jc].ring == full[ic].ring )
+		  matchingAgreement.addResidual( full[ic].pos, fast[jc].pos );
+	}
+      else
+	LogWarning("Collection Not Found") << "You have requested the collision muon matching, but the collision muon collection does not appear"
+					   << " to be in the event! No halo candidate will be vetoed";
+
+      if( FilterTriggerLevel )
+	{
+	  edm::Handle<L1MuGMTReadoutCollection> TheL1GMTReadout;
+	  iEvent.getByToken(l1MuGMTReadoutToken_, TheL1GMTReadout);
+	  if( TheL1GMTReadout.isValid() )
+	    nHaloCands = countHaloTriggers( *TheL1GMTReadout, fast, full );
+	  else
+	    LogWarning("Collection Not Found") << "You have requested the collision muon matching, but the L1MuGMTReadoutCollection does not appear"
+					       << " to be in the event! The halo triggers of CSCHaloData are used";
+	}
+
+      if( FilterDigiLevel )
+	{
+	  edm::Handle<CSCALCTDigiCollection> TheALCTs;
+	  iEvent.getByToken(alctDigiToken_, TheALCTs);
+	  if( TheALCTs.isValid() )
+	    nHaloDigis = countHaloDigis( *TheALCTs, iSetup.getData(cscGeometryToken_), states, full );
+	  else
+	    LogWarning("Collection Not Found") << "You have requested the collision muon matching, but the CSCALCTDigiCollection does not appear"
+					       << " to be in the event! The out of time triggers of CSCHaloData are used";
+	}
+    }
+
+
+  /*
+  if( FilterTriggerLevel )
+    {
+      //Get L1MuGMT 
+      edm::Handle < L1MuGMTReadoutCollection > TheL1GMTReadout ;
+      iEvent.getByLabel (IT_L1MuGMTReadout, TheL1GMTReadout);
+      if( TheL1GMTReadout.isValid() )
+	{
+	  L1MuGMTReadoutCollection const *MuGMT = TheL1GMTReadout.product ();
+	  std::vector < L1MuGMTReadoutRecord > TheRecords = MuGMT->getRecords ();
+	  std::vector < L1MuGMTReadoutRecord >::const_iterator iRecord;
+	  for (iRecord = TheRecords.begin (); iRecord != TheRecords.end (); iRecord++)
+	    {
+	      std::vector < L1MuRegionalCand >::const_iterator iCand;
+	      std::vector < L1MuRegionalCand > TheCands = iRecord->getCSCCands ();
+	      for (iCand = TheCands.begin (); iCand != TheCands.end (); iCand++)
+		{
+		  if (!(*iCand).empty ())
+		    {
+		      if ((*iCand).isFineHalo ())
+			{
+			  float halophi = iCand->phiValue();
+			  float haloeta = iCand->etaValue();
+			  halophi = halophi > TMath::Pi() ? halophi - 2.*TMath::Pi() : halophi;
+			  bool CandIsHalo = true;
+			  // Check if halo trigger is faked by any collision muons
+
+			  if( TheCollisionMuons.isValid() )
+			    {
+			      float dphi = 9999.;
+			      float deta = 9999.;
+			      for( reco::MuonCollection::const_iterator iMuon = TheCollisionMuons->begin(); iMuon != TheCollisionMuons->end() && CandIsHalo ; iMuon++ )
+				{
+				  std::vector<TrackDetMatchInfo> info;
+				  if( iMuon->isTrackerMuon() && !iMuon->innerTrack().isNull() )
+				    info.push_back( trackAssociator_.associate(iEvent, iSetup, *iMuon->innerTrack(), parameters_) );
+				  if( iMuon->isStandAloneMuon() && !iMuon->outerTrack().isNull() )
+				    {
+				      //make sure that this SA muon is not actually a halo-like muon
+                                      float theta =  iMuon->outerTrack()->outerMomentum().theta();
+                                      float deta = TMath::Abs(iMuon->outerTrack()->outerPosition().eta() - iMuon->outerTrack()->innerPosition().eta());
+                                      
+				      if( !( theta < min_outer_theta || theta > max_outer_theta) )  //halo-like                        
+					if ( deta <= deta_threshold ) //halo-like               	
+					  {
+					    if( iMuon->isGlobalMuon() || iMuon->isTrackerMuon() ) // NOT SA-Only 
+					      info.push_back( trackAssociator_.associate(iEvent, iSetup, *iMuon->outerTrack(), parameters_) );
+					  }
+				    }
+				  if ( iMuon->isGlobalMuon() && !iMuon->globalTrack().isNull() )
+				    info.push_back(trackAssociator_.associate(iEvent, iSetup, *iMuon->globalTrack(), parameters_) );
+				  
+				  for(unsigned int i = 0 ; i < info.size(); i++ )
+				    {
+				      for( std::vector<TAMuonChamberMatch>::const_iterator chamber=info[i].chambers.begin();
+					   chamber!=info[i].chambers.end(); chamber++ ){
+					if( chamber->detector() != MuonSubdetId::CSC ) continue;
+					  
+					  for( std::vector<TAMuonSegmentMatch>::const_iterator segment = chamber->segments.begin();
+					       segment != chamber->segments.end(); segment++ ) {
+
+					    float eta_ = segment->segmentGlobalPosition.eta();	
+					    float phi_ = segment->segmentGlobalPosition.phi();	
+					    float test_dphi = TMath::Abs(phi_ - halophi);
+					    test_dphi = TMath::ACos( TMath::Cos( test_dphi ) );
+					    float test_deta = TMath::Abs(eta_ - haloeta);
+					    dphi = dphi < test_dphi ? dphi : test_dphi;
+					    deta = deta < test_deta ? deta : test_deta;
+					  }
+				      }
+				    }
+				  if ( dphi < matching_dphi_threshold && deta < matching_deta_threshold ) //collision likely caused it
+				    CandIsHalo = false; 
+				}
+			    }
+			  if(CandIsHalo)
+			    nHaloCands++;
+			}
+		    }
+		}
+	    }
+	}
+      else
+	{
+	  LogWarning("Collection Not Found") << "You have requested Trigger-level filtering, but the L1MuGMTReadoutCollection does not appear"
+					     << "to be in the event! Trigger-level filtering will be disabled" ;
+
+	  FilterTriggerLevel = false;  //NO TRIGGER DECISION CAN BE MADE
+	}
+    }
+
+  if(FilterDigiLevel)
+    {
+      //Get Chamber Anode Trigger Information                                                                                                                      
+      edm::Handle<CSCALCTDigiCollection> TheALCTs;
+   iEvent.getByLabel (IT_ALCTDigi, TheALCTs);
+      if(TheALCTs.isValid())
+	{
+	  for (CSCALCTDigiCollection::DigiRangeIterator j=TheALCTs->begin(); j!=TheALCTs->end(); j++)
+	    {
+	      const CSCALCTDigiCollection::Range& range =(*j).second;
+	      CSCDetId detId((*j).first.rawId());
+	      for (CSCALCTDigiCollection::const_iterator digiIt = range.first; digiIt!=range.second; ++digiIt)
+		{
+		  if( (*digiIt).isValid() && ( (*digiIt).getBX() < expected_BX ) )
+		    {
+		      bool DigiIsHalo = true;
+		      // MATCHING CHECK NOT AVAILABLE UNTIL 36X 
+			 
+		      int digi_endcap  = detId.endcap();
+		      int digi_station = detId.station();
+		      int digi_ring    = detId.ring();
+		      int digi_chamber = detId.chamber();
+		      int digi_wire    = digiIt->getKeyWG();
+		      
+		      if( digi_station == 1 && digi_ring == 4 )   //hack
+		      digi_ring = 1;
+		      
+		      int dwire = 999.;
+		      if( TheCollisionMuons.isValid() ) 
+		      {
+		      for( reco::MuonCollection::const_iterator iMuon = TheCollisionMuons->begin(); iMuon != TheCollisionMuons->end() && DigiIsHalo ; iMuon++ )
+		      {
+		      
+		      std::vector<TrackDetMatchInfo> info;
+		      if( iMuon->isTrackerMuon() && !iMuon->innerTrack().isNull() )
+		      info.push_back( trackAssociator_.associate(iEvent, iSetup, *iMuon->innerTrack(), parameters_) );
+		      if( iMuon->isStandAloneMuon() && !iMuon->outerTrack().isNull() )
+		      {
+		      //make sure that this SA muon is not actually a halo-like muon                           
+		      float theta =  iMuon->outerTrack()->outerMomentum().theta();
+		      float deta = TMath::Abs(iMuon->outerTrack()->outerPosition().eta() - iMuon->outerTrack()->innerPosition().eta());
+		      
+		      if( !( theta < min_outer_theta || theta > max_outer_theta ) )
+		      if ( deta > deta_threshold ) //halo-like 
+		      info.push_back( trackAssociator_.associate(iEvent, iSetup, *iMuon->outerTrack(), parameters_) );
+		      }
+		      if (iMuon->isGlobalMuon() && !iMuon->globalTrack().isNull() )
+		      info.push_back(trackAssociator_.associate(iEvent, iSetup, *iMuon->globalTrack(), parameters_) );
+		      for(unsigned int i = 0 ; i < info.size(); i++ )
+		      {
+		      for( std::vector<TAMuonChamberMatch>::const_iterator chamber=info[i].chambers.begin();
+		      chamber!=info[i].chambers.end(); chamber++ ){
+		      if( chamber->detector() != MuonSubdetId::CSC ) continue;
+		      
+		      for( std::vector<TAMuonSegmentMatch>::const_iterator segment = chamber->segments.begin();
+		      segment != chamber->segments.end(); segment++ ) {
+		      
+		      float eta_ = segment->segmentGlobalPosition.eta();	
+		      float phi_ = segment->segmentGlobalPosition.phi();	
+		      }
+		      }
+		      }
+		      if( dwire <=  matching_dwire_threshold ) 
+		      DigiIsHalo = false;
+		      }
+
+		      if( DigiIsHalo )
+			nHaloDigis++;
+		    }
+		}
+	    }
+	}
+
+	else if( TheCSCDataHandle.isValid() )
+	{
+	//FOR >= 36X 
+	
+	If the user wants to use the info from the ALCT digis 
+	but they aren't in the event, then the reco::CSCHaloData
+	object can be used, albeit in limited scope,i.e.,
+	ExpectedBX == 3 and no matching to collision muon hits
+	is done until CMSSW_3_7_0.  
+	
+	//NOTE : THIS BLOCK OF CODE ONLY WORKS FOR >= 3_6_0 
+	if(TheCSCDataHandle.isValid())
+	{
+	const reco::CSCHaloData CSCData = (*TheCSCDataHandle.product());
+	nHaloDigis = CSCData.NumberOfOutOfTimeTriggers() ;
+	}
+	}
+
+      else
+	{
+	  LogWarning("Collection Not Found") << "You have requested Digi-level filtering, but the CSCALCTDigiCollection does not appear"
+					     << "to be in the event! Digl-level filtering will be disabled" ;   
+	  
+	  FilterDigiLevel = false ; // NO DIGI LEVEL DECISION CAN BE MADE
+	}
+    }
+
+*/
+  
+  std::unique_ptr<std::vector<CSCHaloTrackFeatures> > TheTrackFeatures;
+  if( produceTrackFeatures )
+    TheTrackFeatures.reset( new std::vector<CSCHaloTrackFeatures> );
+
+  if(FilterRecoLevel || produceTrackFeatures)
+    {
+      METFlagsStageTimer cosmicTimer( stats_.get(), METFlagsStats::kCosmicLoop );
+      if(TheSACosmicMuons.isValid())
+	{
+	  if( produceTrackFeatures ) TheTrackFeatures->reserve( TheSACosmicMuons->size() );
+	  for( reco::TrackCollection::const_iterator iTrack = TheSACosmicMuons->begin() ; iTrack != TheSACosmicMuons->end() ; iTrack++ )
+	    {
+	      // Innermost (smallest abs(z)) and outermost (largest abs(z)) CSC rechits of the track,
+	      // ordered by the |z| of their layer
+	      CSCTrackEndpoints endpoints;
+	      for(unsigned int j = 0 ; j < iTrack->extra()->recHits().size(); j++ )
+		{
+		  edm::Ref<TrackingRecHitCollection> hit( iTrack->extra()->recHits(), j );
+		  if( !hit->isValid() ) continue;
+		  DetId TheDetUnitId(hit->geographicalId());
+		  if( TheDetUnitId.det() != DetId::Muon ) continue;
+
+		  if( TheDetUnitId.subdetId() != MuonSubdetId::CSC ) continue;
+
+		  const CSCDetId TheLayerId(TheDetUnitId);
+		  float absZ = layerZTable.absZ( TheLayerId.endcap(), TheLayerId.station(), TheLayerId.ring(), TheLayerId.chamber(), TheLayerId.layer() );
+		  if( absZ <= 0. )
+		    absZ = std::abs( globalHitPosition( *TheCSCGeometry, *hit ).z );
+		  endpoints.addCandidate( absZ, j );
+		}
+
+	      if( endpoints.nHits() < haloTrackCuts.min_csc_hits && !produceTrackFeatures ) continue; // This needs to be optimized 
+
+	      // Only the two endpoints go through the geometry
+	      if( endpoints.innerIndex() >= 0 && endpoints.outerIndex() >= 0 )
+		{
+		  const edm::Ref<TrackingRecHitCollection> innerHit( iTrack->extra()->recHits(), endpoints.innerIndex() );
+		  const edm::Ref<TrackingRecHitCollection> outerHit( iTrack->extra()->recHits(), endpoints.outerIndex() );
+		  endpoints.setPositions( globalHitPosition( *TheCSCGeometry, *innerHit ), globalHitPosition( *TheCSCGeometry, *outerHit ) );
+		}
+	      
+	      CSCHaloTrackFeatures features = computeHaloTrackFeatures( endpoints, iTrack->outerMomentum().theta(), iTrack->normalizedChi2() );
+	      bool TrackIsHalo = passesHaloTrackCuts( features, haloTrackCuts );
+	      
+	      if( TrackIsHalo )
+		{
+		  nHaloTracks++;
+		  features.flags |= CSCHaloTrackFeatures::kPassesHaloCuts;
+		}
+
+	      if( produceTrackFeatures )
+		TheTrackFeatures->push_back( features );
+	    }
+	}
+      else if( FilterRecoLevel )
+	{
+	  LogWarning("Collection Not Found") << "You have requested Reco-level filtering, but the cosmic stand-alone muon collection does not appear"
+					     << "to be in the event! Reco-level filtering will be disabled" ;   
+
+	  FilterRecoLevel = false; //NO RECO LEVEL DECISION CAN BE MADE
+	}
+    }
+
+
+  if(FilterRecoLevel && FilterDigiLevel && FilterTriggerLevel)
+    pass = !( nHaloTracks >= min_nHaloTracks && nHaloDigis >= min_nHaloDigis && nHaloCands >= min_nHaloTriggers );
+  else if( FilterRecoLevel && FilterDigiLevel )
+    pass = !(nHaloTracks>= min_nHaloTracks && nHaloDigis >= min_nHaloDigis);
+  else if( FilterRecoLevel && FilterTriggerLevel ) 
+    pass = !(nHaloTracks>= min_nHaloTracks && nHaloCands >= min_nHaloTriggers );
+  else if( FilterDigiLevel && FilterTriggerLevel )
+    pass = !( nHaloDigis >= min_nHaloDigis && nHaloCands >= min_nHaloTriggers );
+  else if( FilterDigiLevel ) 
+    pass = !(nHaloDigis >= min_nHaloDigis);
+  else if( FilterRecoLevel ) 
+    pass = !( nHaloTracks >= min_nHaloTracks );
+  else if( FilterTriggerLevel ) 
+    pass = !( nHaloCands >= min_nHaloTriggers) ;
+  else
+    pass = true;
+  
+  lumiProcessedCnt++; runProcessedCnt++;
+  if( !pass ) { lumiTaggedCnt++; runTaggedCnt++; }
+  if( skipBitmap_.get() ) skipBitmap_->tag( iEvent.id(), !pass );
+
+  if( sidecar_.get() )
+    sidecar_->record( iEvent.id().run(), iEvent.luminosityBlock(), iEvent.id().event(), pass, 0 );
+
+  std::unique_ptr<bool> pOut( new bool(pass) );
+  iEvent.put( std::move(pOut) );
+
+  if( produceTrackFeatures )
+    iEvent.put( std::move(TheTrackFeatures), "HaloTrackFeatures" );
+
+  evtTimer.done( iEvent.id().run(), iEvent.luminosityBlock(), !pass );
+}
+
+void CSCHaloFlagProducer::collisionMuonTracks(const reco::Muon & muon, std::vector<const reco::Track*> & tracks) const
+{
+  if( muon.isTrackerMuon() && !muon.innerTrack().isNull() )
+    tracks.push_back( muon.innerTrack().get() );
+  if( muon.isStandAloneMuon() && !muon.outerTrack().isNull() )
+    {
+      //make sure that this SA muon is not actually a halo-like muon
+      float theta = muon.outerTrack()->outerMomentum().theta();
+      float deta = std::abs( muon.outerTrack()->outerPosition().eta() - muon.outerTrack()->innerPosition().eta() );
+      if( !( theta < min_outer_theta || theta > max_outer_theta) )  //halo-like
+	if( deta <= deta_threshold ) //halo-like
+	  if( muon.isGlobalMuon() || muon.isTrackerMuon() ) // NOT SA-Only
+	    tracks.push_back( muon.outerTrack().get() );
+    }
+  if( muon.isGlobalMuon() && !muon.globalTrack().isNull() )
+    tracks.push_back( muon.globalTrack().get() );
+}
+
+void CSCHaloFlagProducer::fullCrossings(const edm::Event & iEvent, const edm::EventSetup & iSetup, const std::vector<const reco::Track*> & tracks,
+					std::vector<CSCStationCrossing> & crossings)
+{
+  trackAssociator_->setPropagator( &iSetup.getData(propagatorToken_) );
+
+  for( unsigned int it = 0; it < tracks.size(); it++ )
+    {
+      const TrackDetMatchInfo info = trackAssociator_->associate( iEvent, iSetup, *tracks[it], *parameters_ );
+      for( std::vector<TAMuonChamberMatch>::const_iterator chamber = info.chambers.begin(); chamber != info.chambers.end(); chamber++ )
+	{
+	  if( chamber->detector() != MuonSubdetId::CSC || !chamber->tState.isValid() ) continue;
+
+	  //the propagated track on the chamber, the position the fast extrapolation approximates
+	  const CSCDetId id( chamber->id );
+	  const GlobalPoint position = chamber->tState.globalPosition();
+	  CSCStationCrossing crossing = { (int)it, id.endcap(), id.station(), id.ring() == 4 ? 1 : id.ring(), id.chamber(),
+					  { position.x(), position.y(), position.z() } };
+	  crossings.push_back( crossing );
+	}
+    }
+}
+
+int CSCHaloFlagProducer::countHaloTriggers(const L1MuGMTReadoutCollection & readout, const std::vector<CSCStationCrossing> & fast,
+					   const std::vector<CSCStationCrossing> & full)
+{
+  int nCands = 0;
+
+  const std::vector<L1MuGMTReadoutRecord> TheRecords = readout.getRecords();
+  for( std::vector<L1MuGMTReadoutRecord>::const_iterator iRecord = TheRecords.begin(); iRecord != TheRecords.end(); iRecord++ )
+    {
+      const std::vector<L1MuRegionalCand> TheCands = iRecord->getCSCCands();
+      for( std::vector<L1MuRegionalCand>::const_iterator iCand = TheCands.begin(); iCand != TheCands.end(); iCand++ )
+	{
+	  if( iCand->empty() || !iCand->isFineHalo() ) continue;
+
+	  float halophi = iCand->phiValue();
+	  float haloeta = iCand->etaValue();
+	  halophi = halophi > M_PI ? halophi - 2.*M_PI : halophi;
+
+	  // Check if halo trigger is faked by any collision muons
+	  CSCMatchDistance fastDistance, fullDistance;
+	  for( unsigned int ic = 0; ic < fast.size(); ic++ )
+	    fastDistance.add( fast[ic].pos, haloeta, halophi );
+	  for( unsigned int ic = 0; ic < full.size(); ic++ )
+	    fullDistance.add( full[ic].pos, haloeta, halophi );
+
+	  const bool fastMatched = fastDistance.within( matching_deta_threshold, matching_dphi_threshold );
+	  const bool fullMatched = fullDistance.within( matching_deta_threshold, matching_dphi_threshold );
+	  if( collisionMuonMatching == kValidateMatching )
+	    matchingAgreement.addDecision( CSCMatchingAgreement::kTrigger, fullMatched, fastMatched );
+
+	  if( !( collisionMuonMatching == kFastMatching ? fastMatched : fullMatched ) )
+	    nCands++;
+	}
+    }
+
+  return nCands;
+}
+
+int CSCHaloFlagProducer::countHaloDigis(const CSCALCTDigiCollection & alcts, const CSCGeometry & geometry, const std::vector<CSCTrackState> & states,
+					const std::vector<CSCStationCrossing> & full)
+{
+  int nDigis = 0;
+
+  for( CSCALCTDigiCollection::DigiRangeIterator j = alcts.begin(); j != alcts.end(); j++ )
+    {
+      const CSCDetId detId( (*j).first.rawId() );
+      //ME1/1a digis are read out from the ME1/1 chambers
+      const int ring = detId.station() == 1 && detId.ring() == 4 ? 1 : detId.ring();
+      const CSCLayer *layer = geometry.layer( CSCDetId(detId.endcap(), detId.station(), ring, detId.chamber(), 3) );
+      if( !layer ) continue;
+      const float layerZ = layer->position().z();
+
+      const CSCALCTDigiCollection::Range & range = (*j).second;
+      for( CSCALCTDigiCollection::const_iterator digiIt = range.first; digiIt != range.second; ++digiIt )
+	{
+	  if( !( digiIt->isValid() && digiIt->getBX() < expected_BX ) ) continue;
+
+	  //smallest wire group distance between the digi and the collision muons crossing its chamber
+	  int fastDwire = 999, fullDwire = 999;
+	  for( unsigned int is = 0; is < states.size(); is++ )
+	    {
+	      CSCHitPosition position;
+	      if( ( states[is].pz > 0. ) != ( layerZ > 0. ) || !fastExtrapolator.toZ( states[is], layerZ, position ) ) continue;
+	      fastDwire = std::min( fastDwire, wireGroupDistance( *layer, digiIt->getKeyWG(), position ) );
+	    }
+	  for( unsigned int ic = 0; ic < full.size(); ic++ )
+	    if( full[ic].endcap == detId.endcap() && full[ic].station == detId.station() && full[ic].ring == ring && full[ic].chamber == detId.chamber() )
+	      fullDwire = std::min( fullDwire, wireGroupDistance( *layer, digiIt->getKeyWG(), full[ic].pos ) );
+
+	  const bool fastMatched = fastDwire <= matching_dwire_threshold;
+	  const bool fullMatched = fullDwire <= matching_dwire_threshold;
+	  if( collisionMuonMatching == kValidateMatching )
+	    matchingAgreement.addDecision( CSCMatchingAgreement::kDigi, fullMatched, fastMatched );
+
+	  if( !( collisionMuonMatching == kFastMatching ? fastMatched : fullMatched ) )
+	    nDigis++;
+	}
+    }
+
+  return nDigis;
+}
+
+int CSCHaloFlagProducer::wireGroupDistance(const CSCLayer & layer, int keyWireGroup, const CSCHitPosition & pos) const
+{
+  const LocalPoint local = layer.toLocal( GlobalPoint(pos.x, pos.y, pos.z) );
+  if( !layer.surface().bounds().inside(local) ) return 999;
+
+  //wire groups of the layer geometry count from 1, the ALCT key wire group from 0
+  const int wireGroup = layer.geometry()->wireGroup( layer.geometry()->nearestWire(local) );
+  return std::abs( wireGroup - 1 - keyWireGroup );
+}
+
+CSCHitPosition CSCHaloFlagProducer::globalHitPosition(const CSCGeometry & geometry, const TrackingRecHit & hit) const
+{
+  const GeomDet *TheDet = geometry.idToDet( hit.geographicalId() );
+  const GlobalPoint TheGlobalPosition = TheDet->surface().toGlobal( hit.localPosition() );
+
+  CSCHitPosition position = { TheGlobalPosition.x(), TheGlobalPosition.y(), TheGlobalPosition.z() };
+  return position;
+}
+
+void CSCHaloFlagProducer::beginRun(const edm::Run & iRun, const edm::EventSetup & iSetup)
+{
+  if( FilterRecoLevel || produceTrackFeatures )
+    {
+      //layer 0 : the chamber, for rechits attached to a whole chamber
+      const CSCGeometry & geometry = iSetup.getData(layerZGeometryToken_);
+      layerZTable.clear();
+      for( CSCGeometry::ChamberContainer::const_iterator chamber = geometry.chambers().begin(); chamber != geometry.chambers().end(); chamber++ )
+	{
+	  const CSCDetId id = (*chamber)->id();
+	  layerZTable.setAbsZ( id.endcap(), id.station(), id.ring(), id.chamber(), 0, std::abs( (*chamber)->position().z() ) );
+	}
+      for( CSCGeometry::LayerContainer::const_iterator layer = geometry.layers().begin(); layer != geometry.layers().end(); layer++ )
+	{
+	  const CSCDetId id = (*layer)->id();
+	  layerZTable.setAbsZ( id.endcap(), id.station(), id.ring(), id.chamber(), id.layer(), std::abs( (*layer)->position().z() ) );
+	}
+    }
+
+  if( collisionMuonMatching == kFastMatching || collisionMuonMatching == kValidateMatching )
+    {
+      //z and radial extent of the CSC rings, the planes of the fast extrapolation
+      const CSCGeometry & geometry = iSetup.getData(stationPlanesGeometryToken_);
+      stationPlanes.clear();
+      for( CSCGeometry::ChamberContainer::const_iterator chamber = geometry.chambers().begin(); chamber != geometry.chambers().end(); chamber++ )
+	{
+	  const CSCDetId id = (*chamber)->id();
+	  const GlobalPoint centre = (*chamber)->position();
+	  const float halfLength = (*chamber)->surface().bounds().length()/2.;
+	  stationPlanes.addChamber( id.station(), id.ring(), std::abs(centre.z()), centre.perp() - halfLength, centre.perp() + halfLength );
+	}
+    }
+
+  runProcessedCnt = runTaggedCnt = 0;
+  if( sidecar_.get() )
+    sidecar_->beginRun( iRun.run(), 0 );
+}
+
+void CSCHaloFlagProducer::endRun(const edm::Run & iRun, const edm::EventSetup & iSetup)
+{
+}
+
+void CSCHaloFlagProducer::endRunProduce(edm::Run & iRun, const edm::EventSetup & iSetup)
+{
+  std::unique_ptr<unsigned int> processedPtr( new unsigned int(runProcessedCnt) );
+  std::unique_ptr<unsigned int> taggedPtr( new unsigned int(runTaggedCnt) );
+  iRun.put( std::move(processedPtr), "runProcessed" );
+  iRun.put( std::move(taggedPtr), "runTagged" );
+}
+
+void CSCHaloFlagProducer::beginLuminosityBlock(const edm::LuminosityBlock & iLumi, const edm::EventSetup & iSetup)
+{
+  lumiProcessedCnt = lumiTaggedCnt = 0;
+}
+
+void CSCHaloFlagProducer::endLuminosityBlock(const edm::LuminosityBlock & iLumi, const edm::EventSetup & iSetup)
+{
+}
+
+void CSCHaloFlagProducer::endLuminosityBlockProduce(edm::LuminosityBlock & iLumi, const edm::EventSetup & iSetup)
+{
+  std::unique_ptr<unsigned int> processedPtr( new unsigned int(lumiProcessedCnt) );
+  std::unique_ptr<unsigned int> taggedPtr( new unsigned int(lumiTaggedCnt) );
+  iLumi.put( std::move(processedPtr), "lumiProcessed" );
+  iLumi.put( std::move(taggedPtr), "lumiTagged" );
+}
+
+void CSCHaloFlagProducer::respondToOpenInputFile(const edm::FileBlock & fb)
+{
+  if( skipBitmap_.get() )
+    skipBitmap_->openFile( fb );
+}
+
+void CSCHaloFlagProducer::respondToCloseInputFile(const edm::FileBlock & fb)
+{
+  if( skipBitmap_.get() )
+    skipBitmap_->closeFile( fb );
+}
+
+void CSCHaloFlagProducer::endJob()
+{
+  if( collisionMuonMatching == kValidateMatching )
+    LogInfo("CSCHaloFlagProducer") << "Fast collision muon matching (" << ( fastExtrapolator.model() == CSCMuonExtrapolator::kHelix ? "helix" : "straightLine" )
+				   << ") against TrackDetectorAssociator :\n" << matchingAgreement.summary();
+
+  if( stats_.get() && !stats_->writeSummary(statsFileName_) )
+    LogWarning("CSCHaloFlagProducer") << "Cannot write the stats summary to " << statsFileName_;
+
+  if( sidecar_.get() )
+    {
+      LogInfo("CSCHaloFlagProducer") << "Sidecar hits : " << sidecar_->hits() << "  misses : " << sidecar_->misses();
+      if( !sidecar_->write() )
+	LogWarning("CSCHaloFlagProducer") << "Cannot write the sidecar : " << sidecar_->error();
+    }
+}
+  
+
+DEFINE_FWK_MODULE(CSCHaloFlagProducer);
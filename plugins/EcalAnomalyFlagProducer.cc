@@ -0,0 +1,421 @@
+// -*- C++ -*-
+//
+// Package:    METFlags
+// Class:      EcalAnomalyFlagProducer
+//
+/**\class EcalAnomalyFlagProducer EcalAnomalyFlagProducer.cc
+
+ Description: EcalDeadCellEventFlagProducer and simpleDRFlagProducer in one module
+ Runs the TP or HIT dead tower check and the jet-MET-dead-cell proximity check in a single event
+ pass, on one dead channel table (and tower index) and one TP scale of its dead towers, both built
+ at beginRun. The parameters of each check are those of the
+ separate module, in the "deadCell" and "simpleDR" PSets, see python/ecalAnomalyFlagProducer_cff.py
+ which also aliases the products to the labels and instances of the separate modules.
+ Tagging only : nothing is filtered. The profile files, the sidecars and the skip bitmaps of the
+ separate modules are not available here.
+*/
+
+// system include files
+#include <memory>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// user include files
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/ESHandle.h"
+
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/one/EDProducer.h"
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/LuminosityBlock.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/EDMException.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DataFormats/Common/interface/View.h"
+#include "DataFormats/Common/interface/ValueMap.h"
+#include "DataFormats/EcalRecHit/interface/EcalRecHitCollections.h"
+#include "DataFormats/EcalDigi/interface/EcalDigiCollections.h"
+#include "DataFormats/METReco/interface/MET.h"
+
+#include "CondFormats/EcalObjects/interface/EcalChannelStatus.h"
+#include "CondFormats/DataRecord/interface/EcalChannelStatusRcd.h"
+#include "Geometry/CaloTopology/interface/EcalTrigTowerConstituentsMap.h"
+#include "Geometry/Records/interface/IdealGeometryRecord.h"
+#include "Geometry/CaloGeometry/interface/CaloGeometry.h"
+#include "Geometry/Records/interface/CaloGeometryRecord.h"
+
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTable.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadCellAlgos.h"
+#include "MyAnalysis/METFlags/interface/METFlagsStats.h"
+#include "MyAnalysis/METFlags/plugins/EcalTPDigiSource.h"
+#include "MyAnalysis/METFlags/plugins/EcalDeadTowerTPScaleBuilder.h"
+#include "MyAnalysis/METFlags/plugins/EcalDeadChannelTableSource.h"
+#include "MyAnalysis/METFlags/plugins/EcalDeadCellMethodSelector.h"
+#include "MyAnalysis/METFlags/plugins/FlagJetReader.h"
+
+class EcalAnomalyFlagProducer : public edm::one::EDProducer<edm::one::WatchRuns, edm::one::WatchLuminosityBlocks, edm::EndRunProducer,
+                                                               edm::EndLuminosityBlockProducer> {
+public:
+  explicit EcalAnomalyFlagProducer(const edm::ParameterSet&);
+  ~EcalAnomalyFlagProducer() override {}
+
+private:
+  void produce(edm::Event&, const edm::EventSetup&) override;
+  void endJob() override;
+  void beginRun(const edm::Run&, const edm::EventSetup&) override;
+  void endRun(const edm::Run&, const edm::EventSetup&) override {}
+  void endRunProduce(edm::Run&, const edm::EventSetup&) override;
+  void beginLuminosityBlock(const edm::LuminosityBlock&, const edm::EventSetup&) override;
+  void endLuminosityBlock(const edm::LuminosityBlock&, const edm::EventSetup&) override {}
+  void endLuminosityBlockProduce(edm::LuminosityBlock&, const edm::EventSetup&) override;
+
+// Shared ECAL context : one dead channel table for both checks, its TP scale and the conditions
+  EcalDeadTowerTPScaleBuilder tpScaleBuilder_;
+
+// Table of the run : the EventSetup one (EcalDeadChannelTableESProducer) when deadChannelTableLabel
+// is set, built by the module otherwise
+  std::unique_ptr<EcalDeadChannelTableSource> deadChannelTableSource_;
+  const EcalDeadChannelTable *deadChannelTable_;
+// Status 13 channels of the TP and HIT methods, chnStatusToBeEvaluated channels of the dR search
+  EcalDeadChannelSelection deadChannels_, evaluatedChannels_;
+
+  void getChannelStatusMaps(const edm::EventSetup& iSetup);
+
+  EcalDeadTowerTPScale deadTowerTPScale_;
+  void buildDeadTowerTPScale(const edm::EventSetup& iSetup);
+
+// Dead cell check (EcalDeadCellEventFlagProducer)
+  edm::InputTag tpDigiCollection_, ebReducedRecHitCollection_, eeReducedRecHitCollection_;
+  edm::EDGetTokenT<EcalTrigPrimDigiCollection> tpDigiToken_;
+  edm::EDGetTokenT<EcalRecHitCollection> ebReducedRecHitToken_;
+  edm::EDGetTokenT<EcalRecHitCollection> eeReducedRecHitToken_;
+  double etValToBeFlagged_;
+  bool doEEfilter_;
+  bool produceDeadTowerEt_;
+  double deadTowerEtFloor_;
+
+// TP or HIT method, selected from the provenance and the release of the first event
+  bool methodSelected_, useTPmethod_, useHITmethod_;
+
+  EcalDeadTowerEtSum deadTowerEtSum_;
+  EcalDeadTowerEtSummary deadTowerEtSummary_;
+  int evaluateDeadCell(const edm::Event& iEvent, int &nTowersAboveCut);
+
+// Proximity check (simpleDRFlagProducer)
+  std::unique_ptr<FlagJetReader> jetReader_;
+// Kept between events so that their storage is reused
+  std::vector<FlagJet> allJets_;
+  edm::EDGetTokenT<edm::View<reco::MET> > metToken_;
+  int chnStatusToBeEvaluated_;
+  SimpleDRStagePlan simpleDRPlan_;
+  bool produceJetValueMaps_;
+// Contents of the jet ValueMaps, kept between events as allJets_
+  std::vector<float> jetDRs_;
+  std::vector<int> jetStatuses_;
+  std::vector<unsigned int> jetTowers_;
+
+  void evaluateSimpleDR(edm::Event& iEvent, int &deadCellStatus, int &boundaryStatus);
+
+// Per-lumi and per-run summaries of each check; both checks see every event
+  unsigned int lumiProcessedCnt, lumiDeadCellTaggedCnt, lumiDeadTowersCnt, lumiSimpleDRTaggedCnt;
+  unsigned int runProcessedCnt, runDeadCellTaggedCnt, runDeadTowersCnt, runSimpleDRTaggedCnt;
+  unsigned int evtProcessedCnt, totDeadCellTaggedCnt, totSimpleDRTaggedCnt;
+
+// Stage timing and per-lumi counters, null unless enableStats
+  std::unique_ptr<METFlagsStats> stats_;
+  std::string statsFileName_;
+  METFlagsScratchWatch scratchWatch_;
+};
+
+
+EcalAnomalyFlagProducer::EcalAnomalyFlagProducer(const edm::ParameterSet& iConfig) :
+  tpScaleBuilder_( consumesCollector() ) {
+
+  const edm::ParameterSet deadCell = iConfig.getParameter<edm::ParameterSet>("deadCell");
+  const edm::ParameterSet simpleDR = iConfig.getParameter<edm::ParameterSet>("simpleDR");
+
+// One table serves both checks : they must select the same masked channels. The status codes
+// of EcalChannelStatusCode::getStatusCode() have no bit above the 0x1F mask of the TP/HIT check
+  const int maskedEcalChannelStatusThreshold = deadCell.getParameter<int>("maskedEcalChannelStatusThreshold");
+  if( simpleDR.getParameter<int>("maskedEcalChannelStatusThreshold") != maskedEcalChannelStatusThreshold ){
+     throw cms::Exception("Configuration") << "EcalAnomalyFlagProducer : deadCell and simpleDR have different maskedEcalChannelStatusThreshold,"
+                                           << " run the separate modules instead";
+  }
+  deadChannelTableSource_.reset( new EcalDeadChannelTableSource(consumesCollector(), iConfig.getUntrackedParameter<std::string>("deadChannelTableLabel", ""),
+                                                                maskedEcalChannelStatusThreshold, 0x1F, "EcalAnomalyFlagProducer") );
+  deadChannelTable_ = &deadChannelTableSource_->table();
+
+  tpDigiCollection_ = deadCell.getParameter<edm::InputTag>("tpDigiCollection");
+  ebReducedRecHitCollection_ = deadCell.getParameter<edm::InputTag>("ebReducedRecHitCollection");
+  eeReducedRecHitCollection_ = deadCell.getParameter<edm::InputTag>("eeReducedRecHitCollection");
+  tpDigiToken_ = consumes<EcalTrigPrimDigiCollection>(tpDigiCollection_);
+  ebReducedRecHitToken_ = mayConsume<EcalRecHitCollection>(ebReducedRecHitCollection_);
+  eeReducedRecHitToken_ = mayConsume<EcalRecHitCollection>(eeReducedRecHitCollection_);
+  etValToBeFlagged_ = deadCell.getParameter<double>("etValToBeFlagged");
+  doEEfilter_ = deadCell.getUntrackedParameter<bool>("doEEfilter", true);
+  produceDeadTowerEt_ = deadCell.getUntrackedParameter<bool>("produceDeadTowerEt", false);
+  deadTowerEtFloor_ = deadCell.getUntrackedParameter<double>("deadTowerEtFloor", 1.0);
+  methodSelected_ = false; useTPmethod_ = true; useHITmethod_ = false;
+
+  jetReader_ = FlagJetReader::create(simpleDR.getUntrackedParameter<std::string>("jetCollectionType", "view"), simpleDR.getParameter<edm::InputTag>("jetInputTag"),
+                                     consumesCollector());
+  metToken_ = consumes<edm::View<reco::MET> >(simpleDR.getParameter<edm::InputTag>("metInputTag"));
+  chnStatusToBeEvaluated_ = simpleDR.getParameter<int>("chnStatusToBeEvaluated");
+  const std::vector<double> jetSelCuts = simpleDR.getParameter<std::vector<double> >("jetSelCuts");
+  const std::vector<double> simpleDRInput = simpleDR.getParameter<std::vector<double> >("simpleDRFlagProducerInput");
+  const std::vector<double> cracksHBHEdef = simpleDR.getParameter<std::vector<double> >("cracksHBHEdef");
+  const std::vector<double> cracksHEHFdef = simpleDR.getParameter<std::vector<double> >("cracksHEHFdef");
+  simpleDRPlan_.build(jetSelCuts[0], jetSelCuts[1], simpleDRInput[0], simpleDRInput[1], simpleDR.getUntrackedParameter<bool>("doCracks", false),
+                      cracksHBHEdef[0], cracksHBHEdef[1], cracksHEHFdef[0], cracksHEHFdef[1]);
+  produceJetValueMaps_ = simpleDR.getUntrackedParameter<bool>("produceJetValueMaps", false);
+
+  evtProcessedCnt = totDeadCellTaggedCnt = totSimpleDRTaggedCnt = 0;
+  lumiProcessedCnt = lumiDeadCellTaggedCnt = lumiDeadTowersCnt = lumiSimpleDRTaggedCnt = 0;
+  runProcessedCnt = runDeadCellTaggedCnt = runDeadTowersCnt = runSimpleDRTaggedCnt = 0;
+
+  if( iConfig.getUntrackedParameter<bool>("enableStats", false) ){
+     const std::string label = iConfig.getParameter<std::string>("@module_label");
+     stats_.reset( new METFlagsStats(label) );
+     statsFileName_ = iConfig.getUntrackedParameter<std::string>("statsFileName", label + "_stats.json");
+     deadTowerEtSum_.watchScratch(scratchWatch_);
+     simpleDRPlan_.watchScratch(scratchWatch_);
+     scratchWatch_.watch(allJets_);
+     scratchWatch_.watch(jetDRs_); scratchWatch_.watch(jetStatuses_); scratchWatch_.watch(jetTowers_);
+  }
+
+// Instances of the separate modules, prefixed where both have one of the same name
+  produces<bool>("deadCellTP");
+  if( produceDeadTowerEt_ ){
+     produces<double>("maxDeadTowerEtPlus");
+     produces<double>("maxDeadTowerEtMinus");
+     produces<unsigned int>("nDeadTowersAboveFloor");
+     produces<unsigned int>("hottestDeadTower");
+  }
+  produces<unsigned int, edm::Transition::EndLuminosityBlock>("lumiProcessed");
+  produces<unsigned int, edm::Transition::EndRun>("runProcessed");
+
+  produces<unsigned int, edm::Transition::EndLuminosityBlock>("deadCellLumiTagged");
+  produces<unsigned int, edm::Transition::EndLuminosityBlock>("lumiDeadTowersAboveThreshold");
+  produces<unsigned int, edm::Transition::EndRun>("deadCellRunTagged");
+  produces<unsigned int, edm::Transition::EndRun>("runDeadTowersAboveThreshold");
+
+  produces<bool>("simpleDR");
+  produces<int>("deadCellStatus"); produces<int>("boundaryStatus");
+  if( produceJetValueMaps_ ){
+     produces<edm::ValueMap<float> >("deadChannelDR");
+     produces<edm::ValueMap<int> >("deadChannelStatus");
+     produces<edm::ValueMap<unsigned int> >("deadChannelTower");
+  }
+  produces<unsigned int, edm::Transition::EndLuminosityBlock>("simpleDRLumiTagged");
+  produces<unsigned int, edm::Transition::EndRun>("simpleDRRunTagged");
+}
+
+
+void EcalAnomalyFlagProducer::produce(edm::Event& iEvent, const edm::EventSetup& iSetup) {
+
+  METFlagsEventTimer evtTimer(stats_.get(), &scratchWatch_);
+
+  const unsigned int run = iEvent.id().run(), ls = iEvent.luminosityBlock();
+
+  if( !methodSelected_ ){
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kMethodSelect);
+     const EcalDeadCellMethod method = selectDeadCellMethod(iEvent, tpDigiCollection_, ebReducedRecHitCollection_, eeReducedRecHitCollection_, "EcalAnomalyFlagProducer");
+     useTPmethod_ = method == kDeadCellTPMethod; useHITmethod_ = method == kDeadCellHITMethod;
+     methodSelected_ = true;
+  }
+
+  int nDeadTowersAboveCut = 0;
+  const int deadCellTagged = evaluateDeadCell(iEvent, nDeadTowersAboveCut);
+
+  int deadCellStatus = 0, boundaryStatus = 0;
+  evaluateSimpleDR(iEvent, deadCellStatus, boundaryStatus);
+  const bool simpleDRTagged = deadCellStatus != 0 || boundaryStatus != 0;
+
+  evtProcessedCnt++; lumiProcessedCnt++; runProcessedCnt++;
+  if( deadCellTagged ){ totDeadCellTaggedCnt++; lumiDeadCellTaggedCnt++; runDeadCellTaggedCnt++; }
+  if( simpleDRTagged ){ totSimpleDRTaggedCnt++; lumiSimpleDRTaggedCnt++; runSimpleDRTaggedCnt++; }
+  lumiDeadTowersCnt += nDeadTowersAboveCut; runDeadTowersCnt += nDeadTowersAboveCut;
+
+  std::unique_ptr<bool> deadCellPass( new bool(!deadCellTagged) );
+  iEvent.put( std::move(deadCellPass), "deadCellTP" );
+  if( produceDeadTowerEt_ ){
+     std::unique_ptr<double> maxEtPlusPtr( new double(deadTowerEtSummary_.maxEtPlus) );
+     std::unique_ptr<double> maxEtMinusPtr( new double(deadTowerEtSummary_.maxEtMinus) );
+     std::unique_ptr<unsigned int> nAboveFloorPtr( new unsigned int(deadTowerEtSummary_.nAboveFloor) );
+     std::unique_ptr<unsigned int> hottestPtr( new unsigned int(deadTowerEtSummary_.hottestRawId) );
+     iEvent.put( std::move(maxEtPlusPtr), "maxDeadTowerEtPlus" );
+     iEvent.put( std::move(maxEtMinusPtr), "maxDeadTowerEtMinus" );
+     iEvent.put( std::move(nAboveFloorPtr), "nDeadTowersAboveFloor" );
+     iEvent.put( std::move(hottestPtr), "hottestDeadTower" );
+  }
+
+  std::unique_ptr<bool> simpleDRPass( new bool(!simpleDRTagged) );
+  std::unique_ptr<int> deadCellStatusPtr( new int(deadCellStatus) );
+  std::unique_ptr<int> boundaryStatusPtr( new int(boundaryStatus) );
+  iEvent.put( std::move(simpleDRPass), "simpleDR" );
+  iEvent.put( std::move(deadCellStatusPtr), "deadCellStatus" );
+  iEvent.put( std::move(boundaryStatusPtr), "boundaryStatus" );
+
+  evtTimer.done(run, ls, deadCellTagged || simpleDRTagged);
+}
+
+
+int EcalAnomalyFlagProducer::evaluateDeadCell(const edm::Event& iEvent, int &nTowersAboveCut) {
+
+  nTowersAboveCut = 0;
+  deadTowerEtSummary_.clear();
+  EcalDeadTowerEtSummary *summary = produceDeadTowerEt_ ? &deadTowerEtSummary_ : 0;
+
+  if( useTPmethod_ ){
+     edm::Handle<EcalTrigPrimDigiCollection> pTPDigis;
+     {
+        METFlagsStageTimer timer(stats_.get(), METFlagsStats::kLoad);
+        iEvent.getByToken(tpDigiToken_, pTPDigis);
+     }
+     if( !pTPDigis.isValid() ){
+        edm::LogWarning("EcalAnomalyFlagProducer") << "Can't get the product " << tpDigiCollection_.instance() << " with label " << tpDigiCollection_.label();
+        return 0;
+     }
+
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kTPScan);
+// The codes of deadTowerTPScale_ are those of etValToBeFlagged_
+     EcalTPDigiSource tpSource(*pTPDigis, *deadChannelTable_, deadTowerTPScale_);
+     return evaluateDeadCellTPEvent(*deadChannelTable_, deadChannels_, deadTowerTPScale_, tpSource, etValToBeFlagged_, doEEfilter_, nTowersAboveCut,
+                                    deadTowerEtFloor_, summary);
+  }
+
+  if( useHITmethod_ ){
+     edm::Handle<EcalRecHitCollection> barrelReducedRecHitsHandle, endcapReducedRecHitsHandle;
+     {
+        METFlagsStageTimer timer(stats_.get(), METFlagsStats::kLoad);
+        iEvent.getByToken(ebReducedRecHitToken_, barrelReducedRecHitsHandle);
+        iEvent.getByToken(eeReducedRecHitToken_, endcapReducedRecHitsHandle);
+     }
+     if( !barrelReducedRecHitsHandle.isValid() || !endcapReducedRecHitsHandle.isValid() ){
+        edm::LogWarning("EcalAnomalyFlagProducer") << "Can't get the reduced rechits " << ebReducedRecHitCollection_.encode() << " and "
+                                                   << eeReducedRecHitCollection_.encode() << " : the dead cell check is not done for this event";
+        return 0;
+     }
+
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kHITScan);
+     deadTowerEtSum_.reset(*deadChannelTable_, deadChannels_, 13, doEEfilter_);
+     deadTowerEtSum_.addHits(barrelReducedRecHitsHandle->begin(), barrelReducedRecHitsHandle->end());
+     if( doEEfilter_ ) deadTowerEtSum_.addHits(endcapReducedRecHitsHandle->begin(), endcapReducedRecHitsHandle->end());
+     return deadTowerEtSum_.evaluate(etValToBeFlagged_, nTowersAboveCut, deadTowerEtFloor_, summary);
+  }
+
+  return 0;
+}
+
+
+void EcalAnomalyFlagProducer::evaluateSimpleDR(edm::Event& iEvent, int &deadCellStatus, int &boundaryStatus) {
+
+  edm::Handle<edm::View<reco::MET> > met;
+  {
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kLoad);
+     jetReader_->load(iEvent, allJets_);
+     iEvent.getByToken(metToken_, met);
+  }
+
+  METFlagsStageTimer timer(stats_.get(), METFlagsStats::kDRSearch);
+
+// Nearest masked channel of every input jet; no masked channel : dR 999, status -1, tower 0
+  if( produceJetValueMaps_ ){
+     nearestDeadChannels(*deadChannelTable_, evaluatedChannels_, allJets_, jetDRs_, jetStatuses_, jetTowers_);
+
+     std::unique_ptr<edm::ValueMap<float> > dRMap( new edm::ValueMap<float>() );
+     edm::ValueMap<float>::Filler dRFiller(*dRMap);
+     jetReader_->insert(dRFiller, jetDRs_);
+     dRFiller.fill();
+     std::unique_ptr<edm::ValueMap<int> > statusMap( new edm::ValueMap<int>() );
+     edm::ValueMap<int>::Filler statusFiller(*statusMap);
+     jetReader_->insert(statusFiller, jetStatuses_);
+     statusFiller.fill();
+     std::unique_ptr<edm::ValueMap<unsigned int> > towerMap( new edm::ValueMap<unsigned int>() );
+     edm::ValueMap<unsigned int>::Filler towerFiller(*towerMap);
+     jetReader_->insert(towerFiller, jetTowers_);
+     towerFiller.fill();
+
+     iEvent.put( std::move(dRMap), "deadChannelDR" );
+     iEvent.put( std::move(statusMap), "deadChannelStatus" );
+     iEvent.put( std::move(towerMap), "deadChannelTower" );
+  }
+
+  if( !met.isValid() || met->empty() ){
+     edm::LogWarning("EcalAnomalyFlagProducer") << "No MET in the event : the simpleDR check is not done for this event";
+     return;
+  }
+
+// Same stages as simpleDRFlagProducer
+  int dPhiToMETstatus = 0;
+  simpleDRPlan_.run(allJets_, (*met)[0].phi(), *deadChannelTable_, evaluatedChannels_, dPhiToMETstatus, deadCellStatus, boundaryStatus);
+}
+
+
+void EcalAnomalyFlagProducer::endJob() {
+
+  edm::LogInfo("EcalAnomalyFlagProducer") << "Processed " << evtProcessedCnt << " events, tagged " << totDeadCellTaggedCnt
+                                          << " by the dead cell check and " << totSimpleDRTaggedCnt << " by simpleDR";
+
+  if( stats_.get() && !stats_->writeSummary(statsFileName_) ){
+     edm::LogWarning("EcalAnomalyFlagProducer") << "Cannot write the stats summary to " << statsFileName_;
+  }
+}
+
+
+void EcalAnomalyFlagProducer::beginRun(const edm::Run &run, const edm::EventSetup& iSetup) {
+  getChannelStatusMaps(iSetup);
+  buildDeadTowerTPScale(iSetup);
+  runProcessedCnt = runDeadCellTaggedCnt = runDeadTowersCnt = runSimpleDRTaggedCnt = 0;
+}
+
+
+void EcalAnomalyFlagProducer::endRunProduce(edm::Run &run, const edm::EventSetup& iSetup) {
+
+  run.put( std::unique_ptr<unsigned int>( new unsigned int(runProcessedCnt) ), "runProcessed" );
+  run.put( std::unique_ptr<unsigned int>( new unsigned int(runDeadCellTaggedCnt) ), "deadCellRunTagged" );
+  run.put( std::unique_ptr<unsigned int>( new unsigned int(runDeadTowersCnt) ), "runDeadTowersAboveThreshold" );
+  run.put( std::unique_ptr<unsigned int>( new unsigned int(runSimpleDRTaggedCnt) ), "simpleDRRunTagged" );
+}
+
+
+void EcalAnomalyFlagProducer::beginLuminosityBlock(const edm::LuminosityBlock &lumi, const edm::EventSetup& iSetup) {
+  lumiProcessedCnt = lumiDeadCellTaggedCnt = lumiDeadTowersCnt = lumiSimpleDRTaggedCnt = 0;
+}
+
+
+void EcalAnomalyFlagProducer::endLuminosityBlockProduce(edm::LuminosityBlock &lumi, const edm::EventSetup& iSetup) {
+
+  lumi.put( std::unique_ptr<unsigned int>( new unsigned int(lumiProcessedCnt) ), "lumiProcessed" );
+  lumi.put( std::unique_ptr<unsigned int>( new unsigned int(lumiDeadCellTaggedCnt) ), "deadCellLumiTagged" );
+  lumi.put( std::unique_ptr<unsigned int>( new unsigned int(lumiDeadTowersCnt) ), "lumiDeadTowersAboveThreshold" );
+  lumi.put( std::unique_ptr<unsigned int>( new unsigned int(lumiSimpleDRTaggedCnt) ), "simpleDRLumiTagged" );
+}
+
+
+void EcalAnomalyFlagProducer::getChannelStatusMaps(const edm::EventSetup& iSetup) {
+
+// Same table as the previous run : the selections are still valid
+  const bool changed = deadChannelTableSource_->update(iSetup);
+  deadChannelTable_ = &deadChannelTableSource_->table();
+  if( !changed ) return;
+  deadChannels_.build(*deadChannelTable_, 13);
+  evaluatedChannels_.build(*deadChannelTable_, chnStatusToBeEvaluated_);
+}
+
+
+void EcalAnomalyFlagProducer::buildDeadTowerTPScale(const edm::EventSetup& iSetup) {
+
+  tpScaleBuilder_.build(iSetup, *deadChannelTable_, etValToBeFlagged_, deadTowerTPScale_);
+}
+
+
+//define this as a plug-in
+DEFINE_FWK_MODULE(EcalAnomalyFlagProducer);
@@ -0,0 +1,600 @@
+// -*- C++ -*-
+//
+// Package:    EcalDeadCellEventFilter
+// Class:      EcalDeadCellEventFilter
+// 
+/**\class EcalDeadCellEventFilter EcalDeadCellEventFilter.cc
+
+ Description: <one line class summary>
+ Event filtering for anomalous ECAL events where the energy measured by ECAL is significantly biased due to energy depositions
+ in dead cell regions. 
+*/
+//
+// Original Author:  Hongxuan Liu and Kenichi Hatakeyama
+//                   in collaboration with Konstantinos Theofilatos and Ulla Gebbert
+
+// system include files
+#include <memory>
+#include <fstream>
+
+// user include files
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/ESHandle.h"
+
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/one/EDFilter.h"
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/LuminosityBlock.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/Framework/interface/FileBlock.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/EDMException.h"
+
+#include "DataFormats/EcalRecHit/interface/EcalRecHitCollections.h"
+#include "DataFormats/DetId/interface/DetId.h"
+
+#include "CondFormats/EcalObjects/interface/EcalChannelStatus.h"
+#include "CondFormats/DataRecord/interface/EcalChannelStatusRcd.h"
+
+#include "DataFormats/EcalDigi/interface/EcalDigiCollections.h"
+#include "Geometry/CaloTopology/interface/EcalTrigTowerConstituentsMap.h"
+#include "Geometry/Records/interface/IdealGeometryRecord.h"
+
+#include "SimDataFormats/GeneratorProducts/interface/HepMCProduct.h"
+#include "SimDataFormats/GeneratorProducts/interface/GenEventInfoProduct.h"
+
+// Geometry
+#include "Geometry/CaloGeometry/interface/CaloGeometry.h"
+#include "Geometry/Records/interface/CaloGeometryRecord.h"
+
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTable.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadCellAlgos.h"
+#include "MyAnalysis/METFlags/interface/METFlagsStats.h"
+#include "MyAnalysis/METFlags/interface/METFlagsSidecar.h"
+#include "MyAnalysis/METFlags/plugins/METFlagsSkipBitmapWriter.h"
+#include "MyAnalysis/METFlags/plugins/EcalDeadChannelTableSource.h"
+#include "MyAnalysis/METFlags/plugins/EcalTPDigiSource.h"
+#include "MyAnalysis/METFlags/plugins/EcalDeadTowerTPScaleBuilder.h"
+#include "MyAnalysis/METFlags/plugins/EcalDeadCellMethodSelector.h"
+
+#include "TFile.h"
+#include "TTree.h"
+
+using namespace std;
+
+class EcalDeadCellEventFlagProducer : public edm::one::EDFilter<edm::one::WatchRuns, edm::one::WatchLuminosityBlocks, edm::EndRunProducer,
+                                                                   edm::EndLuminosityBlockProducer, edm::one::WatchInputFiles> {
+public:
+  explicit EcalDeadCellEventFlagProducer(const edm::ParameterSet&);
+  ~EcalDeadCellEventFlagProducer();
+
+private:
+  bool filter(edm::Event&, const edm::EventSetup&) override;
+  void beginJob() override;
+  void endJob() override;
+  void beginRun(const edm::Run&, const edm::EventSetup&) override;
+  void endRun(const edm::Run&, const edm::EventSetup&) override;
+  void endRunProduce(edm::Run&, const edm::EventSetup&) override;
+  void beginLuminosityBlock(const edm::LuminosityBlock&, const edm::EventSetup&) override;
+  void endLuminosityBlock(const edm::LuminosityBlock&, const edm::EventSetup&) override;
+  void endLuminosityBlockProduce(edm::LuminosityBlock&, const edm::EventSetup&) override;
+  void respondToOpenInputFile(const edm::FileBlock&) override;
+  void respondToCloseInputFile(const edm::FileBlock&) override;
+
+  // ----------member data ---------------------------
+
+  const bool            taggingMode_;
+
+  bool debug_;
+
+  bool doEEfilter_;
+
+  void loadEcalDigis(edm::Event& iEvent, const edm::EventSetup& iSetup);
+  void loadEcalRecHits(edm::Event& iEvent, const edm::EventSetup& iSetup);
+
+  edm::InputTag ebReducedRecHitCollection_;
+  edm::InputTag eeReducedRecHitCollection_;
+  edm::EDGetTokenT<EcalRecHitCollection> ebReducedRecHitToken_;
+  edm::EDGetTokenT<EcalRecHitCollection> eeReducedRecHitToken_;
+  edm::Handle<EcalRecHitCollection> barrelReducedRecHitsHandle;
+  edm::Handle<EcalRecHitCollection> endcapReducedRecHitsHandle;
+
+  EcalDeadTowerTPScaleBuilder tpScaleBuilder_;
+
+  int maskedEcalChannelStatusThreshold_;
+
+// XXX: All the following can be built at the beginning of a run
+// Masked channels (eta, phi, theta, status) and the trigger towers containing them, of the
+// EventSetup when deadChannelTableLabel is set, built by the module otherwise
+  std::unique_ptr<EcalDeadChannelTableSource> deadChannelTableSource_;
+  const EcalDeadChannelTable *deadChannelTable_;
+// Masked channels of status 13 and their towers, the only ones the TP and HIT methods look at
+  EcalDeadChannelSelection deadChannels_;
+
+  int getChannelStatusMaps(const edm::EventSetup& iSetup);
+
+// TP scale of the dead towers and compressed Et codes of etValToBeFlagged_, built at beginRun
+  EcalDeadTowerTPScale deadTowerTPScale_;
+  void buildDeadTowerTPScale(const edm::EventSetup& iSetup);
+
+// TP filter
+  double etValToBeFlagged_;
+
+  edm::InputTag tpDigiCollection_;
+  edm::EDGetTokenT<EcalTrigPrimDigiCollection> tpDigiToken_;
+  edm::Handle<EcalTrigPrimDigiCollection> pTPDigis;
+
+// Channels of deadChannels_, EE ones only if doEEfilter_
+// Return value:  + : positive zside  - : negative zside
+// nTowersAboveCut : number of dead towers above the cut (only evaluated for tagged events)
+  int setEvtTPstatus(int &nTowersAboveCut);
+
+  int evtProcessedCnt, totFilteredCnt;
+
+// Per-lumi and per-run summaries: processed and tagged events, dead towers above the cut summed over events
+  unsigned int lumiProcessedCnt, lumiTaggedCnt, lumiDeadTowersCnt;
+  unsigned int runProcessedCnt, runTaggedCnt, runDeadTowersCnt;
+
+// Stage timing and per-lumi counters, null unless enableStats
+  std::unique_ptr<METFlagsStats> stats_;
+  std::string statsFileName_;
+  METFlagsScratchWatch scratchWatch_;
+
+// Cached decisions (evtTagged, nDeadTowersAboveCut), null unless sidecarInput or sidecarOutput
+  std::unique_ptr<METFlagsSidecar> sidecar_;
+// Hash of the dead channel table and of the TP scale of the dead towers, set with the TP scale
+  uint64_t sidecarConditions_;
+  unsigned int sidecarRun_; bool sidecarRunSet_;
+  uint64_t sidecarConditionsHash();
+
+// Entry numbers of the tagged events per input file, null unless skipBitmapDir
+  std::unique_ptr<METFlagsSkipBitmapWriter> skipBitmap_;
+
+  bool makeProfileRoot_;
+  std::string profileRootName_;
+  TFile *profFile;
+  TTree *profTree;
+
+  std::vector<int> *cutFlowFlagTmpPtr;
+  std::vector<std::string> *cutFlowStrTmpPtr;
+  std::vector<int> cutFlowFlagTmpVec_;
+  std::vector<std::string> cutFlowStrTmpVec_;
+
+  void loadEventInfo(const edm::Event& iEvent, const edm::EventSetup& iSetup);
+  edm::EDGetTokenT<edm::HepMCProduct> hepMCToken_;
+  edm::EDGetTokenT<GenEventInfoProduct> genEventInfoToken_;
+  unsigned int run, event, ls; bool isdata; double pthat, scalePDF;
+
+  bool getEventInfoForFilterOnce_;
+
+  bool useTPmethod_, useHITmethod_;
+
+  void loadEventInfoForFilter(const edm::Event& iEvent);
+
+// Per-tower Et sums of the recovered rechits of masked channels
+  EcalDeadTowerEtSum deadTowerEtSum_;
+  int setEvtRecHitstatus(const double &tpValCut, const int &towerTest, int &nTowersAboveCut);
+
+// Dead tower Et before the etValToBeFlagged_ cut, stored per event when produceDeadTowerEt_
+  bool produceDeadTowerEt_;
+  double deadTowerEtFloor_;
+  EcalDeadTowerEtSummary deadTowerEtSummary_;
+
+};
+
+
+void EcalDeadCellEventFlagProducer::loadEventInfoForFilter(const edm::Event &iEvent){
+
+// If TP is available, always use TP, else the recovered rechits of AOD from 42X on (selectDeadCellMethod).
+// If users really can provide them, they must be experts to modify this code to suit their own purpose :-)
+  const EcalDeadCellMethod method = selectDeadCellMethod(iEvent, tpDigiCollection_, ebReducedRecHitCollection_, eeReducedRecHitCollection_,
+                                                         "EcalDeadCellEventFlagProducer");
+  useTPmethod_ = method == kDeadCellTPMethod;
+  useHITmethod_ = method == kDeadCellHITMethod;
+
+  getEventInfoForFilterOnce_ = true;
+ 
+}
+
+
+void EcalDeadCellEventFlagProducer::loadEventInfo(const edm::Event& iEvent, const edm::EventSetup& iSetup){
+   run = iEvent.id().run();
+   event = iEvent.id().event();
+   ls = iEvent.luminosityBlock();
+   isdata = iEvent.isRealData();
+
+   edm::Handle<edm::HepMCProduct> evt;
+   edm::Handle< GenEventInfoProduct > GenInfoHandle;
+
+   scalePDF = -1; pthat = -1;
+   if (!isdata) {
+      iEvent.getByToken(hepMCToken_, evt);
+      if (evt.isValid()) {
+         HepMC::GenEvent * myGenEvent = new HepMC::GenEvent(*(evt->GetEvent()));
+         scalePDF = myGenEvent->event_scale();
+         if( myGenEvent ) delete myGenEvent;
+       }
+
+       iEvent.getByToken( genEventInfoToken_, GenInfoHandle );
+       if (GenInfoHandle.isValid()) { pthat = ( GenInfoHandle->hasBinningValues() ? (GenInfoHandle->binningValues())[0] : 0.0); }
+   }
+}
+
+
+void EcalDeadCellEventFlagProducer::loadEcalDigis(edm::Event& iEvent, const edm::EventSetup& iSetup){
+
+  iEvent.getByToken(tpDigiToken_, pTPDigis);
+  if ( !pTPDigis.isValid() ) { edm::LogWarning("EcalDeadCellEventFlagProducer") << "Can't get the product " << tpDigiCollection_.instance()
+                                             << " with label " << tpDigiCollection_.label(); return; }
+}
+
+void EcalDeadCellEventFlagProducer::loadEcalRecHits(edm::Event& iEvent, const edm::EventSetup& iSetup){
+
+  iEvent.getByToken(ebReducedRecHitToken_,barrelReducedRecHitsHandle);
+  iEvent.getByToken(eeReducedRecHitToken_,endcapReducedRecHitsHandle);
+  if ( !barrelReducedRecHitsHandle.isValid() || !endcapReducedRecHitsHandle.isValid() ) { edm::LogWarning("EcalDeadCellEventFlagProducer") << "Can't get the reduced rechits "
+                                             << ebReducedRecHitCollection_.encode() << " and " << eeReducedRecHitCollection_.encode(); return; }
+}
+
+//
+// static data member definitions
+//
+
+//
+// constructors and destructor
+//
+EcalDeadCellEventFlagProducer::EcalDeadCellEventFlagProducer(const edm::ParameterSet& iConfig) : 
+  taggingMode_( iConfig.getParameter<bool>("taggingMode") ), tpScaleBuilder_( consumesCollector() ) {
+
+  debug_= iConfig.getUntrackedParameter<bool>("debug",false);
+
+  tpDigiCollection_ = iConfig.getParameter<edm::InputTag>("tpDigiCollection");
+
+  maskedEcalChannelStatusThreshold_ = iConfig.getParameter<int>("maskedEcalChannelStatusThreshold");
+// refer https://twiki.cern.ch/twiki/bin/viewauth/CMS/EcalChannelStatus
+  deadChannelTableSource_.reset( new EcalDeadChannelTableSource(consumesCollector(), iConfig.getUntrackedParameter<std::string>("deadChannelTableLabel", ""),
+                                                                maskedEcalChannelStatusThreshold_, 0x1F, "EcalDeadCellEventFlagProducer") );
+  deadChannelTable_ = &deadChannelTableSource_->table();
+
+  etValToBeFlagged_ = iConfig.getParameter<double>("etValToBeFlagged");
+
+  produceDeadTowerEt_ = iConfig.getUntrackedParameter<bool>("produceDeadTowerEt", false);
+  deadTowerEtFloor_ = iConfig.getUntrackedParameter<double>("deadTowerEtFloor", 1.0);
+
+  doEEfilter_ = iConfig.getUntrackedParameter<bool>("doEEfilter");
+
+  ebReducedRecHitCollection_ = iConfig.getParameter<edm::InputTag>("ebReducedRecHitCollection");
+  eeReducedRecHitCollection_ = iConfig.getParameter<edm::InputTag>("eeReducedRecHitCollection");
+
+// The TP digis are used whenever the input has them, the reduced rechits only when it has not;
+// which one is only known from the provenance of the first event
+  tpDigiToken_ = consumes<EcalTrigPrimDigiCollection>(tpDigiCollection_);
+  ebReducedRecHitToken_ = mayConsume<EcalRecHitCollection>(ebReducedRecHitCollection_);
+  eeReducedRecHitToken_ = mayConsume<EcalRecHitCollection>(eeReducedRecHitCollection_);
+// Generator information, only read for simulated events
+  hepMCToken_ = mayConsume<edm::HepMCProduct>(edm::InputTag("generator"));
+  genEventInfoToken_ = mayConsume<GenEventInfoProduct>(edm::InputTag("generator"));
+
+  makeProfileRoot_ = iConfig.getUntrackedParameter<bool>("makeProfileRoot");
+  profileRootName_ = iConfig.getUntrackedParameter<std::string>("profileRootName");
+
+  getEventInfoForFilterOnce_ = false;
+  useTPmethod_ = true; useHITmethod_ = false;
+
+  evtProcessedCnt = 0; totFilteredCnt = 0;
+  lumiProcessedCnt = lumiTaggedCnt = lumiDeadTowersCnt = 0;
+  runProcessedCnt = runTaggedCnt = runDeadTowersCnt = 0;
+
+  if( iConfig.getUntrackedParameter<bool>("enableStats", false) ){
+     const std::string label = iConfig.getParameter<std::string>("@module_label");
+     stats_.reset( new METFlagsStats(label) );
+     statsFileName_ = iConfig.getUntrackedParameter<std::string>("statsFileName", label + "_stats.json");
+     deadTowerEtSum_.watchScratch(scratchWatch_);
+  }
+
+  sidecarConditions_ = 0; sidecarRun_ = 0; sidecarRunSet_ = false;
+  const std::string sidecarInput = iConfig.getUntrackedParameter<std::string>("sidecarInput", "");
+  const std::string sidecarOutput = iConfig.getUntrackedParameter<std::string>("sidecarOutput", "");
+  if( !sidecarInput.empty() || !sidecarOutput.empty() ){
+// doEEfilter is untracked but changes the decisions of both methods
+     const uint64_t sidecarConfigHash = metFlagsHash(std::string(doEEfilter_ ? "EE" : "noEE"), metFlagsHash(iConfig.id().compactForm()));
+     sidecar_.reset( new METFlagsSidecar(sidecarInput, sidecarOutput, sidecarConfigHash) );
+     if( !sidecar_->error().empty() ) edm::LogWarning("EcalDeadCellEventFlagProducer") << "Sidecar input not used : " << sidecar_->error();
+     if( produceDeadTowerEt_ && !sidecarInput.empty() ) edm::LogWarning("EcalDeadCellEventFlagProducer") << "produceDeadTowerEt is on : the sidecar decisions are not reused";
+  }
+
+  const std::string skipBitmapDir = iConfig.getUntrackedParameter<std::string>("skipBitmapDir", "");
+  if( !skipBitmapDir.empty() ) skipBitmap_.reset( new METFlagsSkipBitmapWriter(skipBitmapDir, iConfig.getParameter<std::string>("@module_label")) );
+
+  if( makeProfileRoot_ ){
+
+     profFile = new TFile(profileRootName_.c_str(), "RECREATE");
+     profTree = new TTree("filter", "filter profile");
+     profTree->Branch("run", &run, "run/I");
+     profTree->Branch("event", &event, "event/I");
+     profTree->Branch("lumi", &ls, "lumi/I");
+     profTree->Branch("cutFlowFlag", &cutFlowFlagTmpPtr);
+     profTree->Branch("cutFlowStr", &cutFlowStrTmpPtr);
+
+  }
+
+  produces<bool>();
+  if( produceDeadTowerEt_ ){
+     produces<double>("maxDeadTowerEtPlus");
+     produces<double>("maxDeadTowerEtMinus");
+     produces<unsigned int>("nDeadTowersAboveFloor");
+     produces<unsigned int>("hottestDeadTower");
+  }
+  produces<unsigned int, edm::Transition::EndLuminosityBlock>("lumiProcessed");
+  produces<unsigned int, edm::Transition::EndLuminosityBlock>("lumiTagged");
+  produces<unsigned int, edm::Transition::EndLuminosityBlock>("lumiDeadTowersAboveThreshold");
+  produces<unsigned int, edm::Transition::EndRun>("runProcessed");
+  produces<unsigned int, edm::Transition::EndRun>("runTagged");
+  produces<unsigned int, edm::Transition::EndRun>("runDeadTowersAboveThreshold");
+}
+
+EcalDeadCellEventFlagProducer::~EcalDeadCellEventFlagProducer() {
+
+  if( makeProfileRoot_ ){
+     profFile->cd();
+     profTree->Write();
+     delete profTree;
+     profFile->Close();
+     delete profFile;
+  }
+
+}
+
+// ------------ method called on each new Event  ------------
+bool EcalDeadCellEventFlagProducer::filter(edm::Event& iEvent, const edm::EventSetup& iSetup) {
+
+  METFlagsEventTimer evtTimer(stats_.get(), &scratchWatch_);
+
+  {
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kLoad);
+     loadEventInfo(iEvent, iSetup);
+  }
+
+  if( !getEventInfoForFilterOnce_ ){
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kMethodSelect);
+     loadEventInfoForFilter(iEvent);
+  }
+
+  evtProcessedCnt++;
+
+  bool pass = true;
+
+  int evtTagged = 0, nDeadTowersAboveCut = 0;
+
+// The method selection is part of the conditions : it is only known after the first event
+  bool fromSidecar = false;
+  deadTowerEtSummary_.clear();
+  if( sidecar_.get() ){
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kSidecar);
+     if( !sidecarRunSet_ || sidecarRun_ != run ){
+        sidecar_->beginRun(run, metFlagsHashValue(useTPmethod_ + 2*useHITmethod_, sidecarConditions_));
+        sidecarRun_ = run; sidecarRunSet_ = true;
+     }
+     if( !produceDeadTowerEt_ ) fromSidecar = sidecar_->lookup(run, ls, iEvent.id().event(), evtTagged, nDeadTowersAboveCut);
+  }
+
+  if( useTPmethod_ && !fromSidecar ){
+     {
+        METFlagsStageTimer timer(stats_.get(), METFlagsStats::kLoad);
+        loadEcalDigis(iEvent, iSetup);
+     }
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kTPScan);
+     if( pTPDigis.isValid() ) evtTagged = setEvtTPstatus(nDeadTowersAboveCut);
+  }
+
+  if( useHITmethod_ && !fromSidecar ){
+     {
+        METFlagsStageTimer timer(stats_.get(), METFlagsStats::kLoad);
+        loadEcalRecHits(iEvent, iSetup);
+     }
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kHITScan);
+     if( barrelReducedRecHitsHandle.isValid() && endcapReducedRecHitsHandle.isValid() ) evtTagged = setEvtRecHitstatus(etValToBeFlagged_, 13, nDeadTowersAboveCut);
+  }
+
+  if( sidecar_.get() && !fromSidecar ) sidecar_->record(run, ls, iEvent.id().event(), evtTagged, nDeadTowersAboveCut);
+
+  if( evtTagged ){ pass = false; totFilteredCnt++; }
+
+  lumiProcessedCnt++; runProcessedCnt++;
+  if( evtTagged ){ lumiTaggedCnt++; runTaggedCnt++; }
+  if( skipBitmap_.get() ) skipBitmap_->tag(iEvent.id(), evtTagged);
+  lumiDeadTowersCnt += nDeadTowersAboveCut; runDeadTowersCnt += nDeadTowersAboveCut;
+
+  if( makeProfileRoot_ ){
+
+     cutFlowFlagTmpVec_.clear(); cutFlowStrTmpVec_.clear();
+     cutFlowFlagTmpVec_.push_back(evtTagged); cutFlowStrTmpVec_.push_back("TP");
+
+     cutFlowFlagTmpPtr = &cutFlowFlagTmpVec_;
+     cutFlowStrTmpPtr = &cutFlowStrTmpVec_;
+
+     profTree->Fill();
+  }
+
+  if(debug_ ){
+     int evtstatusABS = abs(evtTagged);
+     printf("\nrun : %8d  event : %10d  lumi : %4d  evtTPstatus  ABS : %d  13 : % 2d\n", run, event, ls, evtstatusABS, evtTagged);
+  }
+
+  std::unique_ptr<bool> pOut( new bool(pass) ); 
+  iEvent.put( std::move(pOut) );
+
+  if( produceDeadTowerEt_ ){
+     std::unique_ptr<double> maxEtPlusPtr( new double(deadTowerEtSummary_.maxEtPlus) );
+     std::unique_ptr<double> maxEtMinusPtr( new double(deadTowerEtSummary_.maxEtMinus) );
+     std::unique_ptr<unsigned int> nAboveFloorPtr( new unsigned int(deadTowerEtSummary_.nAboveFloor) );
+     std::unique_ptr<unsigned int> hottestPtr( new unsigned int(deadTowerEtSummary_.hottestRawId) );
+     iEvent.put( std::move(maxEtPlusPtr), "maxDeadTowerEtPlus" );
+     iEvent.put( std::move(maxEtMinusPtr), "maxDeadTowerEtMinus" );
+     iEvent.put( std::move(nAboveFloorPtr), "nDeadTowersAboveFloor" );
+     iEvent.put( std::move(hottestPtr), "hottestDeadTower" );
+  }
+
+  evtTimer.done(run, ls, !pass);
+
+  return taggingMode_ || pass; // return false if filtering and not enough tracks in event
+
+}
+
+// ------------ method called once each job just before starting event loop  ------------
+void EcalDeadCellEventFlagProducer::beginJob() { }
+
+// ------------ method called once each job just after ending the event loop  ------------
+void EcalDeadCellEventFlagProducer::endJob() {
+
+  edm::LogInfo("EcalDeadCellEventFlagProducer") << "Processed " << evtProcessedCnt << " events, tagged " << totFilteredCnt;
+
+  if( stats_.get() && !stats_->writeSummary(statsFileName_) ){
+     edm::LogWarning("EcalDeadCellEventFlagProducer") << "Cannot write the stats summary to " << statsFileName_;
+  }
+
+  if( sidecar_.get() ){
+     edm::LogInfo("EcalDeadCellEventFlagProducer") << "Sidecar hits : " << sidecar_->hits() << "  misses : " << sidecar_->misses();
+     if( !sidecar_->write() ) edm::LogWarning("EcalDeadCellEventFlagProducer") << "Cannot write the sidecar : " << sidecar_->error();
+  }
+}
+
+// ------------ method called once each run just before starting event loop  ------------
+void EcalDeadCellEventFlagProducer::beginRun(const edm::Run &run, const edm::EventSetup& iSetup) {
+// Channel status might change for each run (data)
+// Event setup
+  getChannelStatusMaps(iSetup);
+  buildDeadTowerTPScale(iSetup);
+  if( sidecar_.get() ){ sidecarConditions_ = sidecarConditionsHash(); sidecarRunSet_ = false; }
+  runProcessedCnt = runTaggedCnt = runDeadTowersCnt = 0;
+  if( debug_) edm::LogInfo("EcalDeadCellEventFlagProducer") << "EcalAllDeadChannels.size() : " << deadChannelTable_->size()
+                                                            << "  towers : " << deadChannelTable_->towers().size();
+}
+
+void EcalDeadCellEventFlagProducer::endRun(const edm::Run &run, const edm::EventSetup& iSetup) { }
+
+// ------------ method called once each run just after ending the event loop  ------------
+void EcalDeadCellEventFlagProducer::endRunProduce(edm::Run &run, const edm::EventSetup& iSetup) {
+
+  std::unique_ptr<unsigned int> processedPtr( new unsigned int(runProcessedCnt) );
+  std::unique_ptr<unsigned int> taggedPtr( new unsigned int(runTaggedCnt) );
+  std::unique_ptr<unsigned int> deadTowersPtr( new unsigned int(runDeadTowersCnt) );
+  run.put( std::move(processedPtr), "runProcessed" );
+  run.put( std::move(taggedPtr), "runTagged" );
+  run.put( std::move(deadTowersPtr), "runDeadTowersAboveThreshold" );
+}
+
+void EcalDeadCellEventFlagProducer::respondToOpenInputFile(const edm::FileBlock &fb) {
+  if( skipBitmap_.get() ) skipBitmap_->openFile(fb);
+}
+
+void EcalDeadCellEventFlagProducer::respondToCloseInputFile(const edm::FileBlock &fb) {
+  if( skipBitmap_.get() ) skipBitmap_->closeFile(fb);
+}
+
+void EcalDeadCellEventFlagProducer::beginLuminosityBlock(const edm::LuminosityBlock &lumi, const edm::EventSetup& iSetup) {
+  lumiProcessedCnt = lumiTaggedCnt = lumiDeadTowersCnt = 0;
+}
+
+void EcalDeadCellEventFlagProducer::endLuminosityBlock(const edm::LuminosityBlock &lumi, const edm::EventSetup& iSetup) { }
+
+void EcalDeadCellEventFlagProducer::endLuminosityBlockProduce(edm::LuminosityBlock &lumi, const edm::EventSetup& iSetup) {
+
+  std::unique_ptr<unsigned int> processedPtr( new unsigned int(lumiProcessedCnt) );
+  std::unique_ptr<unsigned int> taggedPtr( new unsigned int(lumiTaggedCnt) );
+  std::unique_ptr<unsigned int> deadTowersPtr( new unsigned int(lumiDeadTowersCnt) );
+  lumi.put( std::move(processedPtr), "lumiProcessed" );
+  lumi.put( std::move(taggedPtr), "lumiTagged" );
+  lumi.put( std::move(deadTowersPtr), "lumiDeadTowersAboveThreshold" );
+}
+
+int EcalDeadCellEventFlagProducer::setEvtRecHitstatus(const double &tpValCut, const int &towerTest, int &nTowersAboveCut){
+        
+  if( debug_ ) edm::LogInfo("EcalDeadCellEventFlagProducer") << "***begin setEvtTPstatusRecHits***";
+
+  deadTowerEtSum_.reset(*deadChannelTable_, deadChannels_, towerTest, doEEfilter_);
+
+  deadTowerEtSum_.addHits(barrelReducedRecHitsHandle->begin(), barrelReducedRecHitsHandle->end());
+// if NOT filtering on EE, skip EE subdet
+  if( doEEfilter_ ) deadTowerEtSum_.addHits(endcapReducedRecHitsHandle->begin(), endcapReducedRecHitsHandle->end());
+
+// Once per touched tower : crystals failing towerTest (EB ones only in debug) and incomplete towers
+  const std::vector<unsigned int> &touchedTowers = deadTowerEtSum_.touchedTowers();
+  for(unsigned int it=0; it<touchedTowers.size(); it++){
+     const EcalDeadChannelTable::Tower &tower = deadChannelTable_->towers()[touchedTowers[it]];
+     const int towerTestCnt = deadChannelTable_->towerTestCount(touchedTowers[it], towerTest);
+     if( towerTestCnt >0 && ( debug_ || deadChannelTable_->channels()[tower.channels[0]].subdet != 1 ) ){
+        edm::LogWarning("EcalDeadCellEventFlagProducer") << "towerTestCnt : " << towerTestCnt << "  for towerTest : " << towerTest;
+     }
+     int ttchnCnt = deadTowerEtSum_.towerChannelCount(touchedTowers[it]);
+     if( ttchnCnt != 25 ) edm::LogWarning("EcalDeadCellEventFlagProducer") << "ttchnCnt : " << ttchnCnt << "  NOT equal  25!";
+  }
+
+  int isPassCut = deadTowerEtSum_.evaluate(tpValCut, nTowersAboveCut, deadTowerEtFloor_, produceDeadTowerEt_ ? &deadTowerEtSummary_ : 0);
+
+  if( debug_ ) edm::LogInfo("EcalDeadCellEventFlagProducer") << "***end setEvtTPstatusRecHits***";
+
+  return isPassCut;
+
+}
+
+
+int EcalDeadCellEventFlagProducer::setEvtTPstatus(int &nTowersAboveCut){
+ 
+  if( debug_ ) edm::LogInfo("EcalDeadCellEventFlagProducer") << "***begin setEvtTPstatus***";
+
+// The codes of deadTowerTPScale_ are those of etValToBeFlagged_
+  EcalTPDigiSource tpSource(*pTPDigis.product(), *deadChannelTable_, deadTowerTPScale_);
+  int isPassCut = evaluateDeadCellTPEvent(*deadChannelTable_, deadChannels_, deadTowerTPScale_, tpSource, etValToBeFlagged_, doEEfilter_, nTowersAboveCut,
+                                          deadTowerEtFloor_, produceDeadTowerEt_ ? &deadTowerEtSummary_ : 0);
+
+  if( debug_ ) edm::LogInfo("EcalDeadCellEventFlagProducer") << "***end setEvtTPstatus***";
+
+  return isPassCut;
+}
+
+
+int EcalDeadCellEventFlagProducer::getChannelStatusMaps(const edm::EventSetup& iSetup){
+
+// Same table as the previous run : the selections are still valid
+  const bool changed = deadChannelTableSource_->update(iSetup);
+  deadChannelTable_ = &deadChannelTableSource_->table();
+  if( !changed ) return 0;
+  deadChannels_.build(*deadChannelTable_, 13);
+
+  return 1;
+}
+
+
+void EcalDeadCellEventFlagProducer::buildDeadTowerTPScale(const edm::EventSetup& iSetup){
+
+  tpScaleBuilder_.build(iSetup, *deadChannelTable_, etValToBeFlagged_, deadTowerTPScale_);
+
+  if( debug_ ){
+     const std::vector<EcalDeadChannelTable::Tower> &towers = deadChannelTable_->towers();
+     for(unsigned int it=0; it<towers.size(); it++){
+        edm::LogInfo("EcalDeadCellEventFlagProducer") << "tower " << towers[it].rawId << "  threshold code : " << deadTowerTPScale_.thresholdCode(it);
+     }
+  }
+}
+
+
+// Same table and same GeV value of every compressed Et of the dead towers : same decisions
+uint64_t EcalDeadCellEventFlagProducer::sidecarConditionsHash(){
+
+  uint64_t hash = deadChannelTable_->contentHash();
+
+  for(unsigned int it=0; it<deadTowerTPScale_.nTowers(); it++){
+     for(unsigned int adc=0; adc<EcalDeadTowerTPScale::nCodes; adc++) hash = metFlagsHashValue(deadTowerTPScale_.et(it, adc), hash);
+  }
+
+  return hash;
+}
+
+
+//define this as a plug-in
+DEFINE_FWK_MODULE(EcalDeadCellEventFlagProducer);
@@ -0,0 +1,54 @@
+#ifndef ECAL_DEAD_CELL_METHOD_SELECTOR_H
+#define ECAL_DEAD_CELL_METHOD_SELECTOR_H
+
+// selectDeadCellMethod from the provenance and the process history of the first event. Shared by
+// the plugins running the TP and recovered rechit methods; the warnings and the choice are logged
+// under the category of the calling module.
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/InputTag.h"
+#include "DataFormats/Provenance/interface/Provenance.h"
+#include "DataFormats/Provenance/interface/ProcessHistory.h"
+
+#include "MyAnalysis/METFlags/interface/EcalDeadCellAlgos.h"
+
+#include <string>
+#include <vector>
+
+inline EcalDeadCellMethod selectDeadCellMethod(const edm::Event &iEvent, const edm::InputTag &tpDigiCollection, const edm::InputTag &ebReducedRecHitCollection,
+                                               const edm::InputTag &eeReducedRecHitCollection, const std::string &category){
+
+  int hastpDigiCollection = 0, hasReducedRecHits = 0;
+
+  std::vector<edm::Provenance const*> provenances;
+  iEvent.getAllProvenance(provenances);
+  for(unsigned int ip = 0; ip < provenances.size(); ip++){
+     const std::string &label = provenances[ip]->moduleLabel();
+     if( label == tpDigiCollection.label() ) hastpDigiCollection = 1;
+     if( label == ebReducedRecHitCollection.label() || label == eeReducedRecHitCollection.label() ) hasReducedRecHits++;
+     if( hastpDigiCollection && hasReducedRecHits>=2 ) break;
+  }
+
+  const edm::ProcessHistory& history = iEvent.processHistory();
+// XXX: the last one is usually a USER process!
+  const std::string releaseVersion = history[history.size()-2].releaseVersion();
+
+  const EcalDeadCellMethod method = selectDeadCellMethod(hastpDigiCollection, hasReducedRecHits, releaseVersion);
+
+// Do NOT expect end-users provide ecalTPSkim or recovered rechits themselves!!
+  if( method == kDeadCellNoInput ){
+     edm::LogWarning(category) << "Cannot find either tpDigiCollection or the reduced rechits ?! Will NOT DO ANY FILTERING !";
+  }
+  if( method == kDeadCellHITBefore42X ){
+     edm::LogWarning(category) << "TP filter can ONLY be used in AOD after 42X.  Will NOT DO ANY FILTERING !";
+  }
+
+  edm::LogInfo(category) << "hastpDigiCollection : " << hastpDigiCollection << "  hasReducedRecHits : " << hasReducedRecHits
+                         << "  processName : " << history[history.size()-2].processName() << "  releaseVersion : " << releaseVersion
+                         << "  useTPmethod : " << ( method == kDeadCellTPMethod ) << "  useHITmethod : " << ( method == kDeadCellHITMethod );
+
+  return method;
+}
+
+#endif
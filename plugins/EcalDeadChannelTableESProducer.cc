@@ -0,0 +1,90 @@
+// -*- C++ -*-
+//
+// Package:    METFlags
+// Class:      EcalDeadChannelTableESProducer
+//
+/**\class EcalDeadChannelTableESProducer EcalDeadChannelTableESProducer.cc
+
+ Description: the EcalDeadChannelTable of the ECAL flag producers as an EventSetup product
+ The table is made by the framework as an EventSetup task when the channel status, the geometry or
+ the trigger tower map changes, instead of in the beginRun of every flag producer. With concurrent
+ IOVs (process.options.eventSetup.numberOfConcurrentIOVs) the table of the next IOV is made while
+ the events of the previous one still run. Every product is a new table: the tables already handed
+ out are never modified, and each one lives as long as its IOV is in use.
+ The flag producers read it when their deadChannelTableLabel names the appendToDataLabel of this
+ module, see python/EcalDeadChannelTableESProducer_cfi.py
+*/
+
+// system include files
+#include <memory>
+
+// user include files
+#include "FWCore/Framework/interface/ESProducer.h"
+#include "FWCore/Framework/interface/ModuleFactory.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include "CondFormats/EcalObjects/interface/EcalChannelStatus.h"
+#include "Geometry/CaloGeometry/interface/CaloGeometry.h"
+#include "Geometry/CaloTopology/interface/EcalTrigTowerConstituentsMap.h"
+
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTable.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTableBuilder.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTableRcd.h"
+
+class EcalDeadChannelTableESProducer : public edm::ESProducer {
+public:
+  explicit EcalDeadChannelTableESProducer(const edm::ParameterSet&);
+  ~EcalDeadChannelTableESProducer() override;
+
+  std::shared_ptr<EcalDeadChannelTable> produce(const EcalDeadChannelTableRcd&);
+
+private:
+  edm::ESGetToken<EcalChannelStatus, EcalChannelStatusRcd> ecalStatusToken_;
+  edm::ESGetToken<CaloGeometry, CaloGeometryRecord> geometryToken_;
+  edm::ESGetToken<EcalTrigTowerConstituentsMap, IdealGeometryRecord> ttMapToken_;
+
+// The framework does not run produce() of one ESProducer concurrently : the builder and the last
+// table are only touched by one IOV at a time
+  EcalDeadChannelTableBuilder tableBuilder_;
+  std::shared_ptr<const EcalDeadChannelTable> lastTable_;
+  unsigned long long geometryCacheId_, ttMapCacheId_;
+};
+
+
+EcalDeadChannelTableESProducer::EcalDeadChannelTableESProducer(const edm::ParameterSet& iConfig) :
+  tableBuilder_(iConfig.getParameter<int>("maskedEcalChannelStatusThreshold"), iConfig.getParameter<unsigned int>("statusMask")),
+  geometryCacheId_(0), ttMapCacheId_(0)
+{
+  edm::ESConsumesCollectorT<EcalDeadChannelTableRcd> cc = setWhatProduced(this);
+  ecalStatusToken_ = cc.consumesFrom<EcalChannelStatus, EcalChannelStatusRcd>();
+  geometryToken_ = cc.consumesFrom<CaloGeometry, CaloGeometryRecord>();
+  ttMapToken_ = cc.consumesFrom<EcalTrigTowerConstituentsMap, IdealGeometryRecord>();
+}
+
+
+EcalDeadChannelTableESProducer::~EcalDeadChannelTableESProducer() {}
+
+
+std::shared_ptr<EcalDeadChannelTable> EcalDeadChannelTableESProducer::produce(const EcalDeadChannelTableRcd& iRecord) {
+
+  const unsigned long long geometryCacheId = iRecord.getRecord<CaloGeometryRecord>().cacheIdentifier();
+  const unsigned long long ttMapCacheId = iRecord.getRecord<IdealGeometryRecord>().cacheIdentifier();
+  if( geometryCacheId != geometryCacheId_ || ttMapCacheId != ttMapCacheId_ ) tableBuilder_.reset();
+  geometryCacheId_ = geometryCacheId; ttMapCacheId_ = ttMapCacheId;
+
+// The next table starts from a copy of the last one, which the builder updates in place
+  std::shared_ptr<EcalDeadChannelTable> table( lastTable_.get() ? new EcalDeadChannelTable(*lastTable_) : new EcalDeadChannelTable );
+  tableBuilder_.update(iRecord.get(ecalStatusToken_), iRecord.get(geometryToken_), iRecord.get(ttMapToken_), *table);
+  lastTable_ = table;
+
+  const EcalDeadChannelTableBuilder::Diff &diff = tableBuilder_.diff();
+  edm::LogInfo("EcalDeadChannelTableESProducer") << "Dead channel table " << ( diff.full ? "built" : "updated" ) << " : " << diff.added << " added  "
+                                                 << diff.removed << " removed  " << diff.statusChanged << " status changed  -> "
+                                                 << table->size() << " channels";
+
+  return table;
+}
+
+//define this as a plug-in
+DEFINE_FWK_EVENTSETUP_MODULE(EcalDeadChannelTableESProducer);
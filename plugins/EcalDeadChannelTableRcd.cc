@@ -0,0 +1,10 @@
+// Registration of EcalDeadChannelTableRcd and of its EcalDeadChannelTable product, in a library of
+// their own so that the package library stays framework-free. Linked by the ESProducer and by the
+// flag producers that read the table.
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTableRcd.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTable.h"
+#include "FWCore/Framework/interface/eventsetuprecord_registration_macro.h"
+#include "FWCore/Utilities/interface/typelookup.h"
+
+EVENTSETUP_RECORD_REG(EcalDeadChannelTableRcd);
+TYPELOOKUP_DATA_REG(EcalDeadChannelTable);
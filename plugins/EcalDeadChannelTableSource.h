@@ -0,0 +1,101 @@
+#ifndef ECAL_DEAD_CHANNEL_TABLE_SOURCE_H
+#define ECAL_DEAD_CHANNEL_TABLE_SOURCE_H
+
+// Dead channel table of the run of a module : the EventSetup one (EcalDeadChannelTableESProducer)
+// when deadChannelTableLabel is set, one built by the module from the channel status otherwise.
+// update() is called at beginRun; the channel selections of the module are to be rebuilt when it
+// returns true. Shared by the plugins reading the masked ECAL channels.
+
+#include "FWCore/Framework/interface/ConsumesCollector.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/EDMException.h"
+#include "FWCore/Utilities/interface/ESGetToken.h"
+#include "FWCore/Utilities/interface/ESInputTag.h"
+#include "FWCore/Utilities/interface/Transition.h"
+#include "CondFormats/EcalObjects/interface/EcalChannelStatus.h"
+#include "CondFormats/DataRecord/interface/EcalChannelStatusRcd.h"
+#include "Geometry/CaloGeometry/interface/CaloGeometry.h"
+#include "Geometry/CaloTopology/interface/EcalTrigTowerConstituentsMap.h"
+#include "Geometry/Records/interface/CaloGeometryRecord.h"
+#include "Geometry/Records/interface/IdealGeometryRecord.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTable.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTableBuilder.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTableRcd.h"
+
+#include <string>
+
+class EcalDeadChannelTableSource {
+public:
+  // Channels with (status & statusMask) >= maskedEcalChannelStatusThreshold; category is the
+  // module name of the messages
+  EcalDeadChannelTableSource(edm::ConsumesCollector iC, const std::string &deadChannelTableLabel, int maskedEcalChannelStatusThreshold,
+                             unsigned int statusMask, const std::string &category) :
+    tableBuilder_(maskedEcalChannelStatusThreshold, statusMask), table_(&ownTable_), useESTable_(!deadChannelTableLabel.empty()),
+    statusCacheId_(0), geometryCacheId_(0), ttMapCacheId_(0), deadChannelTableCacheId_(0), category_(category) {
+
+// The conditions of the table are only consumed when the module builds it
+    if( useESTable_ ) deadChannelTableToken_ = iC.esConsumes<EcalDeadChannelTable, EcalDeadChannelTableRcd, edm::Transition::BeginRun>(edm::ESInputTag("", deadChannelTableLabel));
+    else {
+       ecalStatusToken_ = iC.esConsumes<EcalChannelStatus, EcalChannelStatusRcd, edm::Transition::BeginRun>();
+       geometryToken_ = iC.esConsumes<CaloGeometry, CaloGeometryRecord, edm::Transition::BeginRun>();
+       ttMapToken_ = iC.esConsumes<EcalTrigTowerConstituentsMap, IdealGeometryRecord, edm::Transition::BeginRun>();
+    }
+  }
+
+  // False when the table is that of the previous run. iSetup is that of beginRun
+  bool update(const edm::EventSetup &iSetup) {
+
+// Table made in the EventSetup : the previous one is left to the framework, which keeps it as long
+// as its IOV is in use
+    if( useESTable_ ){
+       table_ = &iSetup.getData(deadChannelTableToken_);
+       const unsigned long long deadChannelTableCacheId = iSetup.get<EcalDeadChannelTableRcd>().cacheIdentifier();
+       if( deadChannelTableCacheId == deadChannelTableCacheId_ ) return false;
+       deadChannelTableCacheId_ = deadChannelTableCacheId;
+// The table must select the channels the module would have selected
+       if( table_->maskedStatusThreshold() != tableBuilder_.maskedEcalChannelStatusThreshold() || table_->statusMask() != tableBuilder_.statusMask() ){
+          throw edm::Exception(edm::errors::Configuration) << category_ << " : the EventSetup dead channel table selects (status & " << std::hex << std::showbase
+                                                           << table_->statusMask() << std::dec << ") >= " << table_->maskedStatusThreshold()
+                                                           << ", the module (status & " << std::hex << tableBuilder_.statusMask() << std::dec << ") >= "
+                                                           << tableBuilder_.maskedEcalChannelStatusThreshold()
+                                                           << " : set the same maskedEcalChannelStatusThreshold and statusMask in EcalDeadChannelTableESProducer";
+       }
+       return true;
+    }
+
+// Same status payload and geometry as the previous run : the table is still valid
+    const unsigned long long statusCacheId = iSetup.get<EcalChannelStatusRcd>().cacheIdentifier();
+    const unsigned long long geometryCacheId = iSetup.get<CaloGeometryRecord>().cacheIdentifier();
+    const unsigned long long ttMapCacheId = iSetup.get<IdealGeometryRecord>().cacheIdentifier();
+    if( geometryCacheId != geometryCacheId_ || ttMapCacheId != ttMapCacheId_ ) tableBuilder_.reset();
+    else if( statusCacheId == statusCacheId_ ) return false;
+    statusCacheId_ = statusCacheId; geometryCacheId_ = geometryCacheId; ttMapCacheId_ = ttMapCacheId;
+
+    tableBuilder_.update(iSetup.getData(ecalStatusToken_), iSetup.getData(geometryToken_), iSetup.getData(ttMapToken_), ownTable_);
+
+    const EcalDeadChannelTableBuilder::Diff &diff = tableBuilder_.diff();
+    edm::LogInfo(category_) << "Dead channel table " << ( diff.full ? "built" : "updated" ) << " : " << diff.added << " added  "
+                            << diff.removed << " removed  " << diff.statusChanged << " status changed  -> "
+                            << ownTable_.size() << " channels";
+    return true;
+  }
+
+  const EcalDeadChannelTable& table() const { return *table_; }
+
+private:
+  edm::ESGetToken<EcalChannelStatus, EcalChannelStatusRcd> ecalStatusToken_;
+  edm::ESGetToken<CaloGeometry, CaloGeometryRecord> geometryToken_;
+  edm::ESGetToken<EcalTrigTowerConstituentsMap, IdealGeometryRecord> ttMapToken_;
+  edm::ESGetToken<EcalDeadChannelTable, EcalDeadChannelTableRcd> deadChannelTableToken_;
+
+// Rebuilt when the geometry changes, updated with the changed channels when only the status does
+  EcalDeadChannelTableBuilder tableBuilder_;
+  EcalDeadChannelTable ownTable_;
+  const EcalDeadChannelTable *table_;
+  bool useESTable_;
+  unsigned long long statusCacheId_, geometryCacheId_, ttMapCacheId_, deadChannelTableCacheId_;
+  std::string category_;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef ECAL_DEAD_TOWER_TP_SCALE_BUILDER_H
+#define ECAL_DEAD_TOWER_TP_SCALE_BUILDER_H
+
+// EcalDeadTowerTPScale of the dead towers of a table, built at beginRun from the TPG records.
+// EcalTPGScale::Tokens only consume for the event transition, so the records are read here with
+// BeginRun tokens and the GeV value of a compressed Et is that of EcalTPGScale::getTPGInGeV :
+// EtSat/1024 of the subdetector times the first linear code of the tower LUT giving the compressed Et.
+// Shared by the plugins evaluating the TP method.
+
+#include "FWCore/Framework/interface/ConsumesCollector.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Utilities/interface/ESGetToken.h"
+#include "FWCore/Utilities/interface/Transition.h"
+#include "DataFormats/DetId/interface/DetId.h"
+#include "DataFormats/EcalDetId/interface/EcalSubdetector.h"
+#include "DataFormats/EcalDetId/interface/EcalTrigTowerDetId.h"
+#include "CondFormats/EcalObjects/interface/EcalTPGPhysicsConst.h"
+#include "CondFormats/EcalObjects/interface/EcalTPGLutGroup.h"
+#include "CondFormats/EcalObjects/interface/EcalTPGLutIdMap.h"
+#include "CondFormats/DataRecord/interface/EcalTPGPhysicsConstRcd.h"
+#include "CondFormats/DataRecord/interface/EcalTPGLutGroupRcd.h"
+#include "CondFormats/DataRecord/interface/EcalTPGLutIdMapRcd.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTable.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadCellAlgos.h"
+
+#include <vector>
+
+class EcalDeadTowerTPScaleBuilder {
+public:
+  explicit EcalDeadTowerTPScaleBuilder(edm::ConsumesCollector iC) :
+    physConstToken_(iC.esConsumes<EcalTPGPhysicsConst, EcalTPGPhysicsConstRcd, edm::Transition::BeginRun>()),
+    lutGroupToken_(iC.esConsumes<EcalTPGLutGroup, EcalTPGLutGroupRcd, edm::Transition::BeginRun>()),
+    lutIdMapToken_(iC.esConsumes<EcalTPGLutIdMap, EcalTPGLutIdMapRcd, edm::Transition::BeginRun>()) {}
+
+  // Scale of the towers of table, threshold codes at etCut. iSetup is that of beginRun
+  void build(const edm::EventSetup &iSetup, const EcalDeadChannelTable &table, double etCut, EcalDeadTowerTPScale &scale) {
+
+    const EcalTPGPhysicsConstMap &physMap = iSetup.getData(physConstToken_).getMap();
+    const EcalTPGGroups::EcalTPGGroupsMap &lutGroups = iSetup.getData(lutGroupToken_).getMap();
+    const EcalTPGLutIdMap::EcalTPGLutMap &luts = iSetup.getData(lutIdMapToken_).getMap();
+
+    const std::vector<EcalDeadChannelTable::Tower> &towers = table.towers();
+    scale.reset(towers.size());
+    for(unsigned int it=0; it<towers.size(); it++){
+       const EcalTrigTowerDetId ttId(towers[it].rawId);
+
+       double lsb10bits = 0.;
+       EcalTPGPhysicsConstMap::const_iterator phys = physMap.find( DetId(DetId::Ecal, ttId.subDet() == EcalBarrel ? EcalBarrel : EcalEndcap).rawId() );
+       if( phys != physMap.end() ) lsb10bits = phys->second.EtSat/1024.;
+
+// Linear code of every compressed Et in one pass over the LUT : the first entry giving it, 0 if none
+       linear_.assign(EcalDeadTowerTPScale::nCodes, 0);
+       found_.assign(EcalDeadTowerTPScale::nCodes, 0);
+       EcalTPGGroups::EcalTPGGroupsMap::const_iterator group = lutGroups.find(ttId.rawId());
+       EcalTPGLutIdMap::EcalTPGLutMap::const_iterator lut = luts.find( group != lutGroups.end() ? group->second : 999 );
+       if( lut != luts.end() ){
+          const unsigned int *codes = lut->second.getLut();
+          for(unsigned int i=0; i<1024; i++){
+             const unsigned int code = 0xff & codes[i];
+             if( !found_[code] ){ linear_[code] = i; found_[code] = 1; }
+          }
+       }
+
+       for(unsigned int adc=0; adc<EcalDeadTowerTPScale::nCodes; adc++) scale.setEt(it, adc, lsb10bits*linear_[adc]);
+    }
+    scale.setCut(etCut);
+  }
+
+private:
+  edm::ESGetToken<EcalTPGPhysicsConst, EcalTPGPhysicsConstRcd> physConstToken_;
+  edm::ESGetToken<EcalTPGLutGroup, EcalTPGLutGroupRcd> lutGroupToken_;
+  edm::ESGetToken<EcalTPGLutIdMap, EcalTPGLutIdMapRcd> lutIdMapToken_;
+  std::vector<unsigned int> linear_;
+  std::vector<char> found_;
+};
+
+#endif
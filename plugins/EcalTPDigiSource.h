@@ -0,0 +1,40 @@
+#ifndef ECAL_TP_DIGI_SOURCE_H
+#define ECAL_TP_DIGI_SOURCE_H
+
+// TPSource of evaluateDeadCellTP / evaluateDeadCellTPCode : compressed Et of the TP digi of a dead
+// tower, and its Et in GeV from the scale built at beginRun. Shared by the
+// plugins evaluating the TP method on the same dead channel table.
+
+#include "DataFormats/EcalDigi/interface/EcalDigiCollections.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTable.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadCellAlgos.h"
+
+#include <stdint.h>
+
+class EcalTPDigiSource {
+public:
+  EcalTPDigiSource(const EcalTrigPrimDigiCollection &tpDigis, const EcalDeadChannelTable &table, const EcalDeadTowerTPScale &tpScale) :
+    tpDigis_(tpDigis), table_(table), tpScale_(tpScale) {}
+
+  bool findCode(uint32_t ttRawId, unsigned int &code) const {
+    EcalTrigPrimDigiCollection::const_iterator tp = tpDigis_.find( EcalTrigTowerDetId(ttRawId) );
+    if( tp == tpDigis_.end() ) return false;
+    code = tp->compressedEt();
+    return true;
+  }
+
+  bool findEt(uint32_t ttRawId, double &et) const {
+    const int tower = table_.towerIndex(ttRawId);
+    unsigned int code = 0;
+    if( tower < 0 || !findCode(ttRawId, code) ) return false;
+    et = tpScale_.et(tower, code);
+    return true;
+  }
+
+private:
+  const EcalTrigPrimDigiCollection &tpDigis_;
+  const EcalDeadChannelTable &table_;
+  const EcalDeadTowerTPScale &tpScale_;
+};
+
+#endif
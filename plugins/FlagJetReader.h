@@ -0,0 +1,80 @@
+#ifndef FLAG_JET_READER_H
+#define FLAG_JET_READER_H
+
+// Kinematics of the jets of an event as FlagJets, read through the collection type named by
+// jetCollectionType : "pf" (reco::PFJetCollection), "calo" (reco::CaloJetCollection), "pat"
+// (std::vector<pat::Jet>) or "view" (edm::View<reco::Jet>, any jet type, the default).
+// The pt(), eta() and phi() of the concrete jet types are final, so the loop over a concrete
+// collection has no virtual call; only "view" goes through reco::Jet per jet. The reader is
+// chosen once at construction, load() and the ValueMap filling are virtual once per event.
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/ConsumesCollector.h"
+#include "FWCore/Utilities/interface/InputTag.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include "DataFormats/Common/interface/View.h"
+#include "DataFormats/Common/interface/ValueMap.h"
+#include "DataFormats/JetReco/interface/Jet.h"
+#include "DataFormats/JetReco/interface/PFJetCollection.h"
+#include "DataFormats/JetReco/interface/CaloJetCollection.h"
+#include "DataFormats/PatCandidates/interface/Jet.h"
+
+#include "MyAnalysis/METFlags/interface/EcalDeadCellAlgos.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class FlagJetReader {
+ public:
+
+  virtual ~FlagJetReader() {}
+
+  // All the jets of the event, in the order of the collection
+  virtual void load(const edm::Event &iEvent, std::vector<FlagJet> &jets) = 0;
+
+  // Inserts one value per jet of the last load() into a ValueMap on the jet collection
+  virtual void insert(edm::ValueMap<float>::Filler &filler, const std::vector<float> &values) const = 0;
+  virtual void insert(edm::ValueMap<int>::Filler &filler, const std::vector<int> &values) const = 0;
+  virtual void insert(edm::ValueMap<unsigned int>::Filler &filler, const std::vector<unsigned int> &values) const = 0;
+
+  static std::unique_ptr<FlagJetReader> create(const std::string &jetCollectionType, const edm::InputTag &jetInputTag, edm::ConsumesCollector &&iC);
+};
+
+template<class Collection>
+class FlagJetReaderT : public FlagJetReader {
+ public:
+
+  FlagJetReaderT(const edm::InputTag &jetInputTag, edm::ConsumesCollector &iC) : token_(iC.consumes<Collection>(jetInputTag)) {}
+
+  void load(const edm::Event &iEvent, std::vector<FlagJet> &jets) override {
+    iEvent.getByToken(token_, jets_);
+    jets.clear();
+    jets.reserve(jets_->size());
+    for(typename Collection::const_iterator ij = jets_->begin(); ij != jets_->end(); ++ij){
+       FlagJet jet = { ij->pt(), ij->eta(), ij->phi() };
+       jets.push_back(jet);
+    }
+  }
+
+  void insert(edm::ValueMap<float>::Filler &filler, const std::vector<float> &values) const override { filler.insert(jets_, values.begin(), values.end()); }
+  void insert(edm::ValueMap<int>::Filler &filler, const std::vector<int> &values) const override { filler.insert(jets_, values.begin(), values.end()); }
+  void insert(edm::ValueMap<unsigned int>::Filler &filler, const std::vector<unsigned int> &values) const override { filler.insert(jets_, values.begin(), values.end()); }
+
+ private:
+
+  edm::EDGetTokenT<Collection> token_;
+  edm::Handle<Collection> jets_;
+};
+
+inline std::unique_ptr<FlagJetReader> FlagJetReader::create(const std::string &jetCollectionType, const edm::InputTag &jetInputTag, edm::ConsumesCollector &&iC){
+
+  if( jetCollectionType == "view" ) return std::unique_ptr<FlagJetReader>( new FlagJetReaderT<edm::View<reco::Jet> >(jetInputTag, iC) );
+  if( jetCollectionType == "pf" ) return std::unique_ptr<FlagJetReader>( new FlagJetReaderT<reco::PFJetCollection>(jetInputTag, iC) );
+  if( jetCollectionType == "calo" ) return std::unique_ptr<FlagJetReader>( new FlagJetReaderT<reco::CaloJetCollection>(jetInputTag, iC) );
+  if( jetCollectionType == "pat" ) return std::unique_ptr<FlagJetReader>( new FlagJetReaderT<std::vector<pat::Jet> >(jetInputTag, iC) );
+
+  throw cms::Exception("Configuration") << "Unknown jetCollectionType \"" << jetCollectionType << "\", expected view, pf, calo or pat";
+}
+
+#endif
@@ -0,0 +1,322 @@
+// -*- C++ -*-
+//
+// Package:    METFlags
+// Class:      LogErrorFlagProducer
+//
+/**\class LogErrorFlagProducer LogErrorFlagProducer.cc
+
+ Description: single-pass replacement for a sequence of LogErrorEventFilter instances
+ Every rule of the "rules" VPSet is the equivalent of one LogErrorEventFilter (categories and
+ modules to watch or to ignore). Category and module names are interned into small integer IDs
+ in hash maps at construction and every ID carries the bitmask of the rules that watch or ignore
+ it, so the logErrorHarvester output is scanned once per event with one hash lookup per name.
+ The event gets one bitword with bit i set when rule i matched; per-lumi and per-run counters
+ of processed and matched events are stored in the lumi and run products.
+*/
+//
+
+// system include files
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// user include files
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/one/EDFilter.h"
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/LuminosityBlock.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/MessageLogger/interface/ErrorSummaryEntry.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "MyAnalysis/METFlags/interface/METFlagsStats.h"
+
+class LogErrorFlagProducer : public edm::one::EDFilter<edm::one::WatchRuns, edm::one::WatchLuminosityBlocks, edm::EndRunProducer,
+                                                          edm::EndLuminosityBlockProducer> {
+public:
+  explicit LogErrorFlagProducer(const edm::ParameterSet&);
+  ~LogErrorFlagProducer();
+
+private:
+  bool filter(edm::Event&, const edm::EventSetup&) override;
+  void endJob() override;
+  void beginRun(const edm::Run&, const edm::EventSetup&) override;
+  void endRun(const edm::Run&, const edm::EventSetup&) override;
+  void endRunProduce(edm::Run&, const edm::EventSetup&) override;
+  void beginLuminosityBlock(const edm::LuminosityBlock&, const edm::EventSetup&) override;
+  void endLuminosityBlock(const edm::LuminosityBlock&, const edm::EventSetup&) override;
+  void endLuminosityBlockProduce(edm::LuminosityBlock&, const edm::EventSetup&) override;
+
+  // ----------member data ---------------------------
+
+  const bool taggingMode_;
+
+  bool debug_;
+
+  edm::InputTag src_;
+  edm::EDGetTokenT<std::vector<edm::ErrorSummaryEntry> > srcToken_;
+// If disabled, a missing src product is an error; otherwise no rule matches and it is reported once
+  bool allowMissingInputs_, warnedMissing_;
+
+// One bit per rule in the event bitword
+  static const unsigned int maxRules_ = 32;
+
+  std::vector<std::string> ruleNames_;
+  std::vector<double> maxErrorFractionInLumi_, maxErrorFractionInRun_;
+
+// Interned names: name -> ID, IDs given in order of first use
+  typedef std::unordered_map<std::string, unsigned int> NameIds;
+  NameIds categoryIds_, moduleIds_;
+// Per ID: bitmask of the rules that watch / ignore that name
+  std::vector<unsigned int> categoryWatchMask_, categoryIgnoreMask_;
+  std::vector<unsigned int> moduleWatchMask_, moduleIgnoreMask_;
+// Rules that do not restrict on categories / modules at all
+  unsigned int noCategoryWatchRules_, noModuleWatchRules_;
+
+  static int internName(const NameIds &ids, const std::string &name);
+  void compileRule(unsigned int bit, const edm::ParameterSet &rule);
+  static void addNames(const std::vector<std::string> &toAdd, NameIds &ids);
+
+  unsigned int matchRules(const std::vector<edm::ErrorSummaryEntry> &errors) const;
+
+// Counters: processed events and events matched per rule
+  unsigned int lumiProcessedCnt, runProcessedCnt, totProcessedCnt;
+  std::vector<unsigned int> lumiTaggedCnt, runTaggedCnt, totTaggedCnt;
+
+  void reportFractions(const char *where, unsigned int processed, const std::vector<unsigned int> &tagged, const std::vector<double> &maxFraction) const;
+
+// Stage timing and per-lumi counters, null unless enableStats
+  std::unique_ptr<METFlagsStats> stats_;
+  std::string statsFileName_;
+};
+
+
+static std::vector<std::string> getNamesOrEmpty(const edm::ParameterSet &pset, const std::string &name){
+  if( pset.existsAs<std::vector<std::string> >(name) ) return pset.getParameter<std::vector<std::string> >(name);
+  return std::vector<std::string>();
+}
+
+const unsigned int LogErrorFlagProducer::maxRules_;
+
+//
+// constructors and destructor
+//
+LogErrorFlagProducer::LogErrorFlagProducer(const edm::ParameterSet& iConfig) :
+  taggingMode_( iConfig.getParameter<bool>("taggingMode") ) {
+
+  debug_ = iConfig.getUntrackedParameter<bool>("debug", false);
+
+  src_ = iConfig.getParameter<edm::InputTag>("src");
+  srcToken_ = consumes<std::vector<edm::ErrorSummaryEntry> >(src_);
+  allowMissingInputs_ = iConfig.getUntrackedParameter<bool>("allowMissingInputs", true);
+  warnedMissing_ = false;
+
+  const std::vector<edm::ParameterSet> rules = iConfig.getParameter<std::vector<edm::ParameterSet> >("rules");
+  if( rules.empty() || rules.size() > maxRules_ ){
+     throw cms::Exception("Configuration") << "LogErrorFlagProducer: between 1 and " << maxRules_ << " rules are supported, got " << rules.size();
+  }
+
+// First collect every name used by any rule, then compile the per-rule masks
+  for(unsigned int ir=0; ir<rules.size(); ir++){
+     addNames(getNamesOrEmpty(rules[ir], "categoriesToWatch"), categoryIds_);
+     addNames(getNamesOrEmpty(rules[ir], "categoriesToIgnore"), categoryIds_);
+     addNames(getNamesOrEmpty(rules[ir], "modulesToWatch"), moduleIds_);
+     addNames(getNamesOrEmpty(rules[ir], "modulesToIgnore"), moduleIds_);
+  }
+
+  categoryWatchMask_.assign(categoryIds_.size(), 0); categoryIgnoreMask_.assign(categoryIds_.size(), 0);
+  moduleWatchMask_.assign(moduleIds_.size(), 0); moduleIgnoreMask_.assign(moduleIds_.size(), 0);
+  noCategoryWatchRules_ = 0; noModuleWatchRules_ = 0;
+
+  for(unsigned int ir=0; ir<rules.size(); ir++){ compileRule(ir, rules[ir]); }
+
+  lumiProcessedCnt = runProcessedCnt = totProcessedCnt = 0;
+  lumiTaggedCnt.assign(ruleNames_.size(), 0); runTaggedCnt.assign(ruleNames_.size(), 0); totTaggedCnt.assign(ruleNames_.size(), 0);
+
+  if( iConfig.getUntrackedParameter<bool>("enableStats", false) ){
+     const std::string label = iConfig.getParameter<std::string>("@module_label");
+     stats_.reset( new METFlagsStats(label) );
+     statsFileName_ = iConfig.getUntrackedParameter<std::string>("statsFileName", label + "_stats.json");
+  }
+
+  produces<unsigned int>();
+  produces<unsigned int, edm::Transition::EndLuminosityBlock>("lumiProcessed");
+  produces<std::vector<unsigned int>, edm::Transition::EndLuminosityBlock>("lumiRuleCounts");
+  produces<unsigned int, edm::Transition::EndRun>("runProcessed");
+  produces<std::vector<unsigned int>, edm::Transition::EndRun>("runRuleCounts");
+  produces<std::vector<std::string>, edm::Transition::EndRun>("ruleNames");
+}
+
+LogErrorFlagProducer::~LogErrorFlagProducer() { }
+
+void LogErrorFlagProducer::addNames(const std::vector<std::string> &toAdd, NameIds &ids){
+  for(unsigned int in=0; in<toAdd.size(); in++){
+     const unsigned int nextId = ids.size();
+     ids.insert(NameIds::value_type(toAdd[in], nextId));
+  }
+}
+
+int LogErrorFlagProducer::internName(const NameIds &ids, const std::string &name){
+  NameIds::const_iterator it = ids.find(name);
+  return it == ids.end() ? -1 : (int)it->second;
+}
+
+void LogErrorFlagProducer::compileRule(unsigned int bit, const edm::ParameterSet &rule){
+
+  const unsigned int mask = 1u << bit;
+
+  ruleNames_.push_back(rule.getParameter<std::string>("name"));
+  maxErrorFractionInLumi_.push_back(rule.existsAs<double>("maxErrorFractionInLumi") ? rule.getParameter<double>("maxErrorFractionInLumi") : 1.0);
+  maxErrorFractionInRun_.push_back(rule.existsAs<double>("maxErrorFractionInRun") ? rule.getParameter<double>("maxErrorFractionInRun") : 1.0);
+
+  const std::vector<std::string> catWatch = getNamesOrEmpty(rule, "categoriesToWatch");
+  const std::vector<std::string> catIgnore = getNamesOrEmpty(rule, "categoriesToIgnore");
+  const std::vector<std::string> modWatch = getNamesOrEmpty(rule, "modulesToWatch");
+  const std::vector<std::string> modIgnore = getNamesOrEmpty(rule, "modulesToIgnore");
+
+  if( catWatch.empty() ) noCategoryWatchRules_ |= mask;
+  if( modWatch.empty() ) noModuleWatchRules_ |= mask;
+
+  for(unsigned int in=0; in<catWatch.size(); in++) categoryWatchMask_[internName(categoryIds_, catWatch[in])] |= mask;
+  for(unsigned int in=0; in<catIgnore.size(); in++) categoryIgnoreMask_[internName(categoryIds_, catIgnore[in])] |= mask;
+  for(unsigned int in=0; in<modWatch.size(); in++) moduleWatchMask_[internName(moduleIds_, modWatch[in])] |= mask;
+  for(unsigned int in=0; in<modIgnore.size(); in++) moduleIgnoreMask_[internName(moduleIds_, modIgnore[in])] |= mask;
+}
+
+// One pass over the harvested errors: an entry matches rule i when its category is watched by
+// rule i (or rule i watches all categories), its module is watched by rule i (or rule i watches
+// all modules) and neither its category nor its module is ignored by rule i.
+unsigned int LogErrorFlagProducer::matchRules(const std::vector<edm::ErrorSummaryEntry> &errors) const {
+
+  const unsigned int allRules = ruleNames_.size() == maxRules_ ? ~0u : (1u << ruleNames_.size()) - 1;
+
+  unsigned int matched = 0;
+  for(std::vector<edm::ErrorSummaryEntry>::const_iterator it = errors.begin(); it != errors.end(); ++it){
+
+     const int catId = internName(categoryIds_, it->category);
+     const int modId = internName(moduleIds_, it->module);
+
+     unsigned int rules = allRules & ~matched;
+     rules &= noCategoryWatchRules_ | ( catId >=0 ? categoryWatchMask_[catId] : 0 );
+     rules &= noModuleWatchRules_ | ( modId >=0 ? moduleWatchMask_[modId] : 0 );
+     if( catId >=0 ) rules &= ~categoryIgnoreMask_[catId];
+     if( modId >=0 ) rules &= ~moduleIgnoreMask_[modId];
+
+     matched |= rules;
+     if( matched == allRules ) break;
+  }
+
+  return matched;
+}
+
+// ------------ method called on each new Event  ------------
+bool LogErrorFlagProducer::filter(edm::Event& iEvent, const edm::EventSetup& iSetup) {
+
+  METFlagsEventTimer evtTimer(stats_.get());
+
+  edm::Handle<std::vector<edm::ErrorSummaryEntry> > errors;
+  {
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kLoad);
+     iEvent.getByToken(srcToken_, errors);
+  }
+
+  unsigned int matched = 0;
+  if( errors.isValid() ){
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kRuleMatch);
+     matched = matchRules(*errors);
+  }else{
+     if( !allowMissingInputs_ ) throw cms::Exception("ProductNotFound") << "LogErrorFlagProducer: can't get " << src_.encode();
+     if( !warnedMissing_ ){
+        edm::LogWarning("LogErrorFlagProducer") << "Can't get the product " << src_.encode() << " ; no rule is evaluated for the events without it";
+        warnedMissing_ = true;
+     }
+  }
+
+  lumiProcessedCnt++; runProcessedCnt++; totProcessedCnt++;
+  for(unsigned int ir=0; ir<ruleNames_.size(); ir++){
+     if( matched & (1u << ir) ){ lumiTaggedCnt[ir]++; runTaggedCnt[ir]++; totTaggedCnt[ir]++; }
+  }
+
+  if( debug_ && matched ){
+     edm::LogInfo("LogErrorFlagProducer") << "run : " << iEvent.id().run() << "  event : " << iEvent.id().event()
+                                          << "  matched rules bitword : 0x" << std::hex << matched << std::dec;
+  }
+
+  std::unique_ptr<unsigned int> pOut( new unsigned int(matched) );
+  iEvent.put( std::move(pOut) );
+
+  evtTimer.done(iEvent.id().run(), iEvent.luminosityBlock(), matched != 0);
+
+  return taggingMode_ || matched == 0;
+}
+
+void LogErrorFlagProducer::reportFractions(const char *where, unsigned int processed, const std::vector<unsigned int> &tagged, const std::vector<double> &maxFraction) const {
+
+  if( !processed ) return;
+
+  for(unsigned int ir=0; ir<ruleNames_.size(); ir++){
+     const double fraction = double(tagged[ir])/processed;
+     if( fraction > maxFraction[ir] ){
+        edm::LogWarning("LogErrorFlagProducer") << "Rule " << ruleNames_[ir] << " matched " << tagged[ir] << " of " << processed
+                                                << " events in " << where << " (fraction " << fraction << " > " << maxFraction[ir] << ")";
+     }else if( debug_ ){
+        edm::LogInfo("LogErrorFlagProducer") << "Rule " << ruleNames_[ir] << " : " << tagged[ir] << " / " << processed << " in " << where;
+     }
+  }
+}
+
+// ------------ method called once each job just after ending the event loop  ------------
+void LogErrorFlagProducer::endJob() {
+  for(unsigned int ir=0; ir<ruleNames_.size(); ir++){
+     edm::LogInfo("LogErrorFlagProducer") << "Rule " << ruleNames_[ir] << " : " << totTaggedCnt[ir] << " / " << totProcessedCnt << " events";
+  }
+
+  if( stats_.get() && !stats_->writeSummary(statsFileName_) ){
+     edm::LogWarning("LogErrorFlagProducer") << "Cannot write the stats summary to " << statsFileName_;
+  }
+}
+
+void LogErrorFlagProducer::beginRun(const edm::Run &run, const edm::EventSetup& iSetup) {
+  runProcessedCnt = 0;
+  runTaggedCnt.assign(ruleNames_.size(), 0);
+}
+
+void LogErrorFlagProducer::endRun(const edm::Run &run, const edm::EventSetup& iSetup) {
+  reportFractions("run", runProcessedCnt, runTaggedCnt, maxErrorFractionInRun_);
+}
+
+void LogErrorFlagProducer::endRunProduce(edm::Run &run, const edm::EventSetup& iSetup) {
+
+  std::unique_ptr<unsigned int> processedPtr( new unsigned int(runProcessedCnt) );
+  std::unique_ptr<std::vector<unsigned int> > countsPtr( new std::vector<unsigned int>(runTaggedCnt) );
+  std::unique_ptr<std::vector<std::string> > namesPtr( new std::vector<std::string>(ruleNames_) );
+  run.put( std::move(processedPtr), "runProcessed" );
+  run.put( std::move(countsPtr), "runRuleCounts" );
+  run.put( std::move(namesPtr), "ruleNames" );
+}
+
+void LogErrorFlagProducer::beginLuminosityBlock(const edm::LuminosityBlock &lumi, const edm::EventSetup& iSetup) {
+  lumiProcessedCnt = 0;
+  lumiTaggedCnt.assign(ruleNames_.size(), 0);
+}
+
+void LogErrorFlagProducer::endLuminosityBlock(const edm::LuminosityBlock &lumi, const edm::EventSetup& iSetup) {
+  reportFractions("lumi", lumiProcessedCnt, lumiTaggedCnt, maxErrorFractionInLumi_);
+}
+
+void LogErrorFlagProducer::endLuminosityBlockProduce(edm::LuminosityBlock &lumi, const edm::EventSetup& iSetup) {
+
+  std::unique_ptr<unsigned int> processedPtr( new unsigned int(lumiProcessedCnt) );
+  std::unique_ptr<std::vector<unsigned int> > countsPtr( new std::vector<unsigned int>(lumiTaggedCnt) );
+  lumi.put( std::move(processedPtr), "lumiProcessed" );
+  lumi.put( std::move(countsPtr), "lumiRuleCounts" );
+}
+
+//define this as a plug-in
+DEFINE_FWK_MODULE(LogErrorFlagProducer);
@@ -0,0 +1,189 @@
+// -*- C++ -*-
+//
+// Package:    METFlags
+// Class:      METFlagBitwordProducer
+//
+/**\class METFlagBitwordProducer METFlagBitwordProducer.cc
+
+ Description: packs the configured MET flags of this package into one 64-bit word per event
+ Bit i of the event word is set when flag i tagged the event:
+   type "bool" : the flag producer stores a "pass" bool, the bit is set when it is false
+   type "int"  : the bit is set when the stored int differs from passValue
+   type "uint" : the bit is set when the stored word is non-zero (e.g. LogErrorFlagProducer)
+ The name of flag i is entry i of the "flagNames" run product; "tableVersion" identifies the
+ layout of that table so that readers can detect files written with a different flag list.
+*/
+//
+
+// system include files
+#include <memory>
+#include <string>
+#include <vector>
+
+// user include files
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/one/EDProducer.h"
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "MyAnalysis/METFlags/interface/METFlagsStats.h"
+
+class METFlagBitwordProducer : public edm::one::EDProducer<edm::EndRunProducer> {
+public:
+  explicit METFlagBitwordProducer(const edm::ParameterSet&);
+  ~METFlagBitwordProducer();
+
+// Layout version of the name-to-bit table; bump when the meaning of a bit changes
+  static const unsigned int tableFormatVersion = 1;
+
+private:
+  void produce(edm::Event&, const edm::EventSetup&) override;
+  void endRunProduce(edm::Run&, const edm::EventSetup&) override;
+  void endJob() override;
+
+  // ----------member data ---------------------------
+
+  enum FlagType { kBool, kInt, kUInt };
+
+  struct FlagInput {
+    std::string name;
+    edm::InputTag src;
+    FlagType type;
+// Only the token of the flag type is initialized
+    edm::EDGetTokenT<bool> boolToken;
+    edm::EDGetTokenT<int> intToken;
+    edm::EDGetTokenT<unsigned int> uintToken;
+    int passValue;
+    bool warnedMissing;
+  };
+
+  std::vector<FlagInput> flags_;
+
+  bool allowMissingInputs_;
+
+  unsigned int tableVersion_;
+
+  bool isTagged(const edm::Event& iEvent, FlagInput &flag);
+
+// Stage timing and per-lumi counters, null unless enableStats
+  std::unique_ptr<METFlagsStats> stats_;
+  std::string statsFileName_;
+};
+
+//
+// constructors and destructor
+//
+METFlagBitwordProducer::METFlagBitwordProducer(const edm::ParameterSet& iConfig) {
+
+  allowMissingInputs_ = iConfig.getUntrackedParameter<bool>("allowMissingInputs", true);
+
+  const std::vector<edm::ParameterSet> flags = iConfig.getParameter<std::vector<edm::ParameterSet> >("flags");
+  if( flags.empty() || flags.size() > 64 ){
+     throw cms::Exception("Configuration") << "METFlagBitwordProducer: between 1 and 64 flags are supported, got " << flags.size();
+  }
+
+// The version word combines the table format with a checksum of the flag names in bit order,
+// so two jobs with different flag lists never publish the same version
+  unsigned int nameChecksum = 0;
+  for(unsigned int ifl=0; ifl<flags.size(); ifl++){
+     FlagInput flag;
+     flag.name = flags[ifl].getParameter<std::string>("name");
+     flag.src = flags[ifl].getParameter<edm::InputTag>("src");
+     const std::string type = flags[ifl].getParameter<std::string>("type");
+     if( type == "bool" ){ flag.type = kBool; flag.boolToken = consumes<bool>(flag.src); }
+     else if( type == "int" ){ flag.type = kInt; flag.intToken = consumes<int>(flag.src); }
+     else if( type == "uint" ){ flag.type = kUInt; flag.uintToken = consumes<unsigned int>(flag.src); }
+     else throw cms::Exception("Configuration") << "METFlagBitwordProducer: unknown type \"" << type << "\" for flag " << flag.name;
+     flag.passValue = flags[ifl].existsAs<int>("passValue") ? flags[ifl].getParameter<int>("passValue") : 0;
+     flag.warnedMissing = false;
+     flags_.push_back(flag);
+
+     for(std::string::const_iterator ic = flag.name.begin(); ic != flag.name.end(); ++ic) nameChecksum = nameChecksum*31 + (unsigned char)(*ic);
+     nameChecksum = nameChecksum*31 + ifl;
+  }
+  tableVersion_ = (tableFormatVersion << 24) | (nameChecksum & 0xFFFFFF);
+
+  if( iConfig.getUntrackedParameter<bool>("enableStats", false) ){
+     const std::string label = iConfig.getParameter<std::string>("@module_label");
+     stats_.reset( new METFlagsStats(label) );
+     statsFileName_ = iConfig.getUntrackedParameter<std::string>("statsFileName", label + "_stats.json");
+  }
+
+  produces<unsigned long long>();
+  produces<std::vector<std::string>, edm::Transition::EndRun>("flagNames");
+  produces<unsigned int, edm::Transition::EndRun>("tableVersion");
+}
+
+METFlagBitwordProducer::~METFlagBitwordProducer() { }
+
+bool METFlagBitwordProducer::isTagged(const edm::Event& iEvent, FlagInput &flag){
+
+  bool found = false, tagged = false;
+
+  if( flag.type == kBool ){
+     edm::Handle<bool> h; iEvent.getByToken(flag.boolToken, h);
+     if( h.isValid() ){ found = true; tagged = !(*h); }
+  }else if( flag.type == kInt ){
+     edm::Handle<int> h; iEvent.getByToken(flag.intToken, h);
+     if( h.isValid() ){ found = true; tagged = (*h != flag.passValue); }
+  }else{
+     edm::Handle<unsigned int> h; iEvent.getByToken(flag.uintToken, h);
+     if( h.isValid() ){ found = true; tagged = (*h != 0); }
+  }
+
+  if( !found ){
+     if( !allowMissingInputs_ ) throw cms::Exception("ProductNotFound") << "METFlagBitwordProducer: flag " << flag.name << " : can't get " << flag.src.encode();
+     if( !flag.warnedMissing ){
+        edm::LogWarning("METFlagBitwordProducer") << "Can't get the product " << flag.src.encode() << " for flag " << flag.name << " ; its bit is left unset";
+        flag.warnedMissing = true;
+     }
+  }
+
+  return tagged;
+}
+
+// ------------ method called on each new Event  ------------
+void METFlagBitwordProducer::produce(edm::Event& iEvent, const edm::EventSetup& iSetup) {
+
+  METFlagsEventTimer evtTimer(stats_.get());
+
+  unsigned long long word = 0;
+  {
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kLoad);
+     for(unsigned int ifl=0; ifl<flags_.size(); ifl++){
+        if( isTagged(iEvent, flags_[ifl]) ) word |= (1ULL << ifl);
+     }
+  }
+
+  std::unique_ptr<unsigned long long> pOut( new unsigned long long(word) );
+  iEvent.put( std::move(pOut) );
+
+  evtTimer.done(iEvent.id().run(), iEvent.luminosityBlock(), word != 0);
+}
+
+// ------------ method called once each run just after ending the event loop  ------------
+void METFlagBitwordProducer::endRunProduce(edm::Run &run, const edm::EventSetup& iSetup) {
+
+  std::unique_ptr<std::vector<std::string> > namesPtr( new std::vector<std::string> );
+  for(unsigned int ifl=0; ifl<flags_.size(); ifl++) namesPtr->push_back(flags_[ifl].name);
+  std::unique_ptr<unsigned int> versionPtr( new unsigned int(tableVersion_) );
+
+  run.put( std::move(namesPtr), "flagNames" );
+  run.put( std::move(versionPtr), "tableVersion" );
+}
+
+// ------------ method called once each job just after ending the event loop  ------------
+void METFlagBitwordProducer::endJob() {
+  if( stats_.get() && !stats_->writeSummary(statsFileName_) ){
+     edm::LogWarning("METFlagBitwordProducer") << "Cannot write the stats summary to " << statsFileName_;
+  }
+}
+
+//define this as a plug-in
+DEFINE_FWK_MODULE(METFlagBitwordProducer);
@@ -0,0 +1,233 @@
+// -*- C++ -*-
+//
+// Package:    METFlags
+// Class:      METFlagsFixtureRecorder
+//
+/**\class METFlagsFixtureRecorder METFlagsFixtureRecorder.cc
+
+ Description: records the inputs of the MET flag algorithms into a replay fixture
+ The dead channel table of the first run, and per event the TP digis (with their Et from the TPG
+ scale), the reduced rechits, the jets, the MET and the CSC rechit positions of the cosmic
+ stand-alone tracks are written at endJob to fixtureName, to be replayed by metFlagsReplayBenchmark.
+ Missing collections are recorded as empty.
+*/
+//
+
+// system include files
+#include <memory>
+
+// user include files
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/ESHandle.h"
+
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include "DataFormats/EcalRecHit/interface/EcalRecHitCollections.h"
+#include "DataFormats/EcalDigi/interface/EcalDigiCollections.h"
+#include "DataFormats/JetReco/interface/Jet.h"
+#include "DataFormats/METReco/interface/MET.h"
+#include "DataFormats/TrackReco/interface/Track.h"
+#include "DataFormats/TrackReco/interface/TrackExtra.h"
+#include "DataFormats/MuonDetId/interface/MuonSubdetId.h"
+
+#include "CondFormats/EcalObjects/interface/EcalChannelStatus.h"
+#include "CondFormats/DataRecord/interface/EcalChannelStatusRcd.h"
+#include "CalibCalorimetry/EcalTPGTools/interface/EcalTPGScale.h"
+#include "Geometry/CaloTopology/interface/EcalTrigTowerConstituentsMap.h"
+#include "Geometry/Records/interface/IdealGeometryRecord.h"
+#include "Geometry/CaloGeometry/interface/CaloGeometry.h"
+#include "Geometry/Records/interface/CaloGeometryRecord.h"
+#include "Geometry/CSCGeometry/interface/CSCGeometry.h"
+#include "Geometry/Records/interface/MuonGeometryRecord.h"
+
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTableBuilder.h"
+#include "MyAnalysis/METFlags/interface/METFlagsReplayFixture.h"
+
+class METFlagsFixtureRecorder : public edm::one::EDAnalyzer<edm::one::WatchRuns> {
+public:
+  explicit METFlagsFixtureRecorder(const edm::ParameterSet&);
+  ~METFlagsFixtureRecorder();
+
+private:
+  void analyze(const edm::Event&, const edm::EventSetup&) override;
+  void beginRun(const edm::Run&, const edm::EventSetup&) override;
+  void endRun(const edm::Run&, const edm::EventSetup&) override {}
+  void endJob() override;
+
+  // ----------member data ---------------------------
+
+  edm::InputTag tpDigiCollection_;
+  edm::InputTag ebReducedRecHitCollection_;
+  edm::InputTag eeReducedRecHitCollection_;
+  edm::InputTag jetInputTag_;
+  edm::InputTag metInputTag_;
+  edm::InputTag SACosmicMuonLabel_;
+
+  edm::EDGetTokenT<EcalTrigPrimDigiCollection> tpDigiToken_;
+  edm::EDGetTokenT<EcalRecHitCollection> ebReducedRecHitToken_, eeReducedRecHitToken_;
+  edm::EDGetTokenT<edm::View<reco::Jet> > jetToken_;
+  edm::EDGetTokenT<edm::View<reco::MET> > metToken_;
+  edm::EDGetTokenT<reco::TrackCollection> SACosmicMuonToken_;
+
+  edm::ESGetToken<EcalChannelStatus, EcalChannelStatusRcd> ecalStatusToken_;
+  edm::ESGetToken<CaloGeometry, CaloGeometryRecord> geometryToken_;
+  edm::ESGetToken<EcalTrigTowerConstituentsMap, IdealGeometryRecord> ttMapToken_;
+  edm::ESGetToken<CSCGeometry, MuonGeometryRecord> cscGeometryToken_;
+  EcalTPGScale::Tokens tpgScaleTokens_;
+
+  int maskedEcalChannelStatusThreshold_;
+  unsigned int statusMask_;
+
+  std::string fixtureName_;
+  int maxEvents_;
+
+  bool tableRecorded_;
+
+  METFlagsReplayFixture fixture_;
+
+  void recordHits(const edm::Event& iEvent, const edm::EDGetTokenT<EcalRecHitCollection> &token, std::vector<ReplayRecHit> &hits);
+};
+
+METFlagsFixtureRecorder::METFlagsFixtureRecorder(const edm::ParameterSet& iConfig) :
+  tpgScaleTokens_( consumesCollector() ) {
+
+  tpDigiCollection_ = iConfig.getParameter<edm::InputTag>("tpDigiCollection");
+  ebReducedRecHitCollection_ = iConfig.getParameter<edm::InputTag>("ebReducedRecHitCollection");
+  eeReducedRecHitCollection_ = iConfig.getParameter<edm::InputTag>("eeReducedRecHitCollection");
+  jetInputTag_ = iConfig.getParameter<edm::InputTag>("jetInputTag");
+  metInputTag_ = iConfig.getParameter<edm::InputTag>("metInputTag");
+  SACosmicMuonLabel_ = iConfig.getParameter<edm::InputTag>("SACosmicMuonLabel");
+
+  tpDigiToken_ = consumes<EcalTrigPrimDigiCollection>(tpDigiCollection_);
+  ebReducedRecHitToken_ = consumes<EcalRecHitCollection>(ebReducedRecHitCollection_);
+  eeReducedRecHitToken_ = consumes<EcalRecHitCollection>(eeReducedRecHitCollection_);
+  jetToken_ = consumes<edm::View<reco::Jet> >(jetInputTag_);
+  metToken_ = consumes<edm::View<reco::MET> >(metInputTag_);
+  SACosmicMuonToken_ = consumes<reco::TrackCollection>(SACosmicMuonLabel_);
+
+  ecalStatusToken_ = esConsumes<EcalChannelStatus, EcalChannelStatusRcd, edm::Transition::BeginRun>();
+  geometryToken_ = esConsumes<CaloGeometry, CaloGeometryRecord, edm::Transition::BeginRun>();
+  ttMapToken_ = esConsumes<EcalTrigTowerConstituentsMap, IdealGeometryRecord, edm::Transition::BeginRun>();
+  cscGeometryToken_ = esConsumes<CSCGeometry, MuonGeometryRecord>();
+
+  maskedEcalChannelStatusThreshold_ = iConfig.getParameter<int>("maskedEcalChannelStatusThreshold");
+  statusMask_ = iConfig.getParameter<unsigned int>("statusMask");
+
+  fixtureName_ = iConfig.getUntrackedParameter<std::string>("fixtureName");
+  maxEvents_ = iConfig.getUntrackedParameter<int>("maxEvents", -1);
+
+  tableRecorded_ = false;
+}
+
+METFlagsFixtureRecorder::~METFlagsFixtureRecorder() { }
+
+void METFlagsFixtureRecorder::beginRun(const edm::Run &run, const edm::EventSetup& iSetup) {
+
+// A fixture holds a single table : the one of the first run
+  if( tableRecorded_ ) return;
+
+  EcalDeadChannelTableBuilder builder(maskedEcalChannelStatusThreshold_, statusMask_);
+  builder.build(iSetup.getData(ecalStatusToken_), iSetup.getData(geometryToken_), iSetup.getData(ttMapToken_), fixture_.table);
+
+  tableRecorded_ = true;
+}
+
+void METFlagsFixtureRecorder::recordHits(const edm::Event& iEvent, const edm::EDGetTokenT<EcalRecHitCollection> &token, std::vector<ReplayRecHit> &hits){
+
+  edm::Handle<EcalRecHitCollection> hitsHandle;
+  iEvent.getByToken(token, hitsHandle);
+  if( !hitsHandle.isValid() ) return;
+
+  hits.reserve(hitsHandle->size());
+  for(EcalRecHitCollection::const_iterator it = hitsHandle->begin(); it != hitsHandle->end(); ++it){
+     ReplayRecHit hit = { it->id().rawId(), it->energy(), it->isRecovered() };
+     hits.push_back(hit);
+  }
+}
+
+void METFlagsFixtureRecorder::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup) {
+
+  if( maxEvents_ >= 0 && (int)fixture_.events.size() >= maxEvents_ ) return;
+
+  fixture_.events.push_back(METFlagsReplayEvent());
+  METFlagsReplayEvent &evt = fixture_.events.back();
+
+  evt.run = iEvent.id().run();
+  evt.lumi = iEvent.luminosityBlock();
+  evt.event = iEvent.id().event();
+
+  edm::Handle<EcalTrigPrimDigiCollection> tpDigis;
+  iEvent.getByToken(tpDigiToken_, tpDigis);
+  if( tpDigis.isValid() ){
+     const EcalTPGScale ecalScale(tpgScaleTokens_, iSetup);
+     evt.tps.reserve(tpDigis->size());
+     for(EcalTrigPrimDigiCollection::const_iterator tp = tpDigis->begin(); tp != tpDigis->end(); ++tp){
+        ReplayTP rtp;
+        rtp.ttRawId = tp->id().rawId();
+        rtp.compressedEt = tp->compressedEt();
+        rtp.et = ecalScale.getTPGInGeV( tp->compressedEt(), tp->id() );
+        evt.tps.push_back(rtp);
+     }
+     std::sort(evt.tps.begin(), evt.tps.end());
+  }
+
+  recordHits(iEvent, ebReducedRecHitToken_, evt.ebHits);
+  recordHits(iEvent, eeReducedRecHitToken_, evt.eeHits);
+
+  edm::Handle<edm::View<reco::Jet> > jets;
+  iEvent.getByToken(jetToken_, jets);
+  if( jets.isValid() ){
+     for(edm::View<reco::Jet>::const_iterator ij = jets->begin(); ij != jets->end(); ++ij){
+        FlagJet jet = { ij->pt(), ij->eta(), ij->phi() };
+        evt.jets.push_back(jet);
+     }
+  }
+
+  edm::Handle<edm::View<reco::MET> > met;
+  iEvent.getByToken(metToken_, met);
+  evt.metPt = 0; evt.metPhi = 0;
+  if( met.isValid() && !met->empty() ){ evt.metPt = (*met)[0].pt(); evt.metPhi = (*met)[0].phi(); }
+
+  edm::Handle<reco::TrackCollection> cosmics;
+  iEvent.getByToken(SACosmicMuonToken_, cosmics);
+  if( cosmics.isValid() ){
+     const edm::ESHandle<CSCGeometry> cscGeometry = iSetup.getHandle(cscGeometryToken_);
+
+     for(reco::TrackCollection::const_iterator iTrack = cosmics->begin(); iTrack != cosmics->end(); ++iTrack){
+        ReplayCosmicTrack trk;
+        trk.outerMomentumTheta = iTrack->outerMomentum().theta();
+        trk.normChi2 = iTrack->normalizedChi2();
+        for(unsigned int j = 0; j < iTrack->extra()->recHits().size(); j++){
+           edm::Ref<TrackingRecHitCollection> hit( iTrack->extra()->recHits(), j );
+           if( !hit->isValid() ) continue;
+           DetId detId(hit->geographicalId());
+           if( detId.det() != DetId::Muon || detId.subdetId() != MuonSubdetId::CSC ) continue;
+           const GlobalPoint pos = cscGeometry->idToDetUnit(detId)->surface().toGlobal(hit->localPosition());
+           CSCHitPosition position = { pos.x(), pos.y(), pos.z() };
+           trk.hits.push_back(position);
+        }
+        evt.tracks.push_back(trk);
+     }
+  }
+}
+
+void METFlagsFixtureRecorder::endJob() {
+
+  if( !fixture_.write(fixtureName_) ){
+     edm::LogError("METFlagsFixtureRecorder") << "Failed to write the replay fixture : " << fixture_.error();
+     return;
+  }
+  edm::LogInfo("METFlagsFixtureRecorder") << "Wrote " << fixture_.events.size() << " events and " << fixture_.table.size()
+                                          << " masked channels to " << fixtureName_;
+}
+
+//define this as a plug-in
+DEFINE_FWK_MODULE(METFlagsFixtureRecorder);
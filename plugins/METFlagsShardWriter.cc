@@ -0,0 +1,238 @@
+// -*- C++ -*-
+//
+// Package:    METFlags
+// Class:      METFlagsShardWriter
+//
+/**\class METFlagsShardWriter METFlagsShardWriter.cc
+
+ Description: writes the flag results of one shard of a sharded reprocessing into a flat ROOT file
+ Trees (see scripts/metFlagsShardedReprocess.py and bin/metFlagsMergeShards.cpp):
+   events : run, lumi, event, bitword (METFlagBitwordProducer), fileIndex, seq
+   lumis  : run, lumi, values (the unsigned int lumi products of lumiSummaries, in that order)
+   runs   : run, tableVersion, flagNames (the run products of the bitword producer)
+   meta   : summaryNames (the encoded lumiSummaries tags), one entry
+ fileIndex is the position of the input file in the full, unsharded file list (fileIndices gives it
+ for each entry of fileNames, which must be the fileNames of the source) and seq the position of
+ the event among the events of its (file, run, lumi). The source processes the lumis of a file in
+ (run, lumi) order, so sorting all shards by (fileIndex, run, lumi, seq) gives the order of a
+ serial job over the full file list, whatever the lumi ranges of the shards.
+*/
+//
+
+// system include files
+#include <memory>
+#include <map>
+#include <string>
+#include <vector>
+
+// user include files
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/LuminosityBlock.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/FileBlock.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "TFile.h"
+#include "TTree.h"
+
+class METFlagsShardWriter : public edm::one::EDAnalyzer<edm::one::WatchRuns, edm::one::WatchLuminosityBlocks, edm::one::WatchInputFiles> {
+public:
+  explicit METFlagsShardWriter(const edm::ParameterSet&);
+  ~METFlagsShardWriter();
+
+private:
+  void analyze(const edm::Event&, const edm::EventSetup&) override;
+  void beginLuminosityBlock(const edm::LuminosityBlock&, const edm::EventSetup&) override {}
+  void endLuminosityBlock(const edm::LuminosityBlock&, const edm::EventSetup&) override;
+  void beginRun(const edm::Run&, const edm::EventSetup&) override {}
+  void endRun(const edm::Run&, const edm::EventSetup&) override;
+  void respondToOpenInputFile(const edm::FileBlock&) override;
+  void respondToCloseInputFile(const edm::FileBlock&) override {}
+  void endJob() override;
+
+  // ----------member data ---------------------------
+
+  edm::InputTag bitwordSrc_;
+  std::vector<edm::InputTag> lumiSummaries_;
+  edm::EDGetTokenT<unsigned long long> bitwordToken_;
+  std::vector<edm::EDGetTokenT<unsigned int> > lumiSummaryTokens_;
+  edm::EDGetTokenT<std::vector<std::string> > flagNamesToken_;
+  edm::EDGetTokenT<unsigned int> tableVersionToken_;
+  std::vector<std::string> summaryNames_;
+  std::vector<bool> warnedMissingSummary_;
+
+// Input files of this shard and their position in the full file list
+  std::vector<std::string> fileNames_;
+  std::vector<unsigned int> fileIndices_;
+  unsigned int nFilesOpened_;
+  unsigned int currentFileIndex_;
+
+// Events already seen per (fileIndex, run, lumi)
+  typedef std::pair<unsigned int, std::pair<unsigned int, unsigned int> > BlockKey;
+  std::map<BlockKey, unsigned int> blockCounts_;
+
+  std::string outputFileName_;
+  TFile *outFile;
+  TTree *eventsTree, *lumisTree, *runsTree, *metaTree;
+
+// Branch buffers
+  unsigned int run, lumi, fileIndex, seq, tableVersion;
+  ULong64_t event, bitword;
+  std::vector<unsigned int> summaryValues, *summaryValuesPtr;
+  std::vector<std::string> flagNames, *flagNamesPtr, *summaryNamesPtr;
+};
+
+namespace {
+  std::string baseName(const std::string &name){
+    const std::string::size_type slash = name.rfind('/');
+    return slash == std::string::npos ? name : name.substr(slash + 1);
+  }
+}
+
+//
+// constructors and destructor
+//
+METFlagsShardWriter::METFlagsShardWriter(const edm::ParameterSet& iConfig) {
+
+  bitwordSrc_ = iConfig.getParameter<edm::InputTag>("bitwordSrc");
+  lumiSummaries_ = iConfig.getParameter<std::vector<edm::InputTag> >("lumiSummaries");
+  for(unsigned int is=0; is<lumiSummaries_.size(); is++) summaryNames_.push_back(lumiSummaries_[is].encode());
+  warnedMissingSummary_.assign(lumiSummaries_.size(), false);
+
+  bitwordToken_ = consumes<unsigned long long>(bitwordSrc_);
+  for(unsigned int is=0; is<lumiSummaries_.size(); is++) lumiSummaryTokens_.push_back(consumes<unsigned int, edm::InLumi>(lumiSummaries_[is]));
+  flagNamesToken_ = consumes<std::vector<std::string>, edm::InRun>(edm::InputTag(bitwordSrc_.label(), "flagNames"));
+  tableVersionToken_ = consumes<unsigned int, edm::InRun>(edm::InputTag(bitwordSrc_.label(), "tableVersion"));
+
+  fileNames_ = iConfig.getUntrackedParameter<std::vector<std::string> >("fileNames");
+  fileIndices_ = iConfig.getUntrackedParameter<std::vector<unsigned int> >("fileIndices");
+  if( !fileIndices_.empty() && fileIndices_.size() != fileNames_.size() ){
+     throw cms::Exception("Configuration") << "METFlagsShardWriter: " << fileIndices_.size() << " fileIndices for " << fileNames_.size() << " fileNames";
+  }
+  nFilesOpened_ = 0; currentFileIndex_ = 0;
+
+  outputFileName_ = iConfig.getUntrackedParameter<std::string>("outputFileName");
+
+  outFile = new TFile(outputFileName_.c_str(), "RECREATE");
+  if( outFile->IsZombie() ) throw cms::Exception("Configuration") << "METFlagsShardWriter: cannot create " << outputFileName_;
+
+  eventsTree = new TTree("events", "flag results per event");
+  eventsTree->Branch("run", &run, "run/i");
+  eventsTree->Branch("lumi", &lumi, "lumi/i");
+  eventsTree->Branch("event", &event, "event/l");
+  eventsTree->Branch("bitword", &bitword, "bitword/l");
+  eventsTree->Branch("fileIndex", &fileIndex, "fileIndex/i");
+  eventsTree->Branch("seq", &seq, "seq/i");
+
+  summaryValuesPtr = &summaryValues;
+  lumisTree = new TTree("lumis", "lumi summaries");
+  lumisTree->Branch("run", &run, "run/i");
+  lumisTree->Branch("lumi", &lumi, "lumi/i");
+  lumisTree->Branch("values", &summaryValuesPtr);
+
+  flagNamesPtr = &flagNames;
+  runsTree = new TTree("runs", "bitword layout per run");
+  runsTree->Branch("run", &run, "run/i");
+  runsTree->Branch("tableVersion", &tableVersion, "tableVersion/i");
+  runsTree->Branch("flagNames", &flagNamesPtr);
+
+  summaryNamesPtr = &summaryNames_;
+  metaTree = new TTree("meta", "names of the lumi summaries");
+  metaTree->Branch("summaryNames", &summaryNamesPtr);
+}
+
+METFlagsShardWriter::~METFlagsShardWriter() {
+  delete outFile;
+}
+
+void METFlagsShardWriter::respondToOpenInputFile(const edm::FileBlock &fb) {
+
+// The name of the file block may be the physical name of a logical one in fileNames
+  const std::string name = fb.fileName();
+  int found = -1;
+  for(unsigned int ifl=0; ifl<fileNames_.size() && found<0; ifl++) if( fileNames_[ifl] == name ) found = ifl;
+  for(unsigned int ifl=0; ifl<fileNames_.size() && found<0; ifl++) if( baseName(fileNames_[ifl]) == baseName(name) ) found = ifl;
+  if( found < 0 ){
+     found = nFilesOpened_;
+     edm::LogWarning("METFlagsShardWriter") << name << " is not in fileNames, assuming it is input file " << found;
+  }
+  nFilesOpened_++;
+
+  currentFileIndex_ = (unsigned int)found < fileIndices_.size() ? fileIndices_[found] : found;
+}
+
+// ------------ method called on each new Event  ------------
+void METFlagsShardWriter::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup) {
+
+  edm::Handle<unsigned long long> bitwordHandle;
+  iEvent.getByToken(bitwordToken_, bitwordHandle);
+  if( !bitwordHandle.isValid() ) throw cms::Exception("ProductNotFound") << "METFlagsShardWriter: can't get " << bitwordSrc_.encode();
+
+  run = iEvent.id().run();
+  lumi = iEvent.luminosityBlock();
+  event = iEvent.id().event();
+  bitword = *bitwordHandle;
+  fileIndex = currentFileIndex_;
+  seq = blockCounts_[ std::make_pair(fileIndex, std::make_pair(run, lumi)) ]++;
+
+  eventsTree->Fill();
+}
+
+// ------------ the consumed lumi products of the flag producers are put before this module's endLuminosityBlock  ------------
+void METFlagsShardWriter::endLuminosityBlock(const edm::LuminosityBlock &iLumi, const edm::EventSetup& iSetup) {
+
+  run = iLumi.run();
+  lumi = iLumi.luminosityBlock();
+
+  summaryValues.assign(lumiSummaries_.size(), 0);
+  for(unsigned int is=0; is<lumiSummaries_.size(); is++){
+     edm::Handle<unsigned int> h;
+     iLumi.getByToken(lumiSummaryTokens_[is], h);
+     if( h.isValid() ) summaryValues[is] = *h;
+     else if( !warnedMissingSummary_[is] ){
+        edm::LogWarning("METFlagsShardWriter") << "Can't get the lumi product " << summaryNames_[is] << " ; stored as 0";
+        warnedMissingSummary_[is] = true;
+     }
+  }
+
+  lumisTree->Fill();
+}
+
+void METFlagsShardWriter::endRun(const edm::Run &iRun, const edm::EventSetup& iSetup) {
+
+  run = iRun.run();
+
+  edm::Handle<std::vector<std::string> > namesHandle;
+  edm::Handle<unsigned int> versionHandle;
+  iRun.getByToken(flagNamesToken_, namesHandle);
+  iRun.getByToken(tableVersionToken_, versionHandle);
+
+  flagNames.clear(); tableVersion = 0;
+  if( namesHandle.isValid() ) flagNames = *namesHandle;
+  if( versionHandle.isValid() ) tableVersion = *versionHandle;
+
+  runsTree->Fill();
+}
+
+// ------------ method called once each job just after ending the event loop  ------------
+void METFlagsShardWriter::endJob() {
+
+  metaTree->Fill();
+
+  edm::LogInfo("METFlagsShardWriter") << "Writing " << eventsTree->GetEntries() << " events, " << lumisTree->GetEntries() << " lumis to " << outputFileName_;
+
+// The trees belong to the file and are gone after Close()
+  outFile->cd();
+  eventsTree->Write(); lumisTree->Write(); runsTree->Write(); metaTree->Write();
+  outFile->Close();
+}
+
+//define this as a plug-in
+DEFINE_FWK_MODULE(METFlagsShardWriter);
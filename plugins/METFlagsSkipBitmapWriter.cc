@@ -0,0 +1,95 @@
+#include "MyAnalysis/METFlags/plugins/METFlagsSkipBitmapWriter.h"
+
+#include "FWCore/Framework/interface/FileBlock.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "DataFormats/Provenance/interface/FileID.h"
+#include "DataFormats/Provenance/interface/BranchType.h"
+#include "DataFormats/Provenance/interface/EventAuxiliary.h"
+
+#include <algorithm>
+
+#include "TTree.h"
+#include "TBranch.h"
+
+namespace {
+
+// GUID from the FileIdentifier of the MetaData tree; the name of the file without its
+// extension otherwise (files in /store are named after their GUID)
+  std::string fileGUID(const edm::FileBlock &fb){
+
+    TTree *meta = fb.metaTree();
+    TBranch *branch = meta ? meta->GetBranch(edm::poolNames::fileIdentifierBranchName().c_str()) : 0;
+    if( branch ){
+       edm::FileID fid;
+       edm::FileID *fidPtr = &fid;
+       branch->SetAddress(&fidPtr);
+       const bool ok = branch->GetEntry(0) > 0;
+       branch->ResetAddress();
+       if( ok && fid.isValid() ) return fid.fid();
+    }
+
+    std::string name = fb.fileName();
+    const std::string::size_type slash = name.rfind('/');
+    if( slash != std::string::npos ) name = name.substr(slash + 1);
+    const std::string::size_type dot = name.rfind('.');
+    if( dot != std::string::npos ) name = name.substr(0, dot);
+    return name;
+  }
+}
+
+METFlagsSkipBitmapWriter::METFlagsSkipBitmapWriter(const std::string &directory, const std::string &moduleLabel) :
+  directory_(directory), moduleLabel_(moduleLabel), seen_(0), open_(false), filesWritten_(0) {}
+
+void METFlagsSkipBitmapWriter::openFile(const edm::FileBlock &fb){
+
+  bitmap_.clear();
+  tagged_.clear();
+  seen_ = 0;
+  inputName_ = fb.fileName();
+  guid_ = fileGUID(fb);
+  open_ = !guid_.empty();
+}
+
+void METFlagsSkipBitmapWriter::closeFile(const edm::FileBlock &fb){
+
+  if( !open_ ) return;
+  open_ = false;
+
+  TTree *events = fb.tree();
+  TBranch *auxBranch = events ? events->GetBranch(edm::BranchTypeToAuxiliaryBranchName(edm::InEvent).c_str()) : 0;
+  if( !auxBranch ){
+     edm::LogWarning("METFlagsSkipBitmapWriter") << "No event index in " << inputName_ << " : the entry numbers are unknown, no skip bitmap written";
+     return;
+  }
+
+// Entry number of every tagged event, from the EventAuxiliary of each entry of the file
+  std::sort(tagged_.begin(), tagged_.end());
+  const uint64_t nEntries = events->GetEntries();
+  uint64_t found = 0;
+  if( !tagged_.empty() ){
+     edm::EventAuxiliary aux;
+     edm::EventAuxiliary *auxPtr = &aux;
+     auxBranch->SetAddress(&auxPtr);
+     for(uint64_t entry=0; entry<nEntries; entry++){
+        auxBranch->GetEntry(entry);
+        if( std::binary_search(tagged_.begin(), tagged_.end(), aux.id()) ){ bitmap_.add(entry); found++; }
+     }
+     auxBranch->ResetAddress();
+  }
+
+  if( found != tagged_.size() ){
+     edm::LogWarning("METFlagsSkipBitmapWriter") << "Found " << found << " of the " << tagged_.size() << " tagged events in " << inputName_
+                                                << " : the entry numbers are unknown, no skip bitmap written";
+     return;
+  }
+
+  const std::string fileName = directory_ + "/" + guid_ + "_" + moduleLabel_ + ".mfeb";
+  if( !bitmap_.write(fileName, guid_, nEntries) ){
+     edm::LogWarning("METFlagsSkipBitmapWriter") << "Cannot write the skip bitmap : " << bitmap_.error();
+     return;
+  }
+
+  filesWritten_++;
+  edm::LogInfo("METFlagsSkipBitmapWriter") << "Skip bitmap " << fileName << " : " << bitmap_.cardinality() << " tagged of " << nEntries
+                                          << " entries (" << seen_ << " seen), " << bitmap_.sizeInBytes() << " bytes";
+}
@@ -0,0 +1,45 @@
+#ifndef MET_FLAGS_SKIP_BITMAP_WRITER_H
+#define MET_FLAGS_SKIP_BITMAP_WRITER_H
+
+// Writes one METFlagsEntryBitmap per input file with the entry numbers of the tagged events, as
+// <directory>/<file GUID>_<module label>.mfeb, for skims that skip them by entry number.
+// The (run, lumi, event) of the tagged events are kept while the file is open and turned into
+// entry numbers at close through the EventAuxiliary branch of the file, so the order in which the
+// module sees the events (run/lumi sorting of the source, several streams) does not matter.
+// Events the module does not see are not tagged. When a tagged event is not found in the file,
+// the bitmap would be wrong and is not written.
+
+#include "MyAnalysis/METFlags/interface/METFlagsEntryBitmap.h"
+
+#include "DataFormats/Provenance/interface/EventID.h"
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace edm { class FileBlock; }
+
+class METFlagsSkipBitmapWriter {
+ public:
+
+  METFlagsSkipBitmapWriter(const std::string &directory, const std::string &moduleLabel);
+
+  void openFile(const edm::FileBlock &fb);
+  // Once per event, in any order
+  void tag(const edm::EventID &id, bool tagged) { if( !open_ ) return; if( tagged ) tagged_.push_back(id); seen_++; }
+  void closeFile(const edm::FileBlock &fb);
+
+  unsigned int filesWritten() const { return filesWritten_; }
+
+ private:
+
+  std::string directory_, moduleLabel_;
+  std::string guid_, inputName_;
+  METFlagsEntryBitmap bitmap_;
+  std::vector<edm::EventID> tagged_;
+  uint64_t seen_;
+  bool open_;
+  unsigned int filesWritten_;
+};
+
+#endif
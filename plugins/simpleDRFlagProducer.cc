@@ -0,0 +1,484 @@
+// -*- C++ -*-
+//
+// Package:    simpleDRfilter
+// Class:      simpleDRfilter
+// 
+/**\class simpleDRfilter simpleDRfilter.cc
+
+ Description: <one line class summary>
+ Event filtering for RA2 analysis (filtering status is stored in the event) 
+*/
+//
+// Original Author:  Hongxuan Liu
+//
+
+// system include files
+#include <memory>
+#include <vector>
+
+// user include files
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/ESHandle.h"
+
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/one/EDFilter.h"
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/LuminosityBlock.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/EDMException.h"
+
+#include "DataFormats/Common/interface/View.h"
+#include "DataFormats/Common/interface/ValueMap.h"
+
+#include "CondFormats/EcalObjects/interface/EcalChannelStatus.h"
+#include "CondFormats/DataRecord/interface/EcalChannelStatusRcd.h"
+
+#include "DataFormats/JetReco/interface/Jet.h"
+#include "DataFormats/METReco/interface/MET.h"
+
+#include "Geometry/CaloTopology/interface/EcalTrigTowerConstituentsMap.h"
+#include "Geometry/Records/interface/IdealGeometryRecord.h"
+
+// Geometry
+#include "Geometry/CaloGeometry/interface/CaloGeometry.h"
+#include "Geometry/Records/interface/CaloGeometryRecord.h"
+
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTable.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadCellAlgos.h"
+#include "MyAnalysis/METFlags/interface/METFlagsStats.h"
+#include "MyAnalysis/METFlags/interface/METFlagsSidecar.h"
+#include "MyAnalysis/METFlags/plugins/FlagJetReader.h"
+#include "MyAnalysis/METFlags/plugins/EcalDeadChannelTableSource.h"
+
+#include "TFile.h"
+#include "TH1.h"
+
+class simpleDRFlagProducer : public edm::one::EDFilter<edm::one::WatchRuns, edm::one::WatchLuminosityBlocks, edm::EndRunProducer,
+                                                          edm::EndLuminosityBlockProducer> {
+public:
+  explicit simpleDRFlagProducer(const edm::ParameterSet&);
+  ~simpleDRFlagProducer();
+
+private:
+  bool filter(edm::Event&, const edm::EventSetup&) override;
+  void beginJob() override;
+  void endJob() override;
+  void beginRun(const edm::Run&, const edm::EventSetup&) override;
+  void endRun(const edm::Run&, const edm::EventSetup&) override;
+  void endRunProduce(edm::Run&, const edm::EventSetup&) override;
+  void beginLuminosityBlock(const edm::LuminosityBlock&, const edm::EventSetup&) override;
+  void endLuminosityBlock(const edm::LuminosityBlock&, const edm::EventSetup&) override;
+  void endLuminosityBlockProduce(edm::LuminosityBlock&, const edm::EventSetup&) override;
+
+  // ----------member data ---------------------------
+  const bool            taggingMode_;
+
+  edm::InputTag jetInputTag_;
+// Reads the jets through the collection type of jetCollectionType, all of them kept in allJets_
+  std::unique_ptr<FlagJetReader> jetReader_;
+  std::vector<FlagJet> allJets_;
+// Contents of the jet ValueMaps; these and allJets_ are kept between events so that their storage is reused
+  std::vector<float> jetDRs_;
+  std::vector<int> jetStatuses_;
+  std::vector<unsigned int> jetTowers_;
+// jet selection cut: pt, eta
+// default (pt=-1, eta= 9999) means no cut
+  std::vector<double> jetSelCuts_; 
+
+  edm::InputTag metInputTag_;
+  edm::EDGetTokenT<edm::View<reco::MET> > metToken_;
+  edm::Handle<edm::View<reco::MET> > met;
+
+  bool debug_, printSkimInfo_;
+
+  bool isPrintedOnce;
+
+  void loadEventInfo(const edm::Event& iEvent, const edm::EventSetup& iSetup);
+  void loadJets(const edm::Event& iEvent, const edm::EventSetup& iSetup);
+  void loadMET(const edm::Event& iEvent, const edm::EventSetup& iSetup);
+  
+  unsigned int run, event, ls; bool isdata;
+
+  double calomet, calometPhi, tcmet, tcmetPhi, pfmet, pfmetPhi;
+
+  int maskedEcalChannelStatusThreshold_;
+  int chnStatusToBeEvaluated_;
+
+// XXX: All the following can be built at the beginning of a run
+// Masked channels (eta, phi, theta, status) and the trigger towers containing them, of the
+// EventSetup when deadChannelTableLabel is set, built by the module otherwise
+  std::unique_ptr<EcalDeadChannelTableSource> deadChannelTableSource_;
+  const EcalDeadChannelTable *deadChannelTable_;
+// Masked channels passing chnStatusToBeEvaluated_, the only ones the dR search looks at
+  EcalDeadChannelSelection evaluatedChannels_;
+
+  int getChannelStatusMaps(const edm::EventSetup& iSetup);
+
+  int evtProcessedCnt, totTPFilteredCnt;
+  double wtdEvtProcessed, wtdTPFiltered;
+
+// Per-lumi and per-run summaries of processed and tagged events
+  unsigned int lumiProcessedCnt, lumiTaggedCnt, runProcessedCnt, runTaggedCnt;
+
+// Stage timing and per-lumi counters, null unless enableStats
+  std::unique_ptr<METFlagsStats> stats_;
+  std::string statsFileName_;
+  METFlagsScratchWatch scratchWatch_;
+
+// Cached decisions (deadCellStatus, boundaryStatus), null unless sidecarInput or sidecarOutput
+  std::unique_ptr<METFlagsSidecar> sidecar_;
+  unsigned int sidecarRun_; bool sidecarRunSet_;
+
+  bool makeProfileRoot_;
+  std::string profileRootName_;
+  TFile *profFile;
+  TH1F *h1_dummy;
+
+  bool isProd_;
+  int verbose_;
+
+  bool doCracks_;
+// Cracks definition
+  std::vector<double> cracksHBHEdef_, cracksHEHFdef_;
+
+// Simple dR filter
+  std::vector<double> simpleDRFlagProducerInput_;
+
+// Jet selection, jet-MET dphi, dead cell dR and (doCracks) crack stages, built at construction
+  SimpleDRStagePlan stagePlan_;
+
+  void putStatuses(edm::Event& iEvent, int deadCellStatus, int boundaryStatus);
+
+// Nearest masked channel (chnStatusToBeEvaluated_) of every input jet, as ValueMaps on the jets
+  bool produceJetValueMaps_;
+  void putJetValueMaps(edm::Event& iEvent);
+};
+
+void simpleDRFlagProducer::loadMET(const edm::Event& iEvent, const edm::EventSetup& iSetup){
+
+  iEvent.getByToken(metToken_, met);
+
+}
+
+void simpleDRFlagProducer::loadEventInfo(const edm::Event& iEvent, const edm::EventSetup& iSetup){
+   run = iEvent.id().run();
+   event = iEvent.id().event();
+   ls = iEvent.luminosityBlock();
+   isdata = iEvent.isRealData();
+
+   if( !isPrintedOnce ){
+      if( isdata ) std::cout<<"\nInput dataset is DATA"<<std::endl<<std::endl;
+      else std::cout<<"\nInput dataset is MC"<<std::endl<<std::endl;
+      isPrintedOnce = true;
+   }
+
+}
+
+void simpleDRFlagProducer::loadJets(const edm::Event& iEvent, const edm::EventSetup& iSetup ){
+   
+  jetReader_->load(iEvent, allJets_);
+
+}
+
+//
+// static data member definitions
+//
+
+//
+// constructors and destructor
+//
+simpleDRFlagProducer::simpleDRFlagProducer(const edm::ParameterSet& iConfig) :
+  taggingMode_( iConfig.getParameter<bool>("taggingMode") ) {
+
+  debug_= iConfig.getUntrackedParameter<bool>("debug",false);
+  printSkimInfo_= iConfig.getUntrackedParameter<bool>("printSkimInfo",false);
+
+  jetInputTag_ = iConfig.getParameter<edm::InputTag>("jetInputTag");
+  jetSelCuts_ = iConfig.getParameter<std::vector<double> >("jetSelCuts");
+
+  metInputTag_ = iConfig.getParameter<edm::InputTag>("metInputTag");
+
+  jetReader_ = FlagJetReader::create(iConfig.getUntrackedParameter<std::string>("jetCollectionType", "view"), jetInputTag_, consumesCollector());
+  metToken_ = consumes<edm::View<reco::MET> >(metInputTag_);
+
+
+  makeProfileRoot_ = iConfig.getUntrackedParameter<bool>("makeProfileRoot", true);
+  profileRootName_ = iConfig.getUntrackedParameter<std::string>("profileRootName", "simpleDRFlagProducer.root");
+
+  maskedEcalChannelStatusThreshold_ = iConfig.getParameter<int>("maskedEcalChannelStatusThreshold");
+// The full status code is compared to maskedEcalChannelStatusThreshold_ (no 0x1F mask)
+  deadChannelTableSource_.reset( new EcalDeadChannelTableSource(consumesCollector(), iConfig.getUntrackedParameter<std::string>("deadChannelTableLabel", ""),
+                                                                maskedEcalChannelStatusThreshold_, 0xFFFFFFFF, "simpleDRFlagProducer") );
+  deadChannelTable_ = &deadChannelTableSource_->table();
+
+  chnStatusToBeEvaluated_ = iConfig.getParameter<int>("chnStatusToBeEvaluated");
+
+  isProd_ = iConfig.getUntrackedParameter<bool>("isProd");
+
+  doCracks_ = iConfig.getUntrackedParameter<bool>("doCracks");
+  
+  verbose_ = iConfig.getParameter<int>("verbose");
+
+  simpleDRFlagProducerInput_ = iConfig.getParameter<std::vector<double> >("simpleDRFlagProducerInput");
+
+  cracksHBHEdef_ = iConfig.getParameter<std::vector<double> > ("cracksHBHEdef");
+  cracksHEHFdef_ = iConfig.getParameter<std::vector<double> > ("cracksHEHFdef");
+  stagePlan_.build(jetSelCuts_[0], jetSelCuts_[1], simpleDRFlagProducerInput_[0], simpleDRFlagProducerInput_[1], doCracks_,
+                   cracksHBHEdef_[0], cracksHBHEdef_[1], cracksHEHFdef_[0], cracksHEHFdef_[1]);
+
+  produceJetValueMaps_ = iConfig.getUntrackedParameter<bool>("produceJetValueMaps", false);
+
+  evtProcessedCnt = 0; totTPFilteredCnt = 0;
+  wtdEvtProcessed = 0; wtdTPFiltered = 0;
+  lumiProcessedCnt = lumiTaggedCnt = runProcessedCnt = runTaggedCnt = 0;
+
+  if( iConfig.getUntrackedParameter<bool>("enableStats", false) ){
+     const std::string label = iConfig.getParameter<std::string>("@module_label");
+     stats_.reset( new METFlagsStats(label) );
+     statsFileName_ = iConfig.getUntrackedParameter<std::string>("statsFileName", label + "_stats.json");
+     stagePlan_.watchScratch(scratchWatch_);
+     scratchWatch_.watch(allJets_);
+     scratchWatch_.watch(jetDRs_); scratchWatch_.watch(jetStatuses_); scratchWatch_.watch(jetTowers_);
+  }
+
+  sidecarRun_ = 0; sidecarRunSet_ = false;
+  const std::string sidecarInput = iConfig.getUntrackedParameter<std::string>("sidecarInput", "");
+  const std::string sidecarOutput = iConfig.getUntrackedParameter<std::string>("sidecarOutput", "");
+  if( !sidecarInput.empty() || !sidecarOutput.empty() ){
+// Salted with the status encoding : files with the old constant statuses are not reused.
+// doCracks is untracked but changes boundaryStatus
+     const uint64_t sidecarConfigHash = metFlagsHash(std::string(doCracks_ ? "cracks" : "noCracks"),
+                                                     metFlagsHash(iConfig.id().compactForm(), metFlagsHash(std::string("crackBits"))));
+     sidecar_.reset( new METFlagsSidecar(sidecarInput, sidecarOutput, sidecarConfigHash) );
+     if( !sidecar_->error().empty() ) edm::LogWarning("simpleDRFlagProducer") << "Sidecar input not used : " << sidecar_->error();
+     if( produceJetValueMaps_ && !sidecarInput.empty() ) edm::LogWarning("simpleDRFlagProducer") << "produceJetValueMaps is on : the sidecar decisions are not reused";
+  }
+
+  produces<int> ("deadCellStatus"); produces<int> ("boundaryStatus");
+  produces<bool>();
+  produces<unsigned int, edm::Transition::EndLuminosityBlock>("lumiProcessed");
+  produces<unsigned int, edm::Transition::EndLuminosityBlock>("lumiTagged");
+  produces<unsigned int, edm::Transition::EndRun>("runProcessed");
+  produces<unsigned int, edm::Transition::EndRun>("runTagged");
+  if( produceJetValueMaps_ ){
+     produces<edm::ValueMap<float> >("deadChannelDR");
+     produces<edm::ValueMap<int> >("deadChannelStatus");
+     produces<edm::ValueMap<unsigned int> >("deadChannelTower");
+  }
+
+  if( makeProfileRoot_ ){
+     profFile = new TFile(profileRootName_.c_str(), "RECREATE");
+     h1_dummy = new TH1F("dummy", "dummy", 500, 0, 500);
+  }
+}
+
+simpleDRFlagProducer::~simpleDRFlagProducer() {
+  if( makeProfileRoot_ ){
+     profFile->cd();
+
+     h1_dummy->Write();
+
+     profFile->Close();
+     delete profFile;
+  }
+}
+
+// ------------ method called on each new Event  ------------
+bool simpleDRFlagProducer::filter(edm::Event& iEvent, const edm::EventSetup& iSetup) {
+
+  METFlagsEventTimer evtTimer(stats_.get(), &scratchWatch_);
+
+  {
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kLoad);
+     loadEventInfo(iEvent, iSetup);
+  }
+
+  evtProcessedCnt++;
+  lumiProcessedCnt++; runProcessedCnt++;
+
+// 0 : nothing found. deadCellStatus is the number of jets close to a masked channel,
+// boundaryStatus the crack bits of the jets (always 0 unless doCracks)
+  int deadCellStatus = 0, boundaryStatus = 0;
+
+// Neither the jets nor the MET are needed when the decision is in the sidecar
+  if( sidecar_.get() ){
+     bool fromSidecar = false;
+     {
+        METFlagsStageTimer timer(stats_.get(), METFlagsStats::kSidecar);
+        if( !sidecarRunSet_ || sidecarRun_ != run ){
+           sidecar_->beginRun(run, deadChannelTable_->contentHash());
+           sidecarRun_ = run; sidecarRunSet_ = true;
+        }
+        if( !produceJetValueMaps_ ) fromSidecar = sidecar_->lookup(run, ls, iEvent.id().event(), deadCellStatus, boundaryStatus);
+     }
+     if( fromSidecar ){
+        const bool evtTagged = deadCellStatus != 0 || boundaryStatus != 0;
+        if( evtTagged ){ totTPFilteredCnt++; lumiTaggedCnt++; runTaggedCnt++; }
+        putStatuses(iEvent, deadCellStatus, boundaryStatus);
+        evtTimer.done(run, ls, evtTagged);
+        return taggingMode_ || !evtTagged;
+     }
+  }
+
+  {
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kLoad);
+     loadJets(iEvent, iSetup);
+     loadMET(iEvent, iSetup);
+  }
+
+  if( produceJetValueMaps_ ){
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kDRSearch);
+     putJetValueMaps(iEvent);
+  }
+
+  double dPhiToMET = simpleDRFlagProducerInput_[0], dRtoDeadCell = simpleDRFlagProducerInput_[1];
+
+  int dPhiToMETstatus = 0;
+
+  if( !met.isValid() || met->empty() ){
+     edm::LogWarning("simpleDRFlagProducer") << "No MET in the event : the simpleDR check is not done for this event";
+  }
+  else{
+     METFlagsStageTimer timer(stats_.get(), METFlagsStats::kDRSearch);
+     stagePlan_.run(allJets_, (*met)[0].phi(), *deadChannelTable_, evaluatedChannels_, dPhiToMETstatus, deadCellStatus, boundaryStatus);
+  }
+
+  if( sidecar_.get() ) sidecar_->record(run, ls, iEvent.id().event(), deadCellStatus, boundaryStatus);
+
+  const bool evtTagged = deadCellStatus != 0 || boundaryStatus != 0;
+  if( evtTagged ){ totTPFilteredCnt++; lumiTaggedCnt++; runTaggedCnt++; }
+
+  if(debug_ && met.isValid() && !met->empty() ){
+     printf("\nrun : %8d  event : %12d  ls : %8d  dPhiToMETstatus : %d  deadCellStatus : %d  boundaryStatus : %d\n", run, event, ls, dPhiToMETstatus, deadCellStatus, boundaryStatus);
+     printf("met : %6.2f  metphi : % 6.3f  dPhiToMET : %5.3f  dRtoDeadCell : %5.3f\n", (*met)[0].pt(), (*met)[0].phi(), dPhiToMET, dRtoDeadCell);
+  }
+
+  if( makeProfileRoot_ ){
+//     h1_dummy->Fill(xxx);
+  }
+
+  putStatuses(iEvent, deadCellStatus, boundaryStatus);
+
+  evtTimer.done(run, ls, evtTagged);
+
+  return taggingMode_ || !evtTagged;
+
+}
+
+// ------------ method called once each job just before starting event loop  ------------
+void simpleDRFlagProducer::beginJob() {
+  if (debug_) std::cout << "beginJob" << std::endl;
+}
+
+// ------------ method called once each job just after ending the event loop  ------------
+void simpleDRFlagProducer::endJob() {
+  if (debug_) std::cout << "endJob" << std::endl;
+
+  edm::LogInfo("simpleDRFlagProducer") << "Processed " << evtProcessedCnt << " events, tagged " << totTPFilteredCnt;
+
+  if( stats_.get() && !stats_->writeSummary(statsFileName_) ){
+     edm::LogWarning("simpleDRFlagProducer") << "Cannot write the stats summary to " << statsFileName_;
+  }
+
+  if( sidecar_.get() ){
+     edm::LogInfo("simpleDRFlagProducer") << "Sidecar hits : " << sidecar_->hits() << "  misses : " << sidecar_->misses();
+     if( !sidecar_->write() ) edm::LogWarning("simpleDRFlagProducer") << "Cannot write the sidecar : " << sidecar_->error();
+  }
+}
+
+// ------------ method called once each run just before starting event loop  ------------
+void simpleDRFlagProducer::beginRun(const edm::Run &run, const edm::EventSetup& iSetup) {
+  if (debug_) std::cout << "beginRun" << std::endl;
+// Channel status might change for each run (data)
+// Event setup
+  getChannelStatusMaps(iSetup);
+  sidecarRunSet_ = false;
+  runProcessedCnt = runTaggedCnt = 0;
+  if( debug_) std::cout<< "EcalAllDeadChannels.size() : "<<deadChannelTable_->size()<<"  towers : "<<deadChannelTable_->towers().size()<<std::endl;
+}
+
+// ------------ method called once each run just after ending the event loop  ------------
+void simpleDRFlagProducer::endRun(const edm::Run &run, const edm::EventSetup& iSetup) {
+  if (debug_) std::cout << "endRun" << std::endl;
+}
+
+void simpleDRFlagProducer::endRunProduce(edm::Run &run, const edm::EventSetup& iSetup) {
+
+  std::unique_ptr<unsigned int> processedPtr( new unsigned int(runProcessedCnt) );
+  std::unique_ptr<unsigned int> taggedPtr( new unsigned int(runTaggedCnt) );
+  run.put( std::move(processedPtr), "runProcessed" );
+  run.put( std::move(taggedPtr), "runTagged" );
+}
+
+void simpleDRFlagProducer::beginLuminosityBlock(const edm::LuminosityBlock &lumi, const edm::EventSetup& iSetup) {
+  lumiProcessedCnt = lumiTaggedCnt = 0;
+}
+
+void simpleDRFlagProducer::endLuminosityBlock(const edm::LuminosityBlock &lumi, const edm::EventSetup& iSetup) { }
+
+void simpleDRFlagProducer::endLuminosityBlockProduce(edm::LuminosityBlock &lumi, const edm::EventSetup& iSetup) {
+
+  std::unique_ptr<unsigned int> processedPtr( new unsigned int(lumiProcessedCnt) );
+  std::unique_ptr<unsigned int> taggedPtr( new unsigned int(lumiTaggedCnt) );
+  lumi.put( std::move(processedPtr), "lumiProcessed" );
+  lumi.put( std::move(taggedPtr), "lumiTagged" );
+}
+
+
+void simpleDRFlagProducer::putStatuses(edm::Event& iEvent, int deadCellStatus, int boundaryStatus){
+
+  std::unique_ptr<int> deadCellStatusPtr ( new int(deadCellStatus) );
+  std::unique_ptr<int> boundaryStatusPtr ( new int(boundaryStatus) );
+  iEvent.put( std::move(deadCellStatusPtr), "deadCellStatus");
+  iEvent.put( std::move(boundaryStatusPtr), "boundaryStatus");
+
+// The pass bool, false when any status is set
+  std::unique_ptr<bool> pOut( new bool(deadCellStatus == 0 && boundaryStatus == 0) );
+  iEvent.put( std::move(pOut) );
+}
+
+
+void simpleDRFlagProducer::putJetValueMaps(edm::Event& iEvent){
+
+// No masked channel : dR 999, status -1, tower 0
+  nearestDeadChannels(*deadChannelTable_, evaluatedChannels_, allJets_, jetDRs_, jetStatuses_, jetTowers_);
+
+  std::unique_ptr<edm::ValueMap<float> > dRMap( new edm::ValueMap<float>() );
+  edm::ValueMap<float>::Filler dRFiller(*dRMap);
+  jetReader_->insert(dRFiller, jetDRs_);
+  dRFiller.fill();
+
+  std::unique_ptr<edm::ValueMap<int> > statusMap( new edm::ValueMap<int>() );
+  edm::ValueMap<int>::Filler statusFiller(*statusMap);
+  jetReader_->insert(statusFiller, jetStatuses_);
+  statusFiller.fill();
+
+  std::unique_ptr<edm::ValueMap<unsigned int> > towerMap( new edm::ValueMap<unsigned int>() );
+  edm::ValueMap<unsigned int>::Filler towerFiller(*towerMap);
+  jetReader_->insert(towerFiller, jetTowers_);
+  towerFiller.fill();
+
+  iEvent.put( std::move(dRMap), "deadChannelDR" );
+  iEvent.put( std::move(statusMap), "deadChannelStatus" );
+  iEvent.put( std::move(towerMap), "deadChannelTower" );
+}
+
+
+int simpleDRFlagProducer::getChannelStatusMaps(const edm::EventSetup& iSetup){
+
+// Same table as the previous run : the selections are still valid
+  const bool changed = deadChannelTableSource_->update(iSetup);
+  deadChannelTable_ = &deadChannelTableSource_->table();
+  if( !changed ) return 0;
+  evaluatedChannels_.build(*deadChannelTable_, chnStatusToBeEvaluated_);
+
+  return 1;
+}
+
+//define this as a plug-in
+DEFINE_FWK_MODULE(simpleDRFlagProducer);
@@ -70,6 +70,19 @@ CSCBasedHaloFlagProducer = cms.EDProducer("CSCHaloFlagProducer",
                                         ### Wire window for matching collision muon rechits to earl ALCT Digis  
                                         MatchingDWireThreshold= cms.int32(5),
                                         
+                                        ### Veto of the L1 Halo Triggers and early ALCT Digis explained by collision muons (trigger and digi levels):
+                                        ###   "none"     : the counts of CSCHaloData are used as they are
+                                        ###   "fast"     : muon outer states extrapolated to the cached z of each CSC station and ring (FastMatchingModel)
+                                        ###   "full"     : TrackDetectorAssociator, needs the SteppingHelixPropagatorAny and DetIdAssociator ES producers
+                                        ###   "validate" : both, "full" decides and the agreement of "fast" is reported at endJob
+                                        ### "fast", "full" and "validate" read the L1MuGMTReadoutCollection and the ALCT Digis, when in the event
+                                        CollisionMuonMatching = cms.untracked.string("none"),
+                                        ### "straightLine", or "helix" in the uniform effective field FastMatchingBz (Tesla)
+                                        FastMatchingModel = cms.untracked.string("straightLine"),
+                                        FastMatchingBz = cms.untracked.double(0.),
+                                        ### Only read by the "full" and "validate" matchings
+                                        TrackAssociatorParameters = TrackAssociatorParameterBlock.TrackAssociatorParameters,
+
                                         ### Min number of L1 Halo Triggers required to call event "halo" (requires FilterTriggerLevel=True) 
                                         MinNumberOfHaloTriggers = cms.untracked.int32(1),
                                         ### Min number of early ALCT Digis required to call event "halo" (requires FilterDigiLevel =True)
@@ -77,9 +90,23 @@ CSCBasedHaloFlagProducer = cms.EDProducer("CSCHaloFlagProducer",
                                         ### Min number of halo-like CSC cosmic tracks to call event "halo" (requires FilterRecoLevel =True)
                                         MinNumberOfHaloTracks = cms.untracked.int32(1),
                                         
+                                        ### Store one CSCHaloTrackFeatures record per cosmic SA track (instance "HaloTrackFeatures")
+                                        ### so the reco-level cuts can be re-applied downstream without rerunning
+                                        ProduceTrackFeatures = cms.untracked.bool(False),
+
+                                        ### Per-stage timing (load, cosmic loop) and per-lumi counts, written as JSON to <module label>_stats.json (or statsFileName) at endJob
+                                        enableStats = cms.untracked.bool(False),
+
+                                        ### Pass decisions cached by (run, lumi, event), reused when the tracked parameters are unchanged. Empty: off
+                                        sidecarInput = cms.untracked.string(""),
+                                        sidecarOutput = cms.untracked.string(""),
+
+                                        ### Directory for one bitmap of the entry numbers of the halo-tagged events per input file (<GUID>_<module label>.mfeb). Empty: off
+                                        ### Entries are found by (run, lumi, event) at file close, in any processing order; events the module does not see are not tagged
+                                        skipBitmapDir = cms.untracked.string(""),
+
                                         # If this is MC, the expected collision bx for ALCT Digis will be 6 instead of 3
-                                        ExpectedBX = cms.int32(3),
-                                        TrackAssociatorParameters = TrackAssociatorParameterBlock.TrackAssociatorParameters
+                                        ExpectedBX = cms.int32(3)
                                         )
 
 
@@ -0,0 +1,30 @@
+import FWCore.ParameterSet.Config as cms
+
+# Agreement of the fast collision muon matching of CSCHaloFlagProducer with TrackDetectorAssociator
+# on a validation sample (RAW-RECO, with the GMT readout and the ALCT digis). The summary is printed
+# by the module at endJob. Set the input files and the global tag before running it.
+process = cms.Process("CSCMATCHING")
+
+process.load("FWCore.MessageService.MessageLogger_cfi")
+process.MessageLogger.cerr.FwkReport.reportEvery = 1000
+process.MessageLogger.cerr.threshold = "INFO"
+process.MessageLogger.cerr.INFO.limit = 0
+process.MessageLogger.cerr.CSCHaloFlagProducer = cms.untracked.PSet( limit = cms.untracked.int32(-1) )
+
+process.load("Configuration.StandardSequences.Geometry_cff")
+process.load("Configuration.StandardSequences.MagneticField_cff")
+process.load("Configuration.StandardSequences.FrontierConditions_GlobalTag_cff")
+process.load("TrackingTools.TrackAssociator.DetIdAssociatorESProducer_cff")
+process.load("TrackPropagation.SteppingHelix.SteppingHelixPropagatorAny_cfi")
+
+process.source = cms.Source("PoolSource",
+  fileNames = cms.untracked.vstring(),
+)
+process.maxEvents = cms.untracked.PSet( input = cms.untracked.int32(-1) )
+
+process.load("MyAnalysis.METFlags.CSCHaloFlagProducer_cfi")
+
+process.CSCHaloFlagProducerDigiAndTriggerLevel.CollisionMuonMatching = "validate"
+process.CSCHaloFlagProducerDigiAndTriggerLevel.enableStats = True
+
+process.p = cms.Path( process.CSCHaloFlagProducerDigiAndTriggerLevel )
@@ -17,10 +17,33 @@ EcalDeadCellEventFlagProducer = cms.EDFilter(
     eeReducedRecHitCollection = cms.InputTag("reducedEcalRecHitsEE"),
     
     maskedEcalChannelStatusThreshold = cms.int32( 1 ),
+
+    # dead channel table of the EcalDeadChannelTableESProducer with this appendToDataLabel, made in the EventSetup instead of at beginRun
+    # (statusMask 0x1F for the same table), see EcalDeadChannelTableESProducer_cfi.py. its maskedEcalChannelStatusThreshold must be this one.
+    # Empty: the module builds it
+    deadChannelTableLabel = cms.untracked.string( "" ),
+
+    # also store the dead tower Et before the etValToBeFlagged cut : max Et per zside (maxDeadTowerEtPlus/Minus), the number of
+    # dead towers with Et >= deadTowerEtFloor (nDeadTowersAboveFloor) and the raw EcalTrigTowerDetId of the hottest one (hottestDeadTower, 0 if none)
+    # tagged at a cut X > 0  <=>  max(maxDeadTowerEtPlus, maxDeadTowerEtMinus) >= X
+    produceDeadTowerEt = cms.untracked.bool( False ),
+    deadTowerEtFloor = cms.untracked.double( 1.0 ),
     
-    doEEfilter = cms.untracked.bool( True ), # turn it on by default
+    doEEfilter = cms.untracked.bool( True ), # turn it on by default; the EE channels are skipped by both the TP and the HIT method when off
     
     makeProfileRoot = cms.untracked.bool( False ),
     profileRootName = cms.untracked.string("deadCellFilterProfile.root" ),
 
+    # per-stage timing (load, method select, TP/HIT scan) and per-lumi counts, written as JSON to <module label>_stats.json (or statsFileName) at endJob
+    enableStats = cms.untracked.bool( False ),
+
+    # decisions cached by (run, lumi, event); reused when the tracked parameters and the dead channel/TP scale conditions are unchanged. Empty: off
+    # both can name the same file : the still valid input records are carried over
+    sidecarInput = cms.untracked.string( "" ),
+    sidecarOutput = cms.untracked.string( "" ),
+
+    # directory for one bitmap of the entry numbers of the tagged events per input file (<GUID>_<module label>.mfeb), for skims. Empty: off
+    # entries are found by (run, lumi, event) at file close, in any processing order; events the module does not see are not tagged
+    skipBitmapDir = cms.untracked.string( "" ),
+
 )
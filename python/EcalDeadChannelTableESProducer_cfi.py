@@ -0,0 +1,15 @@
+import FWCore.ParameterSet.Config as cms
+
+# The dead channel table of the ECAL flag producers, made in the EventSetup when the channel status changes.
+# Used by a flag producer whose deadChannelTableLabel is the appendToDataLabel below. The threshold and the status mask must be
+# those of the module, which checks them at beginRun and throws otherwise :
+#   EcalDeadCellEventFlagProducer, EcalAnomalyFlagProducer : statusMask 0x1F
+#   simpleDRFlagProducer                                  : statusMask 0xFFFFFFFF
+ecalDeadChannelTableESProducer = cms.ESProducer(
+    'EcalDeadChannelTableESProducer',
+
+    maskedEcalChannelStatusThreshold = cms.int32( 1 ),
+    statusMask = cms.uint32( 0x1F ),
+
+    appendToDataLabel = cms.string( "deadCellStatus1" ),
+)
@@ -0,0 +1,37 @@
+import FWCore.ParameterSet.Config as cms
+
+# Packs the flags of this package into one unsigned long long per event: bit i is set when flags[i] tagged the event.
+# The bit order is stored in the run ("flagNames"), together with a "tableVersion" word.
+METFlagBitwordProducer = cms.EDProducer('METFlagBitwordProducer',
+
+# If disabled, a missing flag product is an error; otherwise its bit stays unset
+  allowMissingInputs = cms.untracked.bool( True ),
+
+# Per-event timing and per-lumi counts of tagged events, written as JSON to <module label>_stats.json (or statsFileName) at endJob
+  enableStats = cms.untracked.bool( False ),
+
+# type "bool" : tagged when the stored pass bool is false
+# type "int"  : tagged when the stored int differs from passValue
+# type "uint" : tagged when the stored word is non-zero
+  flags = cms.VPSet(
+    cms.PSet( name = cms.string("EcalDeadCellTP"),
+              src = cms.InputTag("EcalDeadCellEventFlagProducer"),
+              type = cms.string("bool") ),
+# simpleDRFlagProducer stores its computed statuses, 0 when nothing is found (see simpleDRFlagProducer_cfi.py)
+    cms.PSet( name = cms.string("simpleDRdeadCell"),
+              src = cms.InputTag("simpleDRFlagProducer", "deadCellStatus"),
+              type = cms.string("int"),
+              passValue = cms.int32(0) ),
+    cms.PSet( name = cms.string("simpleDRboundary"),
+              src = cms.InputTag("simpleDRFlagProducer", "boundaryStatus"),
+              type = cms.string("int"),
+              passValue = cms.int32(0) ),
+    cms.PSet( name = cms.string("CSCHalo"),
+              src = cms.InputTag("CSCBasedHaloFlagProducer"),
+              type = cms.string("bool") ),
+    cms.PSet( name = cms.string("logError"),
+              src = cms.InputTag("logErrorFlagProducer"),
+              type = cms.string("uint") ),
+  ),
+
+)
@@ -0,0 +1,22 @@
+import FWCore.ParameterSet.Config as cms
+
+# Records the inputs of the MET flag algorithms into a fixture for metFlagsReplayBenchmark
+METFlagsFixtureRecorder = cms.EDAnalyzer('METFlagsFixtureRecorder',
+
+  tpDigiCollection = cms.InputTag("ecalTPSkim"),
+  ebReducedRecHitCollection = cms.InputTag("reducedEcalRecHitsEB"),
+  eeReducedRecHitCollection = cms.InputTag("reducedEcalRecHitsEE"),
+  jetInputTag = cms.InputTag('ak5PFJets'),
+  metInputTag = cms.InputTag('pfMet'),
+  SACosmicMuonLabel = cms.InputTag("cosmicMuons"),
+
+# Dead channel table of the first run: (status & statusMask) >= maskedEcalChannelStatusThreshold
+# 0x1F is what EcalDeadCellEventFlagProducer uses, simpleDRFlagProducer uses the full status code
+  maskedEcalChannelStatusThreshold = cms.int32( 1 ),
+  statusMask = cms.uint32( 0x1F ),
+
+  fixtureName = cms.untracked.string( "metFlagsReplay.fixture" ),
+# -1 : record all events
+  maxEvents = cms.untracked.int32( -1 ),
+
+)
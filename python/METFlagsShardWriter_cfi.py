@@ -0,0 +1,26 @@
+import FWCore.ParameterSet.Config as cms
+
+# Flag results of one shard of a sharded reprocessing (scripts/metFlagsShardedReprocess.py), merged by metFlagsMergeShards
+METFlagsShardWriter = cms.EDAnalyzer('METFlagsShardWriter',
+
+  bitwordSrc = cms.InputTag("METFlagBitwordProducer"),
+
+# unsigned int lumi products stored per lumi; the merge sums them over the shards
+  lumiSummaries = cms.VInputTag(
+    cms.InputTag("EcalDeadCellEventFlagProducer", "lumiProcessed"),
+    cms.InputTag("EcalDeadCellEventFlagProducer", "lumiTagged"),
+    cms.InputTag("EcalDeadCellEventFlagProducer", "lumiDeadTowersAboveThreshold"),
+    cms.InputTag("simpleDRFlagProducer", "lumiProcessed"),
+    cms.InputTag("simpleDRFlagProducer", "lumiTagged"),
+    cms.InputTag("CSCBasedHaloFlagProducer", "lumiProcessed"),
+    cms.InputTag("CSCBasedHaloFlagProducer", "lumiTagged"),
+    cms.InputTag("logErrorFlagProducer", "lumiProcessed"),
+  ),
+
+# fileNames of the source, and the position of each of them in the full file list (empty : 0, 1, ...)
+  fileNames = cms.untracked.vstring(),
+  fileIndices = cms.untracked.vuint32(),
+
+  outputFileName = cms.untracked.string( "metFlagsShard.root" ),
+
+)
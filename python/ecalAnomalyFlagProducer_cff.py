@@ -0,0 +1,63 @@
+import FWCore.ParameterSet.Config as cms
+
+from MyAnalysis.METFlags.EcalDeadCellEventFlagProducer_cfi import EcalDeadCellEventFlagProducer as _deadCell
+from MyAnalysis.METFlags.simpleDRFlagProducer_cfi import simpleDRFlagProducer as _simpleDR
+
+# EcalDeadCellEventFlagProducer and simpleDRFlagProducer in one module : one dead channel table and
+# one event pass for both checks. Tagging only. Replaces the two modules : do not load it together
+# with their cfis, the aliases below take their labels.
+# Both PSets take the parameters of the separate module; the two maskedEcalChannelStatusThreshold
+# must be equal. taggingMode, debug, the profile files, the sidecars and the skip bitmap are not used.
+ecalAnomalyFlagProducer = cms.EDProducer('EcalAnomalyFlagProducer',
+    deadCell = cms.PSet( **_deadCell.parameters_() ),
+    simpleDR = cms.PSet( **_simpleDR.parameters_() ),
+
+    # per-stage timing (load, method select, TP/HIT scan, dR search) and per-lumi counts of the fused module, written as
+    # JSON to <module label>_stats.json (or statsFileName) at endJob
+    enableStats = cms.untracked.bool( False ),
+
+    # dead channel table of the EcalDeadChannelTableESProducer with this appendToDataLabel instead of the one built at beginRun
+    # (statusMask 0x1F), see EcalDeadChannelTableESProducer_cfi.py. Empty: the module builds it
+    deadChannelTableLabel = cms.untracked.string( "" ),
+)
+# Set here rather than taken from the cfi : the aliases below depend on it
+ecalAnomalyFlagProducer.deadCell.produceDeadTowerEt = cms.untracked.bool( False )
+
+# The products under the labels and instances of the separate modules, for the existing consumers
+# (METFlagBitwordProducer, the shard writer, the analyses). Both checks see every event : the one
+# lumiProcessed and runProcessed product is aliased by both modules. An alias must match a product : with
+# deadCell.produceDeadTowerEt on, also extend the EcalDeadCellEventFlagProducer aliases with
+# deadTowerEtAliases; with simpleDR.produceJetValueMaps on, add the deadChannelDR, deadChannelStatus
+# and deadChannelTower instances.
+deadTowerEtAliases = cms.VPSet(
+    cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('maxDeadTowerEtPlus') ),
+    cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('maxDeadTowerEtMinus') ),
+    cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('nDeadTowersAboveFloor') ),
+    cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('hottestDeadTower') ),
+)
+
+EcalDeadCellEventFlagProducer = cms.EDAlias(
+    ecalAnomalyFlagProducer = cms.VPSet(
+        cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('deadCellTP'), toProductInstance = cms.string('') ),
+        cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('lumiProcessed') ),
+        cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('deadCellLumiTagged'), toProductInstance = cms.string('lumiTagged') ),
+        cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('lumiDeadTowersAboveThreshold') ),
+        cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('runProcessed') ),
+        cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('deadCellRunTagged'), toProductInstance = cms.string('runTagged') ),
+        cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('runDeadTowersAboveThreshold') ),
+    )
+)
+
+simpleDRFlagProducer = cms.EDAlias(
+    ecalAnomalyFlagProducer = cms.VPSet(
+        cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('simpleDR'), toProductInstance = cms.string('') ),
+        cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('deadCellStatus') ),
+        cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('boundaryStatus') ),
+        cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('lumiProcessed') ),
+        cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('simpleDRLumiTagged'), toProductInstance = cms.string('lumiTagged') ),
+        cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('runProcessed') ),
+        cms.PSet( type = cms.string('*'), fromProductInstance = cms.string('simpleDRRunTagged'), toProductInstance = cms.string('runTagged') ),
+    )
+)
+
+ecalAnomalyFlagSequence = cms.Sequence( ecalAnomalyFlagProducer )
@@ -73,3 +73,47 @@ logErrorAnalysis = cms.Sequence(tooManySeeds
                                 * tooManyTripletsPairs
                                 * tooManyTripletsPairsMainIterations
                                 * tooManySeedsMainIterations)
+
+
+# Single-pass equivalent of the logErrorAnalysis sequence: one rule per LogErrorEventFilter above.
+# The event gets one unsigned int with bit i set when rule i matched (bit order = order of the rules),
+# plus per-lumi and per-run counters ("lumiProcessed"/"lumiRuleCounts", "runProcessed"/"runRuleCounts")
+# and the rule names ("ruleNames") in the run.
+logErrorFlagProducer = cms.EDFilter("LogErrorFlagProducer",
+                                    src = cms.InputTag("logErrorHarvester"),
+                                    taggingMode = cms.bool(True),
+                                    debug = cms.untracked.bool(False),
+                                    # if disabled, a missing src product is an error; otherwise no rule matches and a warning is logged once per job
+                                    allowMissingInputs = cms.untracked.bool(True),
+                                    # per-stage timing and per-lumi counts, written as JSON to <module label>_stats.json (or statsFileName) at endJob
+                                    enableStats = cms.untracked.bool(False),
+                                    rules = cms.VPSet(
+                                        cms.PSet(name = cms.string("tooManySeeds"),
+                                                 categoriesToWatch = tooManySeeds.categoriesToWatch,
+                                                 categoriesToIgnore = tooManySeeds.categoriesToIgnore,
+                                                 maxErrorFractionInLumi = tooManySeeds.maxErrorFractionInLumi,
+                                                 maxErrorFractionInRun = tooManySeeds.maxErrorFractionInRun),
+                                        cms.PSet(name = cms.string("tooManyClusters"),
+                                                 categoriesToWatch = tooManyClusters.categoriesToWatch,
+                                                 categoriesToIgnore = tooManyClusters.categoriesToIgnore,
+                                                 maxErrorFractionInLumi = tooManyClusters.maxErrorFractionInLumi,
+                                                 maxErrorFractionInRun = tooManyClusters.maxErrorFractionInRun),
+                                        cms.PSet(name = cms.string("tooManyTripletsPairs"),
+                                                 categoriesToWatch = tooManyTripletsPairs.categoriesToWatch,
+                                                 modulesToIgnore = tooManyTripletsPairs.modulesToIgnore,
+                                                 maxErrorFractionInLumi = tooManyTripletsPairs.maxErrorFractionInLumi,
+                                                 maxErrorFractionInRun = tooManyTripletsPairs.maxErrorFractionInRun),
+                                        cms.PSet(name = cms.string("tooManyTripletsPairsMainIterations"),
+                                                 categoriesToWatch = tooManyTripletsPairsMainIterations.categoriesToWatch,
+                                                 modulesToWatch = tooManyTripletsPairsMainIterations.modulesToWatch,
+                                                 maxErrorFractionInLumi = tooManyTripletsPairsMainIterations.maxErrorFractionInLumi,
+                                                 maxErrorFractionInRun = tooManyTripletsPairsMainIterations.maxErrorFractionInRun),
+                                        cms.PSet(name = cms.string("tooManySeedsMainIterations"),
+                                                 categoriesToWatch = tooManySeedsMainIterations.categoriesToWatch,
+                                                 modulesToWatch = tooManySeedsMainIterations.modulesToWatch,
+                                                 maxErrorFractionInLumi = tooManySeedsMainIterations.maxErrorFractionInLumi,
+                                                 maxErrorFractionInRun = tooManySeedsMainIterations.maxErrorFractionInRun)
+                                        )
+                                    )
+
+logErrorAnalysisFused = cms.Sequence(logErrorFlagProducer)
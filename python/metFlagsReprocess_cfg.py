@@ -0,0 +1,33 @@
+import FWCore.ParameterSet.Config as cms
+
+# Flag reprocessing job of one shard, see scripts/metFlagsShardedReprocess.py which sets the input
+# files, the lumi ranges, the global tag and the outputs before running it.
+process = cms.Process("METFLAGS")
+
+process.load("FWCore.MessageService.MessageLogger_cfi")
+process.MessageLogger.cerr.FwkReport.reportEvery = 1000
+
+process.load("Configuration.StandardSequences.Geometry_cff")
+process.load("Configuration.StandardSequences.FrontierConditions_GlobalTag_cff")
+
+process.source = cms.Source("PoolSource",
+  fileNames = cms.untracked.vstring(),
+)
+process.maxEvents = cms.untracked.PSet( input = cms.untracked.int32(-1) )
+
+process.load("MyAnalysis.METFlags.EcalDeadCellEventFlagProducer_cfi")
+process.load("MyAnalysis.METFlags.simpleDRFlagProducer_cfi")
+process.load("MyAnalysis.METFlags.CSCHaloFlagProducer_cfi")
+process.load("MyAnalysis.METFlags.logErrorAnalysisProducer_cff")
+process.load("MyAnalysis.METFlags.METFlagBitwordProducer_cfi")
+process.load("MyAnalysis.METFlags.METFlagsShardWriter_cfi")
+
+# The flags only tag : nothing is filtered, every event reaches the writer
+process.p = cms.Path(
+   process.EcalDeadCellEventFlagProducer *
+   process.simpleDRFlagProducer *
+   process.CSCBasedHaloFlagProducer *
+   process.logErrorFlagProducer *
+   process.METFlagBitwordProducer *
+   process.METFlagsShardWriter
+)
@@ -11,6 +11,9 @@ simpleDRFlagProducer = cms.EDFilter('simpleDRFlagProducer',
 
 # It's written in general that one can put pf, calo and tracking jets
   jetInputTag = cms.InputTag('ak5PFJets'),
+# Collection type of jetInputTag : "pf" (reco::PFJetCollection), "calo" (reco::CaloJetCollection) and "pat"
+# (std::vector<pat::Jet>) read the jets without virtual calls; "view" (edm::View<reco::Jet>) takes any jet type
+  jetCollectionType = cms.untracked.string( "view" ),
 # The pt and eta cuts applied, for instance, pt>30 && |eta|<9999
   jetSelCuts = cms.vdouble(30, 9999), # pt, eta
 
@@ -22,19 +25,38 @@ simpleDRFlagProducer = cms.EDFilter('simpleDRFlagProducer',
   makeProfileRoot = cms.untracked.bool( False ),
   profileRootName = cms.untracked.string( "simpleDRFlagProducer.root" ),
 
+# If enabled, per-stage timing (load, dR search) and per-lumi counts are written as JSON to <module label>_stats.json (or statsFileName) at endJob
+  enableStats = cms.untracked.bool( False ),
+
+# If set, decisions are cached by (run, lumi, event) and reused when the tracked parameters and the dead channel table are unchanged
+  sidecarInput = cms.untracked.string( "" ),
+  sidecarOutput = cms.untracked.string( "" ),
+
 # The status of masked cells we want to pick from global tag, for instance here, >=1
 # Don't need to change ususally.
   maskedEcalChannelStatusThreshold = cms.int32( 1 ),
+# If set, the dead channel table is the one of the EcalDeadChannelTableESProducer with this appendToDataLabel, made in the
+# EventSetup instead of at beginRun (statusMask 0xFFFFFFFF for the same table), see EcalDeadChannelTableESProducer_cfi.py
+# Its maskedEcalChannelStatusThreshold must be this one. Empty: the module builds it
+  deadChannelTableLabel = cms.untracked.string( "" ),
 # The channels status we want to evaluate
 # positive numbers, e.g., 12, means only channels with status 12 are considered
 # negative numbers, e.g., -12, means channels with status >=12 are all considered
   chnStatusToBeEvaluated = cms.int32(-12),
 
+# If enabled, ValueMaps on all the jets of jetInputTag with the nearest masked channel passing chnStatusToBeEvaluated :
+# deadChannelDR (float, 999 if none), deadChannelStatus (int, -1 if none), deadChannelTower (raw EcalTrigTowerDetId, 0 if none)
+  produceJetValueMaps = cms.untracked.bool( False ),
+
 # No usage now
   isProd = cms.untracked.bool( False ),
 
 # If enabled, also check if MET is due to cracks or not. If found, events are filtered
 # (if doFilter is enabled)
+# Stored statuses, 0 when nothing is found : deadCellStatus is the number of jets close to the MET
+# and to a masked channel; boundaryStatus has bits 2i (HB/HE) and 2i+1 (HE/HF) for the i-th jet
+# close to the MET, i < 15, and bit 30 for any later jet (always 0 when doCracks is disabled)
+# The unlabelled bool is false when either status is set
   doCracks = cms.untracked.bool( False ),
 
 # No usage now
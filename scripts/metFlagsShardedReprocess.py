@@ -0,0 +1,205 @@
+#!/usr/bin/env python
+"""Reprocesses the MET flags of a list of EDM files in lumi-range shards run as local cmsRun jobs,
+then merges the shards with metFlagsMergeShards into one output identical to a serial job.
+
+  metFlagsShardedReprocess.py -j 8 -g GR_R_42_V19::All -o flags.root files.txt
+  metFlagsShardedReprocess.py -j 8 -g GR_R_42_V19::All -o flags.root --check-serial a.root b.root
+
+Inputs are file names or text files (.txt) with one file name per line, in the order of the
+serial job. The (run, lumi) pairs of all files are split into contiguous shards of about the same
+number of lumis; a lumi is never split between shards. Each shard runs
+MyAnalysis/METFlags/python/metFlagsReprocess_cfg.py in its own directory of --workdir on the files
+holding its lumis, with METFlagsShardWriter told the position of each of them in the full list.
+"""
+
+import os
+import sys
+import subprocess
+import time
+from optparse import OptionParser
+
+
+def readFileList(args):
+    files = []
+    for arg in args:
+        if arg.endswith(".txt"):
+            for line in open(arg):
+                line = line.strip()
+                if line and not line.startswith("#"):
+                    files.append(line)
+        else:
+            files.append(arg)
+    return files
+
+
+def pfn(name):
+    if name.startswith("/store/"):
+        return name
+    if ":" in name.split("/")[0]:
+        return name
+    return "file:" + os.path.abspath(name)
+
+
+def scanLumis(files):
+    """(run, lumi) pairs of each file, read with FWLite"""
+    import ROOT
+    ROOT.gSystem.Load("libFWCoreFWLite")
+    ROOT.FWLiteEnabler.enable()
+    from DataFormats.FWLite import Lumis
+
+    lumisPerFile = []
+    for name in files:
+        lumis = set()
+        for lumi in Lumis(pfn(name)):
+            aux = lumi.luminosityBlockAuxiliary()
+            lumis.add((aux.run(), aux.luminosityBlock()))
+        lumisPerFile.append(lumis)
+    return lumisPerFile
+
+
+def makeShards(lumisPerFile, nShards):
+    """Contiguous ranges of the sorted lumis; each shard is (lumis, [file indices])"""
+    allLumis = sorted(set().union(*lumisPerFile)) if lumisPerFile else []
+    nShards = max(1, min(nShards, len(allLumis)))
+    shards = []
+    for ish in range(nShards):
+        lumis = allLumis[ish * len(allLumis) // nShards:(ish + 1) * len(allLumis) // nShards]
+        lumiSet = set(lumis)
+        fileIndices = [ifl for ifl, fileLumis in enumerate(lumisPerFile) if fileLumis & lumiSet]
+        shards.append((lumis, fileIndices))
+    return shards
+
+
+def lumiRanges(lumis):
+    """Sorted (run, lumi) pairs as LuminosityBlockRange strings, consecutive lumis of a run joined"""
+    ranges = []
+    for run, lumi in lumis:
+        if ranges and ranges[-1][0] == run and ranges[-1][2] == lumi - 1:
+            ranges[-1][2] = lumi
+        else:
+            ranges.append([run, lumi, lumi])
+    return ["%d:%d-%d:%d" % (run, first, run, last) for run, first, last in ranges]
+
+
+SHARD_CFG = """from MyAnalysis.METFlags.metFlagsReprocess_cfg import *
+
+process.source.fileNames = cms.untracked.vstring(%(fileNames)s)
+process.source.lumisToProcess = cms.untracked.VLuminosityBlockRange(%(lumis)s)
+process.GlobalTag.globaltag = %(globalTag)r
+
+process.METFlagsShardWriter.fileNames = process.source.fileNames
+process.METFlagsShardWriter.fileIndices = cms.untracked.vuint32(%(fileIndices)s)
+process.METFlagsShardWriter.outputFileName = "metFlagsShard.root"
+
+process.EcalDeadCellEventFlagProducer.makeProfileRoot = %(profile)s
+process.EcalDeadCellEventFlagProducer.profileRootName = "deadCellFilterProfile.root"
+"""
+
+
+def writeShardCfg(directory, files, lumis, fileIndices, options):
+    if not os.path.isdir(directory):
+        os.makedirs(directory)
+    cfg = SHARD_CFG % {
+        "fileNames": ", ".join(repr(pfn(files[ifl])) for ifl in fileIndices),
+        "lumis": ", ".join(repr(r) for r in lumiRanges(lumis)),
+        "globalTag": options.globalTag,
+        "fileIndices": ", ".join(str(ifl) for ifl in fileIndices),
+        "profile": options.profile,
+    }
+    open(os.path.join(directory, "shard_cfg.py"), "w").write(cfg)
+
+
+def runShards(directories, nJobs):
+    """cmsRun in each directory, at most nJobs at a time; returns the directories that failed"""
+    pending = list(directories)
+    running = []
+    failed = []
+    while pending or running:
+        while pending and len(running) < nJobs:
+            directory = pending.pop(0)
+            log = open(os.path.join(directory, "cmsRun.log"), "w")
+            running.append((directory, log, subprocess.Popen(["cmsRun", "shard_cfg.py"], cwd=directory,
+                                                             stdout=log, stderr=subprocess.STDOUT)))
+        time.sleep(1)
+        for job in list(running):
+            directory, log, proc = job
+            if proc.poll() is None:
+                continue
+            log.close()
+            running.remove(job)
+            if proc.returncode != 0:
+                failed.append(directory)
+                sys.stderr.write("%s failed with exit code %d, see %s\n" % (directory, proc.returncode, log.name))
+            else:
+                sys.stdout.write("%s done\n" % directory)
+    return failed
+
+
+def merge(directories, output, profileOutput, profile):
+    """metFlagsMergeShards on the shard outputs; returns its digest"""
+    command = ["metFlagsMergeShards", "-o", output, "--digest"]
+    if profile:
+        command += ["--profile", profileOutput]
+    for directory in directories:
+        shard = os.path.join(directory, "metFlagsShard.root")
+        if profile:
+            shard += ":" + os.path.join(directory, "deadCellFilterProfile.root")
+        command.append(shard)
+    out = subprocess.Popen(command, stdout=subprocess.PIPE).communicate()[0].decode()
+    sys.stdout.write(out)
+    for line in out.splitlines():
+        if line.startswith("digest "):
+            return line.split()[1]
+    return None
+
+
+def reprocess(files, lumisPerFile, nShards, workdir, output, options):
+    shards = makeShards(lumisPerFile, nShards)
+    directories = []
+    for ish, (lumis, fileIndices) in enumerate(shards):
+        directory = os.path.join(workdir, "shard%03d" % ish)
+        writeShardCfg(directory, files, lumis, fileIndices, options)
+        directories.append(directory)
+        sys.stdout.write("%s : %d lumis in %d files\n" % (directory, len(lumis), len(fileIndices)))
+
+    if runShards(directories, options.jobs):
+        return None
+    root, ext = os.path.splitext(output)
+    return merge(directories, output, root + "_profile" + ext, options.profile)
+
+
+def main():
+    parser = OptionParser(usage="%prog [options] <file or file list> ...")
+    parser.add_option("-j", "--jobs", type="int", default=4, help="cmsRun jobs run at the same time")
+    parser.add_option("-n", "--shards", type="int", default=0, help="number of shards (default: --jobs)")
+    parser.add_option("-w", "--workdir", default="metFlagsShards", help="directory of the shard jobs")
+    parser.add_option("-g", "--globaltag", dest="globalTag", help="global tag of the flag producers")
+    parser.add_option("-o", "--output", default="metFlags.root", help="merged output")
+    parser.add_option("--profile", action="store_true", default=False,
+                      help="also merge the profile trees of EcalDeadCellEventFlagProducer")
+    parser.add_option("--check-serial", dest="checkSerial", action="store_true", default=False,
+                      help="also run one job over all lumis and compare it to the merged shards")
+    options, args = parser.parse_args()
+
+    files = readFileList(args)
+    if not files or not options.globalTag:
+        parser.error("needs input files and a global tag")
+
+    lumisPerFile = scanLumis(files)
+    digest = reprocess(files, lumisPerFile, options.shards or options.jobs, options.workdir, options.output, options)
+    if digest is None:
+        return 1
+
+    if options.checkSerial:
+        root, ext = os.path.splitext(options.output)
+        serialDigest = reprocess(files, lumisPerFile, 1, os.path.join(options.workdir, "serial"), root + "_serial" + ext, options)
+        if serialDigest != digest:
+            sys.stderr.write("sharded digest %s differs from the serial one %s\n" % (digest, serialDigest))
+            return 1
+        sys.stdout.write("sharded and serial outputs are identical\n")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,85 @@
+#include "MyAnalysis/METFlags/interface/CSCHaloTrackAlgo.h"
+
+#include <cmath>
+
+void CSCTrackEndpoints::reset(){
+  innermost_global_z = 1500.;
+  outermost_global_z = 0.;
+  inner_.x = inner_.y = inner_.z = 0.;
+  outer_.x = outer_.y = outer_.z = 0.;
+  innerIndex_ = outerIndex_ = -1;
+  nHits_ = 0;
+}
+
+void CSCTrackEndpoints::add(const CSCHitPosition &hit){
+
+  const float absz = std::abs(hit.z);
+  // Get consituent rechit closest to calorimetry
+  if( absz < innermost_global_z ){ innermost_global_z = absz; inner_ = hit; }
+  // Get constituent rechit farthest from calorimetry
+  if( absz > outermost_global_z ){ outermost_global_z = absz; outer_ = hit; }
+  nHits_ ++;
+}
+
+void CSCTrackEndpoints::addCandidate(float absZ, int hitIndex){
+
+  if( absZ < innermost_global_z ){ innermost_global_z = absZ; innerIndex_ = hitIndex; }
+  if( absZ > outermost_global_z ){ outermost_global_z = absZ; outerIndex_ = hitIndex; }
+  nHits_ ++;
+}
+
+void CSCLayerZTable::clear(){
+  absZ_.assign(kEndcaps*kStations*kRings*kChambers*kLayers, 0.);
+}
+
+void CSCLayerZTable::setAbsZ(int endcap, int station, int ring, int chamber, int layer, float absZ){
+  const int idx = index_(endcap, station, ring, chamber, layer);
+  if( idx >= 0 ) absZ_[idx] = absZ;
+}
+
+float cscPointEta(const CSCHitPosition &p){
+  const float x = p.z/std::sqrt(p.x*p.x + p.y*p.y);
+  return std::log(x + std::sqrt(x*x + 1));
+}
+
+float cscPointPhi(const CSCHitPosition &p){ return std::atan2(p.y, p.x); }
+
+CSCHaloTrackFeatures computeHaloTrackFeatures(const CSCTrackEndpoints &endpoints, float outerMomentumTheta, float normChi2){
+
+  CSCHaloTrackFeatures features;
+
+  const CSCHitPosition &inner = endpoints.inner(), &outer = endpoints.outer();
+
+  if( endpoints.nHits() > 0 ){
+     features.deta = std::abs( cscPointEta(outer) - cscPointEta(inner) );
+     features.dphi = std::acos( std::cos( cscPointPhi(outer) - cscPointPhi(inner) ) );
+     features.flags |= CSCHaloTrackFeatures::kHasCSCEndpoints;
+  }
+  features.theta = outerMomentumTheta;
+  features.innerR = std::sqrt( inner.x*inner.x + inner.y*inner.y );
+  features.innerZ = inner.z;
+  features.outerR = std::sqrt( outer.x*outer.x + outer.y*outer.y );
+  features.outerZ = outer.z;
+  features.normChi2 = normChi2;
+  features.nCSCHits = endpoints.nHits();
+
+  return features;
+}
+
+bool passesHaloTrackCuts(const CSCHaloTrackFeatures &features, const CSCHaloTrackCuts &cuts){
+
+  if( features.nCSCHits < cuts.min_csc_hits ) return false;
+  if( features.deta < cuts.deta_threshold ) return false;
+  if( features.theta > cuts.min_outer_theta && features.theta < cuts.max_outer_theta ) return false;
+  if( features.dphi > cuts.dphi_threshold ) return false;
+  if( features.innerR < cuts.min_inner_radius ) return false;
+  if( features.innerR > cuts.max_inner_radius ) return false;
+  if( features.outerR < cuts.min_outer_radius ) return false;
+  if( features.outerR > cuts.max_outer_radius ) return false;
+  if( features.normChi2 > cuts.norm_chi2_threshold ) return false;
+
+  const float dz = features.dz();
+  if( dz && features.dr()/dz > cuts.max_dr_over_dz ) return false;
+
+  return true;
+}
@@ -0,0 +1,128 @@
+#include "MyAnalysis/METFlags/interface/CSCMuonExtrapolation.h"
+
+#include <cmath>
+#include <sstream>
+
+void CSCStationPlanes::clear(){
+  for(int is=0; is<kStations; is++){
+     for(int ir=0; ir<kRings; ir++){
+        rings_[is][ir].sumZ = 0.; rings_[is][ir].n = 0;
+        rings_[is][ir].rMin = 0.; rings_[is][ir].rMax = 0.;
+     }
+  }
+}
+
+void CSCStationPlanes::addChamber(int station, int ring, float absZ, float rMin, float rMax){
+
+  if( ring == 4 ) ring = 1;
+  if( station < 1 || station > kStations || ring < 1 || ring > kRings ) return;
+
+  Ring &r = rings_[station-1][ring-1];
+  if( r.n == 0 || rMin < r.rMin ) r.rMin = rMin;
+  if( r.n == 0 || rMax > r.rMax ) r.rMax = rMax;
+  r.sumZ += absZ; r.n ++;
+}
+
+float CSCStationPlanes::absZ(int station, int ring) const {
+  const Ring &r = ring_(station, ring);
+  return r.n > 0 ? float(r.sumZ/r.n) : 0.;
+}
+
+bool CSCMuonExtrapolator::modelFromName(const std::string &name, Model &model){
+  if( name == "straightLine" ){ model = kStraightLine; return true; }
+  if( name == "helix" ){ model = kHelix; return true; }
+  return false;
+}
+
+bool CSCMuonExtrapolator::toZ(const CSCTrackState &state, float z, CSCHitPosition &pos) const {
+
+  if( state.pz == 0. ) return false;
+
+  const double dz = z - state.z;
+  pos.z = z;
+
+  const double pt = std::sqrt( double(state.px)*state.px + double(state.py)*state.py );
+// Signed curvature (1/cm) of the transverse projection : d(phi)/dL = -0.0029979 q Bz / pt
+  const double kappa = model_ == kHelix && pt > 0. ? -0.0029979246*state.charge*bz_/pt : 0.;
+  const double length = dz*pt/state.pz;
+
+  if( std::abs(kappa*length) < 1e-6 ){
+     pos.x = state.x + dz*state.px/state.pz;
+     pos.y = state.y + dz*state.py/state.pz;
+     return true;
+  }
+
+  const double phi0 = std::atan2(double(state.py), double(state.px));
+  const double phi = phi0 + kappa*length;
+  pos.x = state.x + ( std::sin(phi) - std::sin(phi0) )/kappa;
+  pos.y = state.y - ( std::cos(phi) - std::cos(phi0) )/kappa;
+  return true;
+}
+
+void CSCMuonExtrapolator::crossings(const CSCTrackState &state, int track, const CSCStationPlanes &planes, std::vector<CSCStationCrossing> &out) const {
+
+  if( state.pz == 0. ) return;
+  const int endcap = state.pz > 0. ? 1 : 2;
+  const float side = state.pz > 0. ? 1. : -1.;
+
+  for(int station=1; station<=CSCStationPlanes::kStations; station++){
+     for(int ring=1; ring<=CSCStationPlanes::kRings; ring++){
+        if( !planes.has(station, ring) ) continue;
+
+        CSCStationCrossing crossing;
+        if( !toZ(state, side*planes.absZ(station, ring), crossing.pos) ) continue;
+
+        const float r = std::sqrt( crossing.pos.x*crossing.pos.x + crossing.pos.y*crossing.pos.y );
+        if( r < planes.rMin(station, ring) || r > planes.rMax(station, ring) ) continue;
+
+        crossing.track = track;
+        crossing.endcap = endcap; crossing.station = station; crossing.ring = ring; crossing.chamber = 0;
+        out.push_back(crossing);
+     }
+  }
+}
+
+void CSCMatchDistance::add(const CSCHitPosition &pos, float eta, float phi){
+  const float testDeta = std::abs( cscPointEta(pos) - eta );
+  const float testDphi = std::acos( std::cos( cscPointPhi(pos) - phi ) );
+  if( testDeta < deta ) deta = testDeta;
+  if( testDphi < dphi ) dphi = testDphi;
+}
+
+CSCMatchingAgreement::CSCMatchingAgreement() :
+  nResiduals_(0), sumDeta_(0.), sumDphi_(0.), maxDeta_(0.), maxDphi_(0.) {
+  for(int il=0; il<kNLevels; il++) both_[il] = neither_[il] = fullOnly_[il] = fastOnly_[il] = 0;
+}
+
+void CSCMatchingAgreement::addDecision(Level level, bool fullMatched, bool fastMatched){
+  if( fullMatched && fastMatched ) both_[level]++;
+  else if( fullMatched ) fullOnly_[level]++;
+  else if( fastMatched ) fastOnly_[level]++;
+  else neither_[level]++;
+}
+
+void CSCMatchingAgreement::addResidual(const CSCHitPosition &full, const CSCHitPosition &fast){
+  const float deta = std::abs( cscPointEta(full) - cscPointEta(fast) );
+  const float dphi = std::acos( std::cos( cscPointPhi(full) - cscPointPhi(fast) ) );
+  sumDeta_ += deta; sumDphi_ += dphi;
+  if( deta > maxDeta_ ) maxDeta_ = deta;
+  if( dphi > maxDphi_ ) maxDphi_ = dphi;
+  nResiduals_++;
+}
+
+std::string CSCMatchingAgreement::summary() const {
+
+  const char *levelNames[kNLevels] = { "trigger", "digi" };
+
+  std::ostringstream out;
+  for(int il=0; il<kNLevels; il++){
+     const Level level = Level(il);
+     out << levelNames[il] << " : " << decisions(level) << " candidates, " << agreed(level) << " same decision, "
+         << fullOnly_[il] << " matched by the associator only, " << fastOnly_[il] << " matched by the fast extrapolation only\n";
+  }
+  out << "residuals : " << nResiduals_ << " crossings";
+  if( nResiduals_ > 0 )
+    out << ", |deta| mean " << 1e3*sumDeta_/nResiduals_ << " max " << 1e3*maxDeta_
+        << ", dphi mean " << 1e3*sumDphi_/nResiduals_ << " max " << 1e3*maxDphi_ << " (1e-3)";
+  return out.str();
+}
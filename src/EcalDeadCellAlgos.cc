@@ -0,0 +1,279 @@
+#include "MyAnalysis/METFlags/interface/EcalDeadCellAlgos.h"
+#include "MyAnalysis/METFlags/interface/METFlagsStats.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+EcalDeadCellMethod selectDeadCellMethod(bool hasTPDigis, bool hasReducedRecHits, const std::string &releaseVersion){
+
+  if( hasTPDigis ) return kDeadCellTPMethod;
+  if( !hasReducedRecHits ) return kDeadCellNoInput;
+
+// Second and third "_" separated fields of the release (empty fields skipped), 0 if not a number
+  std::vector<std::string> fields;
+  std::string::size_type pos = 0;
+  while( pos <= releaseVersion.size() ){
+     std::string::size_type next = releaseVersion.find('_', pos);
+     if( next == std::string::npos ) next = releaseVersion.size();
+     if( next > pos ) fields.push_back(releaseVersion.substr(pos, next - pos));
+     pos = next + 1;
+  }
+  const int majorV = fields.size() > 1 ? std::atoi(fields[1].c_str()) : 0;
+  const int minorV = fields.size() > 2 ? std::atoi(fields[2].c_str()) : 0;
+
+  return majorV >=4 && minorV >=2 ? kDeadCellHITMethod : kDeadCellHITBefore42X;
+}
+
+const unsigned int EcalDeadTowerTPScale::nCodes;
+
+void EcalDeadTowerTPScale::reset(unsigned int nTowers){
+  et_.assign(nTowers*nCodes, 0.);
+  threshold_.assign(nTowers, nCodes);
+  monotonic_.assign(nTowers, 1);
+  etCut_ = 0;
+}
+
+void EcalDeadTowerTPScale::setCut(double etCut){
+
+  etCut_ = etCut;
+
+  for(unsigned int it=0; it<threshold_.size(); it++){
+// The threshold is the start of the run of passing codes that ends at the last code; the integer
+// comparison is only exact if no code below it passes
+     unsigned int threshold = nCodes;
+     while( threshold > 0 && et(it, threshold-1) >= etCut ) threshold--;
+     bool monotonic = true;
+     for(unsigned int code=0; code<threshold && monotonic; code++) monotonic = !( et(it, code) >= etCut );
+     threshold_[it] = threshold;
+     monotonic_[it] = monotonic;
+  }
+}
+
+void EcalDeadTowerEtSum::reset(const EcalDeadChannelTable &table, const EcalDeadChannelSelection &selection, int towerTest, bool doEEfilter){
+
+  table_ = &table; selection_ = &selection; towerTest_ = towerTest; doEEfilter_ = doEEfilter;
+
+// A table of another size (a new IOV) resizes the arrays; otherwise only the entries set by the
+// previous event are cleared, every one of them being listed in touched_ or seen_
+  const unsigned int nTowers = table.towers().size();
+  if( towerEt_.size() != nTowers || channelSeen_.size() != table.size() ){
+     towerEt_.assign(nTowers, 0.); towerChn_.assign(nTowers, 0); towerTestCnt_.assign(nTowers, -1);
+     channelSeen_.assign(table.size(), 0);
+  } else {
+     for(unsigned int it=0; it<touched_.size(); it++){ towerEt_[touched_[it]] = 0.; towerChn_[touched_[it]] = 0; towerTestCnt_[touched_[it]] = -1; }
+     for(unsigned int ic=0; ic<seen_.size(); ic++) channelSeen_[seen_[ic]] = 0;
+  }
+  touched_.clear(); seen_.clear(); touchedSorted_ = true;
+}
+
+int EcalDeadTowerEtSum::add(uint32_t rawId, double energy, bool isRecovered){
+
+  const int ic = table_->channelIndex(rawId);
+  if( ic < 0 ) return -1;
+
+  const EcalDeadChannelTable::Channel &chn = table_->channels()[ic];
+  if( !selection_->selected(ic) || !isRecovered ) return -1;
+  if( !doEEfilter_ && chn.subdet != 1 ) return -1;
+
+  const unsigned int it = chn.tower;
+  if( towerTestCnt_[it] < 0 ) towerTestCnt_[it] = table_->towerTestCount(it, towerTest_);
+
+// To be used before a bug fix : the same crystal must not be counted twice
+  if( channelSeen_[ic] ) return towerTestCnt_[it];
+  channelSeen_[ic] = 1; seen_.push_back(ic);
+
+  if( towerChn_[it] == 0 ){ touched_.push_back(it); touchedSorted_ = false; }
+  towerEt_[it] += energy*std::sin(chn.theta);
+  towerChn_[it] ++;
+
+  return towerTestCnt_[it];
+}
+
+void EcalDeadTowerEtSum::watchScratch(METFlagsScratchWatch &watch) const {
+  watch.watch(towerEt_); watch.watch(towerChn_); watch.watch(towerTestCnt_);
+  watch.watch(channelSeen_); watch.watch(seen_); watch.watch(touched_);
+}
+
+const std::vector<unsigned int>& EcalDeadTowerEtSum::touchedTowers() const {
+  if( !touchedSorted_ ){ std::sort(touched_.begin(), touched_.end()); touchedSorted_ = true; }
+  return touched_;
+}
+
+int EcalDeadTowerEtSum::status(double etCut) const {
+
+  int isPassCut = 0;
+
+  const std::vector<unsigned int> &towers = touchedTowers();
+  for(unsigned int it=0; it<towers.size(); it++){
+     if( towerEt_[towers[it]] >= etCut ){ isPassCut = 1; isPassCut *= table_->towers()[towers[it]].zside; }
+  }
+
+  return isPassCut;
+}
+
+int EcalDeadTowerEtSum::towersAboveCut(double etCut) const {
+
+  int nTowers = 0;
+
+  const std::vector<unsigned int> &towers = touchedTowers();
+  for(unsigned int it=0; it<towers.size(); it++){
+     if( towerEt_[towers[it]] >= etCut ) nTowers++;
+  }
+
+  return nTowers;
+}
+
+void EcalDeadTowerEtSum::summarize(double floor, EcalDeadTowerEtSummary &summary) const {
+
+  summary.clear();
+
+  const std::vector<unsigned int> &towers = touchedTowers();
+  for(unsigned int it=0; it<towers.size(); it++){
+     const EcalDeadChannelTable::Tower &tower = table_->towers()[towers[it]];
+     summary.addTower(tower.rawId, tower.zside, towerEt_[towers[it]], floor);
+  }
+}
+
+int EcalDeadTowerEtSum::evaluate(double etCut, int &nTowersAboveCut, double floor, EcalDeadTowerEtSummary *summary) const {
+
+  const int tagged = status(etCut);
+  nTowersAboveCut = tagged ? towersAboveCut(etCut) : 0;
+  if( summary ) summarize(floor, *summary);
+
+  return tagged;
+}
+
+int closestDeadChannel(const EcalDeadChannelTable &table, const EcalDeadChannelSelection &selection, double eta, double phi, double &minDist){
+
+  minDist = 999;
+  int minIdx = -1;
+
+  const std::vector<unsigned int> &selected = selection.channels();
+  for(unsigned int is=0; is<selected.size(); is++){
+
+     const EcalDeadChannelTable::Channel &chn = table.channels()[selected[is]];
+
+     const double dist = flagDeltaR(chn.eta, chn.phi, eta, phi);
+     if( minDist > dist ){ minDist = dist; minIdx = selected[is]; }
+  }
+
+  return minIdx;
+}
+
+int selectJetsCloseToMET(const std::vector<FlagJet> &jets, double metPhi, double dPhiCutVal, std::vector<FlagJet> &closeToMETjets){
+
+  closeToMETjets.clear();
+
+  for(unsigned int ij=0; ij<jets.size(); ij++){
+     const double deltaPhi = std::abs(flagDeltaPhi(jets[ij].phi, metPhi));
+     if( deltaPhi > dPhiCutVal ) continue;
+     closeToMETjets.push_back(jets[ij]);
+  }
+
+  return (int)closeToMETjets.size();
+}
+
+const unsigned int FlagJetCrackLUT::maxJets;
+const int FlagJetCrackLUT::kOverflow;
+
+void FlagJetCrackLUT::build(double hbheLo, double hbheHi, double hehfLo, double hehfHi){
+
+  lo_[0] = hbheLo; hi_[0] = hbheHi; lo_[1] = hehfLo; hi_[1] = hehfHi;
+
+// Up to the bin holding the last crack edge; beyond it no |eta| is in a crack
+  const double maxEdge = std::max(std::max(hbheLo, hbheHi), std::max(hehfLo, hehfHi));
+  const unsigned int nBins = maxEdge > 0 ? (unsigned int)(maxEdge/binWidth_) + 2 : 0;
+  maxAbsEta_ = nBins*binWidth_;
+  bits_.assign(nBins, 0); edgeBin_.assign(nBins, 0);
+
+// An edge on (or within rounding of) a bin boundary makes both neighbouring bins exact
+  const double tolerance = 1e-6*binWidth_;
+  for(unsigned int ib=0; ib<nBins; ib++){
+     const double binLo = ib*binWidth_, binHi = (ib+1)*binWidth_;
+     for(unsigned int ic=0; ic<2; ic++){
+        if( lo_[ic] >= binLo - tolerance && lo_[ic] <= binHi + tolerance ) edgeBin_[ib] = 1;
+        if( hi_[ic] >= binLo - tolerance && hi_[ic] <= binHi + tolerance ) edgeBin_[ib] = 1;
+        if( binLo > lo_[ic] && binHi < hi_[ic] ) bits_[ib] |= ( ic == 0 ? kHBHE : kHEHF );
+     }
+  }
+}
+
+int FlagJetCrackLUT::status(const std::vector<FlagJet> &jets) const {
+
+  int status = 0;
+  for(unsigned int ij=0; ij<jets.size(); ij++){
+     const unsigned int bits = crackBits(jets[ij].eta);
+     if( !bits ) continue;
+     if( ij < maxJets ) status |= bits << (2*ij);
+     else status |= kOverflow;
+  }
+
+  return status;
+}
+
+void nearestDeadChannels(const EcalDeadChannelTable &table, const EcalDeadChannelSelection &selection, const std::vector<FlagJet> &jets,
+                         std::vector<float> &dRs, std::vector<int> &statuses, std::vector<unsigned int> &towers){
+
+  dRs.assign(jets.size(), 999); statuses.assign(jets.size(), -1); towers.assign(jets.size(), 0);
+
+  for(unsigned int ij=0; ij<jets.size(); ij++){
+     double minDist = 999;
+     const int minIdx = closestDeadChannel(table, selection, jets[ij].eta, jets[ij].phi, minDist);
+     if( minIdx < 0 ) continue;
+
+     const EcalDeadChannelTable::Channel &chn = table.channels()[minIdx];
+     dRs[ij] = minDist; statuses[ij] = chn.status; towers[ij] = chn.ttRawId;
+  }
+}
+
+void SimpleDRStagePlan::build(double jetPtCut, double jetAbsEtaCut, double dPhiToMET, double dRtoDeadCell, bool doCracks,
+                              double hbheLo, double hbheHi, double hehfLo, double hehfHi){
+
+  jetPtCut_ = jetPtCut; jetAbsEtaCut_ = jetAbsEtaCut; dPhiToMET_ = dPhiToMET; dRtoDeadCell_ = dRtoDeadCell;
+  crackLUT_.build(hbheLo, hbheHi, hehfLo, hehfHi);
+
+  stages_.clear();
+  stages_.push_back(kSelectJets);
+  stages_.push_back(kDPhiToMET);
+  stages_.push_back(kDeadCell);
+  if( doCracks ) stages_.push_back(kCracks);
+}
+
+void SimpleDRStagePlan::run(const std::vector<FlagJet> &jets, double metPhi, const EcalDeadChannelTable &table, const EcalDeadChannelSelection &selection,
+                            int &dPhiToMETstatus, int &deadCellStatus, int &boundaryStatus){
+
+  dPhiToMETstatus = deadCellStatus = boundaryStatus = 0;
+  stageJets_.clear(); keptJets_.clear();
+
+  for(unsigned int is=0; is<stages_.size(); is++){
+     if( stages_[is] != kSelectJets && stageJets_.empty() ) break;
+
+     switch( stages_[is] ){
+        case kSelectJets :
+           for(unsigned int ij=0; ij<jets.size(); ij++){
+              if( jets[ij].pt > jetPtCut_ && std::abs(jets[ij].eta) < jetAbsEtaCut_ ) stageJets_.push_back(jets[ij]);
+           }
+           break;
+// All jets that are close to the MET within a dphi of dPhiToMET
+        case kDPhiToMET :
+           dPhiToMETstatus = selectJetsCloseToMET(stageJets_, metPhi, dPhiToMET_, keptJets_);
+           stageJets_.swap(keptJets_);
+           break;
+// A jet is close to a masked channel unless the nearest one is farther than dRtoDeadCell (> 0)
+        case kDeadCell :
+           for(unsigned int ij=0; ij<stageJets_.size(); ij++){
+              double minDist = 999;
+              closestDeadChannel(table, selection, stageJets_[ij].eta, stageJets_[ij].phi, minDist);
+              if( !(minDist > dRtoDeadCell_ && dRtoDeadCell_ >0) ) deadCellStatus++;
+           }
+           break;
+        case kCracks :
+           boundaryStatus = crackLUT_.status(stageJets_);
+           break;
+     }
+  }
+}
+
+void SimpleDRStagePlan::watchScratch(METFlagsScratchWatch &watch) const {
+  watch.watch(stageJets_, keptJets_);
+}
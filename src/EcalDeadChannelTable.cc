@@ -0,0 +1,130 @@
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTable.h"
+#include "MyAnalysis/METFlags/interface/METFlagsSidecar.h"
+
+#include <algorithm>
+
+namespace {
+  struct ChannelRawIdLess {
+    bool operator()(const EcalDeadChannelTable::Channel &a, const EcalDeadChannelTable::Channel &b) const { return a.rawId < b.rawId; }
+    bool operator()(const EcalDeadChannelTable::Channel &a, uint32_t b) const { return a.rawId < b; }
+  };
+  struct TowerRawIdLess {
+    bool operator()(const EcalDeadChannelTable::Tower &a, uint32_t b) const { return a.rawId < b; }
+  };
+}
+
+void EcalDeadChannelTable::clear(){
+  channels_.clear(); towers_.clear();
+}
+
+void EcalDeadChannelTable::addChannel(const Channel &channel){
+  channels_.push_back(channel);
+}
+
+void EcalDeadChannelTable::finalize(){
+
+  std::sort(channels_.begin(), channels_.end(), ChannelRawIdLess());
+
+// Collect the distinct towers, sorted by raw id
+  std::vector<uint32_t> ttRawIds;
+  ttRawIds.reserve(channels_.size());
+  for(unsigned int ic=0; ic<channels_.size(); ic++) ttRawIds.push_back(channels_[ic].ttRawId);
+  std::sort(ttRawIds.begin(), ttRawIds.end());
+  ttRawIds.erase(std::unique(ttRawIds.begin(), ttRawIds.end()), ttRawIds.end());
+
+// Keep the constituent counts of towers that were already known
+  std::vector<Tower> oldTowers; oldTowers.swap(towers_);
+  towers_.resize(ttRawIds.size());
+  for(unsigned int it=0; it<ttRawIds.size(); it++){
+     towers_[it].rawId = ttRawIds[it];
+     towers_[it].zside = 0;
+     towers_[it].nConstituents = 0;
+     std::vector<Tower>::const_iterator old = std::lower_bound(oldTowers.begin(), oldTowers.end(), ttRawIds[it], TowerRawIdLess());
+     if( old != oldTowers.end() && old->rawId == ttRawIds[it] ) towers_[it].nConstituents = old->nConstituents;
+  }
+
+  for(unsigned int ic=0; ic<channels_.size(); ic++){
+     const unsigned int it = towerIndex(channels_[ic].ttRawId);
+     channels_[ic].tower = it;
+     towers_[it].zside = channels_[ic].zside;
+     towers_[it].channels.push_back(ic);
+  }
+}
+
+void EcalDeadChannelTable::update(const std::vector<uint32_t> &removedRawIds, const std::vector<Channel> &added){
+
+  std::vector<uint32_t> removed(removedRawIds);
+  std::sort(removed.begin(), removed.end());
+
+  std::vector<Channel> kept;
+  kept.reserve(channels_.size() + added.size());
+  for(unsigned int ic=0; ic<channels_.size(); ic++){
+     if( !std::binary_search(removed.begin(), removed.end(), channels_[ic].rawId) ) kept.push_back(channels_[ic]);
+  }
+  kept.insert(kept.end(), added.begin(), added.end());
+  channels_.swap(kept);
+
+  finalize();
+}
+
+int EcalDeadChannelTable::channelIndex(uint32_t rawId) const {
+  std::vector<Channel>::const_iterator it = std::lower_bound(channels_.begin(), channels_.end(), rawId, ChannelRawIdLess());
+  if( it == channels_.end() || it->rawId != rawId ) return -1;
+  return it - channels_.begin();
+}
+
+int EcalDeadChannelTable::towerIndex(uint32_t ttRawId) const {
+  std::vector<Tower>::const_iterator it = std::lower_bound(towers_.begin(), towers_.end(), ttRawId, TowerRawIdLess());
+  if( it == towers_.end() || it->rawId != ttRawId ) return -1;
+  return it - towers_.begin();
+}
+
+int EcalDeadChannelTable::towerTestCount(unsigned int tower, int towerTest) const {
+  const Tower &tt = towers_[tower];
+  int matching = 0;
+  for(unsigned int ic=0; ic<tt.channels.size(); ic++){
+     if( statusSelected(channels_[tt.channels[ic]].status, towerTest) ) matching++;
+  }
+  return tt.nConstituents - matching;
+}
+
+void EcalDeadChannelSelection::build(const EcalDeadChannelTable &table, int chnStatus){
+
+  chnStatus_ = chnStatus;
+  channels_.clear(); towers_.clear(); ebTowers_.clear();
+  selected_.assign(table.size(), 0);
+
+// EB raw DetIds are below the EE ones : the EB channels already come first in the table
+  std::vector<unsigned int> eeChannels;
+  const std::vector<EcalDeadChannelTable::Channel> &channels = table.channels();
+  for(unsigned int ic=0; ic<channels.size(); ic++){
+     if( !EcalDeadChannelTable::statusSelected(channels[ic].status, chnStatus) ) continue;
+     selected_[ic] = 1;
+     if( channels[ic].subdet == 1 ) channels_.push_back(ic);
+     else eeChannels.push_back(ic);
+  }
+  nEBChannels_ = channels_.size();
+  channels_.insert(channels_.end(), eeChannels.begin(), eeChannels.end());
+
+// The crystals of a tower are all in EB or all in EE
+  const std::vector<EcalDeadChannelTable::Tower> &towers = table.towers();
+  for(unsigned int it=0; it<towers.size(); it++){
+     const std::vector<unsigned int> &members = towers[it].channels;
+     for(unsigned int im=0; im<members.size(); im++){
+        if( !selected_[members[im]] ) continue;
+        towers_.push_back(it);
+        if( channels[members[im]].subdet == 1 ) ebTowers_.push_back(it);
+        break;
+     }
+  }
+}
+
+uint64_t EcalDeadChannelTable::contentHash() const {
+  uint64_t hash = metFlagsHashValue<uint64_t>(channels_.size());
+  for(unsigned int ic=0; ic<channels_.size(); ic++){
+     hash = metFlagsHashValue(channels_[ic].rawId, hash);
+     hash = metFlagsHashValue(channels_[ic].status, hash);
+  }
+  for(unsigned int it=0; it<towers_.size(); it++) hash = metFlagsHashValue(towers_[it].nConstituents, hash);
+  return hash;
+}
@@ -0,0 +1,128 @@
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTableBuilder.h"
+
+#include "DataFormats/EcalDetId/interface/EBDetId.h"
+#include "DataFormats/EcalDetId/interface/EEDetId.h"
+#include "DataFormats/EcalDetId/interface/EcalTrigTowerDetId.h"
+#include "Geometry/CaloGeometry/interface/CaloCellGeometry.h"
+#include "Geometry/CaloGeometry/interface/CaloSubdetectorGeometry.h"
+
+static EcalDeadChannelTable::Channel makeChannel(const DetId &detid, int subdet, int ix, int iy, int iz, int status,
+                                                 const CaloGeometry &geometry, const EcalTrigTowerConstituentsMap &ttMap){
+
+  const CaloSubdetectorGeometry*  subGeom = geometry.getSubdetectorGeometry (detid);
+  const CaloCellGeometry*        cellGeom = subGeom->getGeometry (detid);
+
+  const EcalTrigTowerDetId ttDetId = ttMap.towerOf(detid);
+
+  EcalDeadChannelTable::Channel chn;
+  chn.rawId = detid.rawId();
+  chn.ttRawId = ttDetId.rawId();
+  chn.subdet = subdet;
+  chn.ix = ix; chn.iy = iy; chn.iz = iz;
+  chn.status = status;
+  chn.eta = cellGeom->getPosition ().eta ();
+  chn.phi = cellGeom->getPosition ().phi ();
+  chn.theta = cellGeom->getPosition().theta();
+  chn.zside = ttDetId.zside();
+  chn.tower = 0;
+
+  return chn;
+}
+
+static EcalDeadChannelTable::Channel makeEBChannel(unsigned int hashedIndex, int status, const CaloGeometry &geometry, const EcalTrigTowerConstituentsMap &ttMap){
+  const EBDetId detid = EBDetId::unhashIndex(hashedIndex);
+  return makeChannel(detid, 1, detid.ieta(), detid.iphi(), 0, status, geometry, ttMap);
+}
+
+static EcalDeadChannelTable::Channel makeEEChannel(unsigned int hashedIndex, int status, const CaloGeometry &geometry, const EcalTrigTowerConstituentsMap &ttMap){
+  const EEDetId detid = EEDetId::unhashIndex(hashedIndex);
+  return makeChannel(detid, 2, detid.ix(), detid.iy(), detid.zside(), status, geometry, ttMap);
+}
+
+void EcalDeadChannelTableBuilder::build(const EcalChannelStatus &ecalStatus, const CaloGeometry &geometry, const EcalTrigTowerConstituentsMap &ttMap,
+                                        EcalDeadChannelTable &table) {
+
+  table.clear();
+  table.setSelection(maskedEcalChannelStatusThreshold_, statusMask_);
+
+// The status items are indexed by the hashed index of the crystals: only the masked ones are
+// turned into DetIds and looked up in the geometry
+  const EcalChannelStatus::Items &ebItems = ecalStatus.barrelItems();
+  ebStatus_.resize(ebItems.size());
+  for(unsigned int ih=0; ih<ebItems.size(); ih++){
+     ebStatus_[ih] = selectedStatus(ebItems[ih]);
+     if( ebStatus_[ih] >= 0 ) table.addChannel(makeEBChannel(ih, ebStatus_[ih], geometry, ttMap));
+  }
+
+  const EcalChannelStatus::Items &eeItems = ecalStatus.endcapItems();
+  eeStatus_.resize(eeItems.size());
+  for(unsigned int ih=0; ih<eeItems.size(); ih++){
+     eeStatus_[ih] = selectedStatus(eeItems[ih]);
+     if( eeStatus_[ih] >= 0 ) table.addChannel(makeEEChannel(ih, eeStatus_[ih], geometry, ttMap));
+  }
+
+  table.finalize();
+  setTowerConstituents(ttMap, table);
+
+  built_ = true;
+  diff_.full = true; diff_.added = table.size(); diff_.removed = diff_.statusChanged = 0;
+}
+
+void EcalDeadChannelTableBuilder::update(const EcalChannelStatus &ecalStatus, const CaloGeometry &geometry, const EcalTrigTowerConstituentsMap &ttMap,
+                                         EcalDeadChannelTable &table) {
+
+  const EcalChannelStatus::Items &ebItems = ecalStatus.barrelItems();
+  const EcalChannelStatus::Items &eeItems = ecalStatus.endcapItems();
+  if( !built_ || ebItems.size() != ebStatus_.size() || eeItems.size() != eeStatus_.size() ){
+     build(ecalStatus, geometry, ttMap, table);
+     return;
+  }
+
+  diff_.full = false; diff_.added = diff_.removed = diff_.statusChanged = 0;
+
+// A channel whose selected status changed is removed and added back : with its old position when
+// it stays masked, with a new geometry lookup when it becomes masked
+  std::vector<uint32_t> removed;
+  std::vector<EcalDeadChannelTable::Channel> added;
+
+  for(unsigned int isub=0; isub<2; isub++){
+     const EcalChannelStatus::Items &items = isub == 0 ? ebItems : eeItems;
+     std::vector<int> &previous = isub == 0 ? ebStatus_ : eeStatus_;
+
+     for(unsigned int ih=0; ih<items.size(); ih++){
+        const int status = selectedStatus(items[ih]);
+        if( status == previous[ih] ) continue;
+
+        const uint32_t rawId = isub == 0 ? EBDetId::unhashIndex(ih).rawId() : EEDetId::unhashIndex(ih).rawId();
+        if( previous[ih] >= 0 ) removed.push_back(rawId);
+
+        if( status >= 0 && previous[ih] >= 0 ){
+           EcalDeadChannelTable::Channel chn = table.channels()[table.channelIndex(rawId)];
+           chn.status = status;
+           added.push_back(chn);
+           diff_.statusChanged++;
+        }
+        else if( status >= 0 ){
+           added.push_back(isub == 0 ? makeEBChannel(ih, status, geometry, ttMap) : makeEEChannel(ih, status, geometry, ttMap));
+           diff_.added++;
+        }
+        else diff_.removed++;
+
+        previous[ih] = status;
+     }
+  }
+
+  if( removed.empty() && added.empty() ) return;
+
+  table.update(removed, added);
+  setTowerConstituents(ttMap, table);
+}
+
+// Number of crystals per tower, for the tower completeness checks; only new towers need it
+void EcalDeadChannelTableBuilder::setTowerConstituents(const EcalTrigTowerConstituentsMap &ttMap, EcalDeadChannelTable &table) const {
+  for(unsigned int it=0; it<table.towers().size(); it++){
+     if( table.towers()[it].nConstituents > 0 ) continue;
+     const std::vector<DetId> vid = ttMap.constituentsOf( EcalTrigTowerDetId(table.towers()[it].rawId) );
+     table.setTowerConstituents(it, vid.size());
+  }
+}
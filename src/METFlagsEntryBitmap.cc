@@ -0,0 +1,169 @@
+#include "MyAnalysis/METFlags/interface/METFlagsEntryBitmap.h"
+
+#include <algorithm>
+#include <cstdio>
+
+// Layout (all integers little-endian):
+//   "MFEB" u32:version u64:nEntries u64:cardinality u32:guidLength guid
+//   u32:nContainers { u64:key u8:isBitmap u32:cardinality  u16 x cardinality  |  u64 x 1024 } x nContainers
+
+const uint32_t METFlagsEntryBitmap::formatVersion;
+const unsigned int METFlagsEntryBitmap::kArrayMax;
+
+namespace {
+  const unsigned int kBitmapWords = 65536/64;
+
+  template<class T> bool put(FILE *f, const T &v){ return fwrite(&v, sizeof(T), 1, f) == 1; }
+  template<class T> bool get(FILE *f, T &v){ return fread(&v, sizeof(T), 1, f) == 1; }
+
+  struct KeyLess {
+    template<class C> bool operator()(const C &c, uint64_t key) const { return c.key < key; }
+  };
+}
+
+METFlagsEntryBitmap::Container& METFlagsEntryBitmap::container(uint64_t key){
+
+  if( !containers_.empty() && containers_.back().key == key ) return containers_.back();
+
+  std::vector<Container>::iterator it = std::lower_bound(containers_.begin(), containers_.end(), key, KeyLess());
+  if( it != containers_.end() && it->key == key ) return *it;
+
+  Container c; c.key = key; c.cardinality = 0;
+  return *containers_.insert(it, c);
+}
+
+const METFlagsEntryBitmap::Container* METFlagsEntryBitmap::findContainer(uint64_t key) const {
+  std::vector<Container>::const_iterator it = std::lower_bound(containers_.begin(), containers_.end(), key, KeyLess());
+  if( it == containers_.end() || it->key != key ) return 0;
+  return &(*it);
+}
+
+void METFlagsEntryBitmap::add(uint64_t entry){
+
+  Container &c = container(entry >> 16);
+  const uint16_t low = entry & 0xFFFF;
+
+  if( c.isBitmap() ){
+     uint64_t &word = c.bits[low >> 6];
+     const uint64_t mask = uint64_t(1) << (low & 63);
+     if( word & mask ) return;
+     word |= mask;
+  } else {
+     if( c.array.empty() || c.array.back() < low ) c.array.push_back(low);
+     else {
+        std::vector<uint16_t>::iterator it = std::lower_bound(c.array.begin(), c.array.end(), low);
+        if( *it == low ) return;
+        c.array.insert(it, low);
+     }
+// Past kArrayMax values the bitmap is the smaller of the two
+     if( c.array.size() > kArrayMax ){
+        c.bits.assign(kBitmapWords, 0);
+        for(unsigned int ia=0; ia<c.array.size(); ia++) c.bits[c.array[ia] >> 6] |= uint64_t(1) << (c.array[ia] & 63);
+        std::vector<uint16_t>().swap(c.array);
+     }
+  }
+
+  c.cardinality++;
+  cardinality_++;
+}
+
+bool METFlagsEntryBitmap::contains(uint64_t entry) const {
+
+  const Container *c = findContainer(entry >> 16);
+  if( !c ) return false;
+
+  const uint16_t low = entry & 0xFFFF;
+  if( c->isBitmap() ) return c->bits[low >> 6] & (uint64_t(1) << (low & 63));
+  return std::binary_search(c->array.begin(), c->array.end(), low);
+}
+
+void METFlagsEntryBitmap::entries(std::vector<uint64_t> &out) const {
+
+  out.clear();
+  out.reserve(cardinality_);
+
+  for(unsigned int ic=0; ic<containers_.size(); ic++){
+     const Container &c = containers_[ic];
+     const uint64_t high = c.key << 16;
+     if( !c.isBitmap() ){
+        for(unsigned int ia=0; ia<c.array.size(); ia++) out.push_back(high | c.array[ia]);
+        continue;
+     }
+     for(unsigned int iw=0; iw<kBitmapWords; iw++){
+        for(uint64_t word = c.bits[iw]; word; word &= word - 1) out.push_back(high | (iw << 6) | __builtin_ctzll(word));
+     }
+  }
+}
+
+uint64_t METFlagsEntryBitmap::sizeInBytes() const {
+  uint64_t size = sizeof(uint32_t);
+  for(unsigned int ic=0; ic<containers_.size(); ic++){
+     size += sizeof(uint64_t) + sizeof(uint8_t) + sizeof(uint32_t);
+     size += containers_[ic].isBitmap() ? kBitmapWords*sizeof(uint64_t) : containers_[ic].array.size()*sizeof(uint16_t);
+  }
+  return size;
+}
+
+bool METFlagsEntryBitmap::write(const std::string &fileName, const std::string &guid, uint64_t nEntries) const {
+
+  FILE *f = fopen(fileName.c_str(), "wb");
+  if( !f ){ error_ = "cannot open " + fileName + " for writing"; return false; }
+
+  bool ok = fwrite("MFEB", 1, 4, f) == 4;
+  ok = ok && put<uint32_t>(f, formatVersion) && put<uint64_t>(f, nEntries) && put<uint64_t>(f, cardinality_);
+  ok = ok && put<uint32_t>(f, guid.size()) && fwrite(guid.data(), 1, guid.size(), f) == guid.size();
+
+  ok = ok && put<uint32_t>(f, containers_.size());
+  for(unsigned int ic=0; ok && ic<containers_.size(); ic++){
+     const Container &c = containers_[ic];
+     ok = put<uint64_t>(f, c.key) && put<uint8_t>(f, c.isBitmap()) && put<uint32_t>(f, c.cardinality);
+     if( ok && c.isBitmap() ) ok = fwrite(&c.bits[0], sizeof(uint64_t), kBitmapWords, f) == kBitmapWords;
+     else if( ok && !c.array.empty() ) ok = fwrite(&c.array[0], sizeof(uint16_t), c.array.size(), f) == c.array.size();
+  }
+
+  if( fclose(f) != 0 || !ok ){ error_ = "write error on " + fileName; return false; }
+  return true;
+}
+
+bool METFlagsEntryBitmap::read(const std::string &fileName, std::string &guid, uint64_t &nEntries){
+
+  clear();
+
+  FILE *f = fopen(fileName.c_str(), "rb");
+  if( !f ){ error_ = "cannot open " + fileName; return false; }
+
+  char magic[4];
+  uint32_t version = 0, guidLength = 0, nContainers = 0;
+  uint64_t cardinality = 0;
+  bool ok = fread(magic, 1, 4, f) == 4 && std::equal(magic, magic + 4, "MFEB");
+  ok = ok && get(f, version) && version == formatVersion;
+  if( !ok ){ fclose(f); error_ = fileName + " is not an entry bitmap of this version"; return false; }
+
+  ok = get(f, nEntries) && get(f, cardinality) && get(f, guidLength) && guidLength < 4096;
+  if( ok ){
+     std::vector<char> buffer(guidLength + 1, 0);
+     ok = fread(&buffer[0], 1, guidLength, f) == guidLength;
+     guid.assign(&buffer[0], guidLength);
+  }
+
+  ok = ok && get(f, nContainers);
+  for(uint32_t ic=0; ok && ic<nContainers; ic++){
+     Container c;
+     uint8_t isBitmap = 0;
+     ok = get(f, c.key) && get(f, isBitmap) && get(f, c.cardinality) && c.cardinality <= 65536;
+     if( !ok ) break;
+     if( isBitmap ){
+        c.bits.resize(kBitmapWords);
+        ok = fread(&c.bits[0], sizeof(uint64_t), kBitmapWords, f) == kBitmapWords;
+     } else {
+        c.array.resize(c.cardinality);
+        ok = c.cardinality <= kArrayMax && ( c.array.empty() || fread(&c.array[0], sizeof(uint16_t), c.array.size(), f) == c.array.size() );
+     }
+     ok = ok && ( containers_.empty() || containers_.back().key < c.key );
+     if( ok ){ containers_.push_back(c); cardinality_ += c.cardinality; }
+  }
+  fclose(f);
+
+  if( !ok || cardinality_ != cardinality ){ clear(); error_ = fileName + " is truncated or corrupted"; return false; }
+  return true;
+}
@@ -0,0 +1,186 @@
+#include "MyAnalysis/METFlags/interface/METFlagsReplayFixture.h"
+
+#include <cstdio>
+
+// Layout (all integers little-endian, floats IEEE 754 single precision):
+//   "MFRF" u32:version
+//   u32:nChannels  { u32:rawId u32:ttRawId i8:subdet i16:ix i16:iy i8:iz i16:status f64:eta f64:phi f64:theta i8:zside } x nChannels
+//   u32:nTowers    { u32:rawId u16:nConstituents } x nTowers
+//   u32:nEvents    { u32:run u32:lumi u64:event f32:metPt f32:metPhi
+//                    u32:nTPs    { u32:ttRawId u16:compressedEt f32:et } x nTPs
+//                    u32:nEBHits { u32:rawId f32:energy u8:isRecovered } x nEBHits
+//                    u32:nEEHits { ... }
+//                    u32:nJets   { f32:pt f32:eta f32:phi } x nJets
+//                    u32:nTracks { f32:theta f32:normChi2 u32:nHits { f32:x f32:y f32:z } x nHits } x nTracks } x nEvents
+
+namespace {
+
+  class FixtureWriter {
+   public:
+    explicit FixtureWriter(FILE *f) : f_(f), ok_(true) {}
+    template<class T> void put(T v){ if( ok_ && fwrite(&v, sizeof(T), 1, f_) != 1 ) ok_ = false; }
+    bool ok() const { return ok_; }
+   private:
+    FILE *f_;
+    bool ok_;
+  };
+
+  class FixtureReader {
+   public:
+    explicit FixtureReader(FILE *f) : f_(f), ok_(true) {}
+    template<class T> T get(){ T v = T(); if( ok_ && fread(&v, sizeof(T), 1, f_) != 1 ) ok_ = false; return v; }
+    // Element counts are bounded so that a corrupted file can not trigger huge allocations
+    uint32_t count(){ uint32_t n = get<uint32_t>(); if( n > (1u<<26) ) ok_ = false; return ok_ ? n : 0; }
+    bool ok() const { return ok_; }
+   private:
+    FILE *f_;
+    bool ok_;
+  };
+
+  void writeHits(FixtureWriter &w, const std::vector<ReplayRecHit> &hits){
+    w.put<uint32_t>(hits.size());
+    for(unsigned int ih=0; ih<hits.size(); ih++){
+       w.put<uint32_t>(hits[ih].rawId); w.put<float>(hits[ih].energy); w.put<uint8_t>(hits[ih].isRecovered);
+    }
+  }
+
+  void readHits(FixtureReader &r, std::vector<ReplayRecHit> &hits){
+    hits.resize(r.count());
+    for(unsigned int ih=0; ih<hits.size(); ih++){
+       hits[ih].rawId = r.get<uint32_t>(); hits[ih].energy = r.get<float>(); hits[ih].isRecovered = r.get<uint8_t>();
+    }
+  }
+}
+
+bool METFlagsReplayFixture::write(const std::string &fileName) const {
+
+  FILE *f = fopen(fileName.c_str(), "wb");
+  if( !f ){ error_ = "cannot open " + fileName + " for writing"; return false; }
+
+  FixtureWriter w(f);
+  w.put<char>('M'); w.put<char>('F'); w.put<char>('R'); w.put<char>('F');
+  w.put<uint32_t>(formatVersion);
+
+  const std::vector<EcalDeadChannelTable::Channel> &channels = table.channels();
+  w.put<uint32_t>(channels.size());
+  for(unsigned int ic=0; ic<channels.size(); ic++){
+     const EcalDeadChannelTable::Channel &chn = channels[ic];
+     w.put<uint32_t>(chn.rawId); w.put<uint32_t>(chn.ttRawId); w.put<int8_t>(chn.subdet);
+     w.put<int16_t>(chn.ix); w.put<int16_t>(chn.iy); w.put<int8_t>(chn.iz); w.put<int16_t>(chn.status);
+     w.put<double>(chn.eta); w.put<double>(chn.phi); w.put<double>(chn.theta); w.put<int8_t>(chn.zside);
+  }
+
+  const std::vector<EcalDeadChannelTable::Tower> &towers = table.towers();
+  w.put<uint32_t>(towers.size());
+  for(unsigned int it=0; it<towers.size(); it++){
+     w.put<uint32_t>(towers[it].rawId); w.put<uint16_t>(towers[it].nConstituents);
+  }
+
+  w.put<uint32_t>(events.size());
+  for(unsigned int ie=0; ie<events.size(); ie++){
+     const METFlagsReplayEvent &evt = events[ie];
+     w.put<uint32_t>(evt.run); w.put<uint32_t>(evt.lumi); w.put<uint64_t>(evt.event);
+     w.put<float>(evt.metPt); w.put<float>(evt.metPhi);
+
+     w.put<uint32_t>(evt.tps.size());
+     for(unsigned int ip=0; ip<evt.tps.size(); ip++){
+        w.put<uint32_t>(evt.tps[ip].ttRawId); w.put<uint16_t>(evt.tps[ip].compressedEt); w.put<float>(evt.tps[ip].et);
+     }
+
+     writeHits(w, evt.ebHits);
+     writeHits(w, evt.eeHits);
+
+     w.put<uint32_t>(evt.jets.size());
+     for(unsigned int ij=0; ij<evt.jets.size(); ij++){
+        w.put<float>(evt.jets[ij].pt); w.put<float>(evt.jets[ij].eta); w.put<float>(evt.jets[ij].phi);
+     }
+
+     w.put<uint32_t>(evt.tracks.size());
+     for(unsigned int it=0; it<evt.tracks.size(); it++){
+        const ReplayCosmicTrack &trk = evt.tracks[it];
+        w.put<float>(trk.outerMomentumTheta); w.put<float>(trk.normChi2);
+        w.put<uint32_t>(trk.hits.size());
+        for(unsigned int ih=0; ih<trk.hits.size(); ih++){
+           w.put<float>(trk.hits[ih].x); w.put<float>(trk.hits[ih].y); w.put<float>(trk.hits[ih].z);
+        }
+     }
+  }
+
+  const bool ok = w.ok();
+  if( fclose(f) != 0 || !ok ){ error_ = "write error on " + fileName; return false; }
+  return true;
+}
+
+bool METFlagsReplayFixture::read(const std::string &fileName) {
+
+  table.clear(); events.clear();
+
+  FILE *f = fopen(fileName.c_str(), "rb");
+  if( !f ){ error_ = "cannot open " + fileName; return false; }
+
+  FixtureReader r(f);
+  char magic[4];
+  for(int i=0; i<4; i++) magic[i] = r.get<char>();
+  const uint32_t version = r.get<uint32_t>();
+  if( !r.ok() || magic[0] != 'M' || magic[1] != 'F' || magic[2] != 'R' || magic[3] != 'F' ){
+     fclose(f); error_ = fileName + " is not a replay fixture"; return false;
+  }
+  if( version != formatVersion ){
+     fclose(f); error_ = fileName + " has an unsupported fixture version"; return false;
+  }
+
+  const uint32_t nChannels = r.count();
+  for(unsigned int ic=0; ic<nChannels && r.ok(); ic++){
+     EcalDeadChannelTable::Channel chn;
+     chn.rawId = r.get<uint32_t>(); chn.ttRawId = r.get<uint32_t>(); chn.subdet = r.get<int8_t>();
+     chn.ix = r.get<int16_t>(); chn.iy = r.get<int16_t>(); chn.iz = r.get<int8_t>(); chn.status = r.get<int16_t>();
+     chn.eta = r.get<double>(); chn.phi = r.get<double>(); chn.theta = r.get<double>(); chn.zside = r.get<int8_t>();
+     chn.tower = 0;
+     table.addChannel(chn);
+  }
+  table.finalize();
+
+  const uint32_t nTowers = r.count();
+  for(unsigned int it=0; it<nTowers && r.ok(); it++){
+     const uint32_t rawId = r.get<uint32_t>();
+     const int nConstituents = r.get<uint16_t>();
+     const int idx = table.towerIndex(rawId);
+     if( idx >= 0 ) table.setTowerConstituents(idx, nConstituents);
+  }
+
+  events.resize(r.count());
+  for(unsigned int ie=0; ie<events.size() && r.ok(); ie++){
+     METFlagsReplayEvent &evt = events[ie];
+     evt.run = r.get<uint32_t>(); evt.lumi = r.get<uint32_t>(); evt.event = r.get<uint64_t>();
+     evt.metPt = r.get<float>(); evt.metPhi = r.get<float>();
+
+     evt.tps.resize(r.count());
+     for(unsigned int ip=0; ip<evt.tps.size(); ip++){
+        evt.tps[ip].ttRawId = r.get<uint32_t>(); evt.tps[ip].compressedEt = r.get<uint16_t>(); evt.tps[ip].et = r.get<float>();
+     }
+     std::sort(evt.tps.begin(), evt.tps.end());
+
+     readHits(r, evt.ebHits);
+     readHits(r, evt.eeHits);
+
+     evt.jets.resize(r.count());
+     for(unsigned int ij=0; ij<evt.jets.size(); ij++){
+        evt.jets[ij].pt = r.get<float>(); evt.jets[ij].eta = r.get<float>(); evt.jets[ij].phi = r.get<float>();
+     }
+
+     evt.tracks.resize(r.count());
+     for(unsigned int it=0; it<evt.tracks.size() && r.ok(); it++){
+        ReplayCosmicTrack &trk = evt.tracks[it];
+        trk.outerMomentumTheta = r.get<float>(); trk.normChi2 = r.get<float>();
+        trk.hits.resize(r.count());
+        for(unsigned int ih=0; ih<trk.hits.size(); ih++){
+           trk.hits[ih].x = r.get<float>(); trk.hits[ih].y = r.get<float>(); trk.hits[ih].z = r.get<float>();
+        }
+     }
+  }
+
+  const bool ok = r.ok();
+  fclose(f);
+  if( !ok ){ error_ = fileName + " is truncated or corrupted"; table.clear(); events.clear(); return false; }
+  return true;
+}
@@ -0,0 +1,140 @@
+#include "MyAnalysis/METFlags/interface/METFlagsShardMerge.h"
+#include "MyAnalysis/METFlags/interface/METFlagsSidecar.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+  struct ProfileKey {
+    uint32_t run, lumi, event;
+    bool operator<(const ProfileKey &other) const {
+      if( run != other.run ) return run < other.run;
+      if( lumi != other.lumi ) return lumi < other.lumi;
+      return event < other.event;
+    }
+  };
+
+  // Rows are sorted by (position of their event in the merged events, run, lumi, event)
+  struct PositionedRow {
+    uint64_t position;
+    ProfileKey key;
+    unsigned int index;
+    bool operator<(const PositionedRow &other) const {
+      if( position != other.position ) return position < other.position;
+      if( key < other.key ) return true;
+      if( other.key < key ) return false;
+      return index < other.index;
+    }
+  };
+
+  uint64_t hashStrings(const std::vector<std::string> &strings, uint64_t hash){
+    hash = metFlagsHashValue<uint64_t>(strings.size(), hash);
+    for(unsigned int is=0; is<strings.size(); is++){
+       hash = metFlagsHashValue<uint64_t>(strings[is].size(), hash);
+       hash = metFlagsHash(strings[is], hash);
+    }
+    return hash;
+  }
+}
+
+bool METFlagsShardMerger::setSummaryNames(const std::vector<std::string> &names){
+  if( summaryNamesSet_ && names != summaryNames_ ){ error_ = "the shards have different lumi summaries"; return false; }
+  summaryNames_ = names; summaryNamesSet_ = true;
+  return true;
+}
+
+bool METFlagsShardMerger::addLumi(uint32_t run, uint32_t lumi, const std::vector<uint32_t> &values){
+
+  if( values.size() != summaryNames_.size() ){
+     std::ostringstream msg; msg << "lumi " << run << ":" << lumi << " has " << values.size() << " summaries, expected " << summaryNames_.size();
+     error_ = msg.str(); return false;
+  }
+
+  std::vector<uint32_t> &sum = lumis_[LumiKey(run, lumi)];
+  if( sum.empty() ) sum.assign(values.size(), 0);
+  for(unsigned int iv=0; iv<values.size(); iv++) sum[iv] += values[iv];
+  return true;
+}
+
+bool METFlagsShardMerger::addRun(uint32_t run, const METFlagsShardRun &info){
+
+  std::map<uint32_t, METFlagsShardRun>::iterator it = runs_.find(run);
+  if( it == runs_.end() ){ runs_[run] = info; return true; }
+
+  if( it->second.tableVersion != info.tableVersion || it->second.flagNames != info.flagNames ){
+     std::ostringstream msg; msg << "run " << run << " has different bitword layouts in two shards";
+     error_ = msg.str(); return false;
+  }
+  return true;
+}
+
+bool METFlagsShardMerger::finalize(){
+
+  std::sort(events_.begin(), events_.end());
+  for(unsigned int ie=1; ie<events_.size(); ie++){
+     if( events_[ie-1] < events_[ie] ) continue;
+     std::ostringstream msg;
+     msg << "event " << events_[ie].run << ":" << events_[ie].lumi << ":" << events_[ie].event << " of input file " << events_[ie].fileIndex
+         << " is in two shards : their lumi ranges overlap";
+     error_ = msg.str(); return false;
+  }
+
+  std::map<ProfileKey, uint64_t> positions;
+  for(unsigned int ie=0; ie<events_.size(); ie++){
+     ProfileKey key = { events_[ie].run, events_[ie].lumi, uint32_t(events_[ie].event) };
+     positions.insert(std::make_pair(key, ie));
+  }
+
+  std::vector<PositionedRow> order(profile_.size());
+  for(unsigned int ir=0; ir<profile_.size(); ir++){
+     ProfileKey key = { profile_[ir].run, profile_[ir].lumi, profile_[ir].event };
+     std::map<ProfileKey, uint64_t>::const_iterator pos = positions.find(key);
+     order[ir].position = pos == positions.end() ? events_.size() : pos->second;
+     order[ir].key = key;
+     order[ir].index = ir;
+  }
+  std::sort(order.begin(), order.end());
+
+  std::vector<METFlagsProfileRow> sorted(profile_.size());
+  for(unsigned int ir=0; ir<order.size(); ir++) sorted[ir] = profile_[order[ir].index];
+  profile_.swap(sorted);
+
+  return true;
+}
+
+uint64_t METFlagsShardMerger::digest() const {
+
+  uint64_t hash = hashStrings(summaryNames_, metFlagsHash(std::string("METFlagsShardMerger")));
+
+  hash = metFlagsHashValue<uint64_t>(events_.size(), hash);
+  for(unsigned int ie=0; ie<events_.size(); ie++){
+     const METFlagsShardEvent &evt = events_[ie];
+     hash = metFlagsHashValue(evt.run, hash); hash = metFlagsHashValue(evt.lumi, hash);
+     hash = metFlagsHashValue(evt.event, hash); hash = metFlagsHashValue(evt.bitword, hash);
+     hash = metFlagsHashValue(evt.fileIndex, hash); hash = metFlagsHashValue(evt.seq, hash);
+  }
+
+  hash = metFlagsHashValue<uint64_t>(lumis_.size(), hash);
+  for(std::map<LumiKey, std::vector<uint32_t> >::const_iterator it = lumis_.begin(); it != lumis_.end(); ++it){
+     hash = metFlagsHashValue(it->first.first, hash); hash = metFlagsHashValue(it->first.second, hash);
+     for(unsigned int iv=0; iv<it->second.size(); iv++) hash = metFlagsHashValue(it->second[iv], hash);
+  }
+
+  hash = metFlagsHashValue<uint64_t>(runs_.size(), hash);
+  for(std::map<uint32_t, METFlagsShardRun>::const_iterator it = runs_.begin(); it != runs_.end(); ++it){
+     hash = metFlagsHashValue(it->first, hash); hash = metFlagsHashValue(it->second.tableVersion, hash);
+     hash = hashStrings(it->second.flagNames, hash);
+  }
+
+  hash = metFlagsHashValue<uint64_t>(profile_.size(), hash);
+  for(unsigned int ir=0; ir<profile_.size(); ir++){
+     const METFlagsProfileRow &row = profile_[ir];
+     hash = metFlagsHashValue(row.run, hash); hash = metFlagsHashValue(row.lumi, hash); hash = metFlagsHashValue(row.event, hash);
+     hash = metFlagsHashValue<uint64_t>(row.cutFlowFlag.size(), hash);
+     for(unsigned int ic=0; ic<row.cutFlowFlag.size(); ic++) hash = metFlagsHashValue(row.cutFlowFlag[ic], hash);
+     hash = hashStrings(row.cutFlowStr, hash);
+  }
+
+  return hash;
+}
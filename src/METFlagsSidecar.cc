@@ -0,0 +1,200 @@
+#include "MyAnalysis/METFlags/interface/METFlagsSidecar.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Layout (little-endian, every section 8-byte aligned):
+//   header    : "MFSC" u32:version u64:configHash u32:nRuns u32:blockSize u64:nRecords      (32 bytes)
+//   runs      : { u32:run u32:0 u64:conditionsHash } x nRuns, sorted by run                   (16 bytes each)
+//   records   : { u32:run u32:lumi u64:event i32:value i32:aux } x nRecords, sorted by key     (24 bytes each)
+//   blockKeys : copy of records[i*blockSize] for every block                                  (24 bytes each)
+
+namespace {
+  struct SidecarHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t configHash;
+    uint32_t nRuns, blockSize;
+    uint64_t nRecords;
+  };
+
+  bool sameKey(const METFlagsSidecarRecord &a, const METFlagsSidecarRecord &b){
+    return a.run == b.run && a.lumi == b.lumi && a.event == b.event;
+  }
+
+  // Orders by key only; stable_sort keeps the insertion order of duplicated keys
+  struct KeyLess {
+    bool operator()(const METFlagsSidecarRecord &a, const METFlagsSidecarRecord &b) const { return a < b; }
+  };
+}
+
+uint64_t metFlagsHash(const void *data, std::size_t size, uint64_t hash){
+  const unsigned char *bytes = static_cast<const unsigned char*>(data);
+  for(std::size_t ib=0; ib<size; ib++){ hash ^= bytes[ib]; hash *= 1099511628211ULL; }
+  return hash;
+}
+
+METFlagsSidecar::METFlagsSidecar(const std::string &inputName, const std::string &outputName, uint64_t configHash) :
+  outputName_(outputName), configHash_(configHash), inputValid_(false), map_(0), mapSize_(0),
+  inRuns_(0), nInRuns_(0), inRecords_(0), nInRecords_(0), inBlockKeys_(0), nInBlocks_(0),
+  currentRun_(0), currentRunValid_(false), hits_(0), misses_(0) {
+
+  if( !inputName.empty() ) inputValid_ = openInput(inputName);
+}
+
+METFlagsSidecar::~METFlagsSidecar(){
+  if( map_ ) munmap(map_, mapSize_);
+}
+
+bool METFlagsSidecar::openInput(const std::string &fileName){
+
+  const int fd = ::open(fileName.c_str(), O_RDONLY);
+// A missing input is the normal first pass, not an error
+  if( fd < 0 ) return false;
+
+  struct stat st;
+  if( fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SidecarHeader) ){
+     ::close(fd); error_ = fileName + " is not a sidecar file"; return false;
+  }
+  mapSize_ = st.st_size;
+  map_ = mmap(0, mapSize_, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if( map_ == MAP_FAILED ){ map_ = 0; error_ = "cannot map " + fileName; return false; }
+
+  const char *base = static_cast<const char*>(map_);
+  SidecarHeader header;
+  std::memcpy(&header, base, sizeof(header));
+  if( std::memcmp(header.magic, "MFSC", 4) != 0 || header.version != formatVersion || header.blockSize != blockSize ){
+     error_ = fileName + " is not a sidecar file of this version"; return false;
+  }
+// Records of another configuration are never used
+  if( header.configHash != configHash_ ){ error_ = fileName + " was written with a different configuration"; return false; }
+
+  const uint64_t nBlocks = (header.nRecords + blockSize - 1)/blockSize;
+  const uint64_t expected = sizeof(SidecarHeader) + uint64_t(header.nRuns)*sizeof(RunConditions)
+                          + (header.nRecords + nBlocks)*sizeof(METFlagsSidecarRecord);
+  if( expected != mapSize_ ){ error_ = fileName + " is truncated or corrupted"; return false; }
+
+  inRuns_ = reinterpret_cast<const RunConditions*>(base + sizeof(SidecarHeader));
+  nInRuns_ = header.nRuns;
+  inRecords_ = reinterpret_cast<const METFlagsSidecarRecord*>(inRuns_ + nInRuns_);
+  nInRecords_ = header.nRecords;
+  inBlockKeys_ = inRecords_ + nInRecords_;
+  nInBlocks_ = nBlocks;
+
+  madvise(map_, mapSize_, MADV_RANDOM);
+  return true;
+}
+
+bool METFlagsSidecar::inputRunMatches(uint32_t run) const {
+  if( !inputValid_ || runs_.empty() ) return false;
+  RunConditions key; key.run = run;
+  const RunConditions *it = std::lower_bound(inRuns_, inRuns_ + nInRuns_, key);
+  if( it == inRuns_ + nInRuns_ || it->run != run ) return false;
+  const std::vector<RunConditions>::const_iterator cur = std::lower_bound(runs_.begin(), runs_.end(), key);
+  return cur != runs_.end() && cur->run == run && cur->hash == it->hash;
+}
+
+void METFlagsSidecar::beginRun(uint32_t run, uint64_t conditionsHash){
+
+  RunConditions conditions;
+  conditions.run = run; conditions.reserved = 0; conditions.hash = conditionsHash;
+  std::vector<RunConditions>::iterator it = std::lower_bound(runs_.begin(), runs_.end(), conditions);
+  if( it != runs_.end() && it->run == run ) it->hash = conditionsHash;
+  else runs_.insert(it, conditions);
+
+  currentRun_ = run;
+  currentRunValid_ = inputRunMatches(run);
+}
+
+bool METFlagsSidecar::lookup(uint32_t run, uint32_t lumi, uint64_t event, int32_t &value, int32_t &aux) const {
+
+  if( !currentRunValid_ || run != currentRun_ || !nInRecords_ ){ misses_++; return false; }
+
+  METFlagsSidecarRecord key;
+  key.run = run; key.lumi = lumi; key.event = event;
+
+// Last block whose first key is <= key, then the record within that block
+  const METFlagsSidecarRecord *block = std::upper_bound(inBlockKeys_, inBlockKeys_ + nInBlocks_, key);
+  if( block == inBlockKeys_ ){ misses_++; return false; }
+  const uint64_t first = uint64_t(block - 1 - inBlockKeys_)*blockSize;
+  const uint64_t last = std::min<uint64_t>(first + blockSize, nInRecords_);
+  const METFlagsSidecarRecord *it = std::lower_bound(inRecords_ + first, inRecords_ + last, key);
+  if( it == inRecords_ + last || !sameKey(*it, key) ){ misses_++; return false; }
+
+  value = it->value; aux = it->aux;
+  hits_++;
+  return true;
+}
+
+void METFlagsSidecar::record(uint32_t run, uint32_t lumi, uint64_t event, int32_t value, int32_t aux){
+  if( outputName_.empty() ) return;
+  METFlagsSidecarRecord rec;
+  rec.run = run; rec.lumi = lumi; rec.event = event; rec.value = value; rec.aux = aux;
+  records_.push_back(rec);
+}
+
+bool METFlagsSidecar::write(){
+
+  if( outputName_.empty() ) return true;
+
+// Carry over the input records of runs whose conditions are unchanged (or not seen in this job)
+  std::vector<RunConditions> runs;
+  std::vector<METFlagsSidecarRecord> records;
+  if( inputValid_ ){
+     for(uint32_t ir=0; ir<nInRuns_; ir++){
+        const std::vector<RunConditions>::const_iterator cur = std::lower_bound(runs_.begin(), runs_.end(), inRuns_[ir]);
+        if( cur != runs_.end() && cur->run == inRuns_[ir].run && cur->hash != inRuns_[ir].hash ) continue;
+        runs.push_back(inRuns_[ir]);
+     }
+     for(uint64_t ic=0; ic<nInRecords_; ic++){
+        RunConditions key; key.run = inRecords_[ic].run;
+        if( std::binary_search(runs.begin(), runs.end(), key) ) records.push_back(inRecords_[ic]);
+     }
+  }
+  for(unsigned int ir=0; ir<runs_.size(); ir++){
+     std::vector<RunConditions>::iterator it = std::lower_bound(runs.begin(), runs.end(), runs_[ir]);
+     if( it == runs.end() || it->run != runs_[ir].run ) runs.insert(it, runs_[ir]);
+  }
+
+// New records win over carried over ones with the same key
+  records.insert(records.end(), records_.begin(), records_.end());
+  std::stable_sort(records.begin(), records.end(), KeyLess());
+  std::vector<METFlagsSidecarRecord> unique;
+  unique.reserve(records.size());
+  for(unsigned int ic=0; ic<records.size(); ic++){
+     if( !unique.empty() && sameKey(unique.back(), records[ic]) ) unique.back() = records[ic];
+     else unique.push_back(records[ic]);
+  }
+
+  SidecarHeader header;
+  std::memcpy(header.magic, "MFSC", 4);
+  header.version = formatVersion;
+  header.configHash = configHash_;
+  header.nRuns = runs.size();
+  header.blockSize = blockSize;
+  header.nRecords = unique.size();
+
+  const std::string tmpName = outputName_ + ".tmp";
+  FILE *f = fopen(tmpName.c_str(), "wb");
+  if( !f ){ error_ = "cannot open " + tmpName + " for writing"; return false; }
+
+  bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+  if( ok && !runs.empty() ) ok = fwrite(&runs[0], sizeof(RunConditions), runs.size(), f) == runs.size();
+  if( ok && !unique.empty() ) ok = fwrite(&unique[0], sizeof(METFlagsSidecarRecord), unique.size(), f) == unique.size();
+  for(unsigned int ic=0; ok && ic<unique.size(); ic+=blockSize) ok = fwrite(&unique[ic], sizeof(METFlagsSidecarRecord), 1, f) == 1;
+  ok = (fclose(f) == 0) && ok;
+
+// The rename keeps a mapped input with the same name valid until it is unmapped
+  if( !ok || rename(tmpName.c_str(), outputName_.c_str()) != 0 ){
+     remove(tmpName.c_str());
+     error_ = "write error on " + outputName_;
+     return false;
+  }
+  return true;
+}
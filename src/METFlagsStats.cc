@@ -0,0 +1,150 @@
+#include "MyAnalysis/METFlags/interface/METFlagsStats.h"
+
+#include <fstream>
+
+namespace {
+  const char *stageNames[METFlagsStats::kNStages] = { "load", "methodSelect", "tpScan", "hitScan", "drSearch", "cosmicLoop", "ruleMatch", "sidecar", "muonMatching" };
+
+  unsigned int latencyBucket(uint64_t ticks){
+    unsigned int bucket = 0;
+    while( ticks && bucket < METFlagsStats::kNLatencyBuckets-1 ){ ticks >>= 1; bucket++; }
+    return bucket;
+  }
+}
+
+METFlagsStats::Block::Block(){
+  for(unsigned int is=0; is<kNStages; is++){ stageTicks[is] = 0; stageCalls[is] = 0; }
+  for(unsigned int ib=0; ib<kNLatencyBuckets; ib++) latency[ib] = 0;
+  scratchEvents = 0; scratchAllocations = 0;
+}
+
+METFlagsStats::METFlagsStats(const std::string &moduleLabel) : moduleLabel_(moduleLabel) {
+  pthread_key_create(&key_, 0);
+  pthread_mutex_init(&mutex_, 0);
+}
+
+METFlagsStats::~METFlagsStats(){
+  pthread_key_delete(key_);
+  pthread_mutex_destroy(&mutex_);
+  for(unsigned int ib=0; ib<blocks_.size(); ib++) delete blocks_[ib];
+}
+
+const char* METFlagsStats::tickUnit(){
+#if !defined(METFLAGS_NO_STATS) && (defined(__x86_64__) || defined(__i386__))
+  return "tsc";
+#else
+  return "ns";
+#endif
+}
+
+const char* METFlagsStats::stageName(Stage stage){
+  return stage < kNStages ? stageNames[stage] : "unknown";
+}
+
+// The first call on a thread registers a new block; later calls only cost the key lookup
+METFlagsStats::Block& METFlagsStats::local(){
+  Block *block = static_cast<Block*>(pthread_getspecific(key_));
+  if( !block ){
+     block = new Block();
+     pthread_mutex_lock(&mutex_);
+     blocks_.push_back(block);
+     pthread_mutex_unlock(&mutex_);
+     pthread_setspecific(key_, block);
+  }
+  return *block;
+}
+
+void METFlagsStats::addStage(Stage stage, uint64_t ticks){
+  Block &block = local();
+  block.stageTicks[stage] += ticks;
+  block.stageCalls[stage]++;
+}
+
+void METFlagsStats::addEvent(unsigned int run, unsigned int lumi, bool tagged, uint64_t latencyTicks){
+  Block &block = local();
+  block.latency[latencyBucket(latencyTicks)]++;
+  LumiCounts &counts = block.lumis[std::make_pair(run, lumi)];
+  counts.processed++;
+  if( tagged ) counts.tagged++;
+}
+
+void METFlagsStats::addScratchAllocations(unsigned int allocations){
+  Block &block = local();
+  block.scratchEvents++;
+  block.scratchAllocations += allocations;
+}
+
+unsigned int METFlagsScratchWatch::count(){
+  unsigned int allocations = 0;
+  for(unsigned int ib=0; ib<buffers_.size(); ib++){
+     const size_t capacity = buffers_[ib].capacity(buffers_[ib].buffer, buffers_[ib].swapped);
+     if( capacity != buffers_[ib].last ){ allocations++; buffers_[ib].last = capacity; }
+  }
+  return allocations;
+}
+
+void METFlagsStats::writeSummary(std::ostream &out) const {
+
+  Block total;
+  std::map<std::pair<unsigned int, unsigned int>, LumiCounts> lumis;
+
+  pthread_mutex_lock(&mutex_);
+  const unsigned int nThreads = blocks_.size();
+  for(unsigned int ib=0; ib<blocks_.size(); ib++){
+     const Block &block = *blocks_[ib];
+     for(unsigned int is=0; is<kNStages; is++){ total.stageTicks[is] += block.stageTicks[is]; total.stageCalls[is] += block.stageCalls[is]; }
+     for(unsigned int il=0; il<kNLatencyBuckets; il++) total.latency[il] += block.latency[il];
+     total.scratchEvents += block.scratchEvents; total.scratchAllocations += block.scratchAllocations;
+     for(std::map<std::pair<unsigned int, unsigned int>, LumiCounts>::const_iterator it = block.lumis.begin(); it != block.lumis.end(); ++it){
+        LumiCounts &counts = lumis[it->first];
+        counts.processed += it->second.processed;
+        counts.tagged += it->second.tagged;
+     }
+  }
+  pthread_mutex_unlock(&mutex_);
+
+  uint64_t processed = 0, tagged = 0;
+  for(std::map<std::pair<unsigned int, unsigned int>, LumiCounts>::const_iterator it = lumis.begin(); it != lumis.end(); ++it){
+     processed += it->second.processed; tagged += it->second.tagged;
+  }
+
+  out << "{\"module\":\"" << moduleLabel_ << "\",\"tickUnit\":\"" << tickUnit() << "\",\"threads\":" << nThreads
+      << ",\"processed\":" << processed << ",\"tagged\":" << tagged << ",\"stages\":{";
+  bool first = true;
+  for(unsigned int is=0; is<kNStages; is++){
+     if( !total.stageCalls[is] ) continue;
+     out << (first ? "" : ",") << "\"" << stageNames[is] << "\":{\"calls\":" << total.stageCalls[is] << ",\"ticks\":" << total.stageTicks[is] << "}";
+     first = false;
+  }
+
+// Bucket i holds latencies in [2^(i-1), 2^i) ticks; trailing empty buckets are dropped
+  unsigned int nBuckets = kNLatencyBuckets;
+  while( nBuckets > 0 && !total.latency[nBuckets-1] ) nBuckets--;
+  out << "},\"latencyLog2Buckets\":[";
+  for(unsigned int il=0; il<nBuckets; il++) out << (il ? "," : "") << total.latency[il];
+
+  out << "]";
+
+// Only for the producers watching their buffers
+  if( total.scratchEvents ){
+     out << ",\"scratchAllocations\":{\"events\":" << total.scratchEvents << ",\"allocations\":" << total.scratchAllocations
+         << ",\"perEvent\":" << double(total.scratchAllocations)/total.scratchEvents << "}";
+  }
+
+  out << ",\"lumis\":[";
+  first = true;
+  for(std::map<std::pair<unsigned int, unsigned int>, LumiCounts>::const_iterator it = lumis.begin(); it != lumis.end(); ++it){
+     out << (first ? "" : ",") << "{\"run\":" << it->first.first << ",\"lumi\":" << it->first.second
+         << ",\"processed\":" << it->second.processed << ",\"tagged\":" << it->second.tagged << "}";
+     first = false;
+  }
+  out << "]}";
+}
+
+bool METFlagsStats::writeSummary(const std::string &fileName) const {
+  std::ofstream out(fileName.c_str());
+  if( !out ) return false;
+  writeSummary(out);
+  out << std::endl;
+  return out.good();
+}
@@ -0,0 +1,11 @@
+#include "DataFormats/Common/interface/Wrapper.h"
+#include "MyAnalysis/METFlags/interface/CSCHaloTrackFeatures.h"
+#include <vector>
+
+namespace {
+  struct dictionary {
+    CSCHaloTrackFeatures haloTrackFeatures;
+    std::vector<CSCHaloTrackFeatures> haloTrackFeaturesVec;
+    edm::Wrapper<std::vector<CSCHaloTrackFeatures> > haloTrackFeaturesVecWrapper;
+  };
+}
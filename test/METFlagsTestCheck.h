@@ -0,0 +1,22 @@
+#ifndef MET_FLAGS_TEST_CHECK_H
+#define MET_FLAGS_TEST_CHECK_H
+
+// Minimal checks of the unit test executables of test/BuildFile.xml : a failed check prints the
+// expression and its line, and the executable returns metFlagsTestResult(), non zero on failure.
+
+#include <cstdio>
+
+namespace metFlagsTest {
+  inline unsigned int& failures() { static unsigned int n = 0; return n; }
+}
+
+#define METFLAGS_CHECK(cond) \
+  do { if( !(cond) ){ std::printf("%s:%d: check failed : %s\n", __FILE__, __LINE__, #cond); metFlagsTest::failures()++; } } while(0)
+
+inline int metFlagsTestResult(const char *name){
+  if( metFlagsTest::failures() ) std::printf("%s : %u checks failed\n", name, metFlagsTest::failures());
+  else std::printf("%s : OK\n", name);
+  return metFlagsTest::failures() ? 1 : 0;
+}
+
+#endif
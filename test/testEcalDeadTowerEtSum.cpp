@@ -0,0 +1,170 @@
+// EcalDeadTowerEtSum against the map-based sums EcalDeadCellEventFlagProducer used to make
+// (setEvtRecHitstatus), with one EcalDeadTowerEtSum reused over the events of two tables of
+// different sizes, so that the reset between events and on a table change are covered.
+
+#include "MyAnalysis/METFlags/interface/EcalDeadChannelTable.h"
+#include "MyAnalysis/METFlags/interface/EcalDeadCellAlgos.h"
+#include "MyAnalysis/METFlags/test/METFlagsTestCheck.h"
+
+#include <cmath>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace {
+
+  class Random {
+   public:
+    explicit Random(unsigned long long seed) : state_(seed) {}
+    double uniform(){
+      state_ = state_*6364136223846793005ULL + 1442695040888963407ULL;
+      return (state_ >> 11)*(1.0/9007199254740992.0);
+    }
+    unsigned int index(unsigned int n){ return (unsigned int)(uniform()*n); }
+   private:
+    unsigned long long state_;
+  };
+
+  struct RawId {
+    uint32_t id;
+    uint32_t rawId() const { return id; }
+  };
+
+  struct Hit {
+    RawId detId;
+    double e;
+    bool recovered;
+    const RawId& id() const { return detId; }
+    double energy() const { return e; }
+    bool isRecovered() const { return recovered; }
+  };
+
+  // nTowers towers of 25 crystals, the first half EB; nMasked masked crystals with status 12 to 14
+  void makeTable(EcalDeadChannelTable &table, unsigned int nTowers, unsigned int nMasked, Random &rnd){
+    table.clear();
+    std::set<uint32_t> used;
+    while( used.size() < nMasked ){
+       const unsigned int tower = rnd.index(nTowers), crystal = rnd.index(25);
+       const uint32_t rawId = 0x10000000 + tower*32 + crystal;
+       if( !used.insert(rawId).second ) continue;
+       EcalDeadChannelTable::Channel chn;
+       chn.rawId = rawId; chn.ttRawId = 0x20000000 + tower;
+       chn.subdet = tower < nTowers/2 ? 1 : 2;
+       chn.ix = tower; chn.iy = crystal; chn.iz = 0;
+       chn.status = 12 + rnd.index(3);
+       chn.eta = (tower%2 ? 1. : -1.)*(0.1 + 2.9*tower/nTowers); chn.phi = 0.1*crystal;
+       chn.theta = 2.*std::atan(std::exp(-chn.eta));
+       chn.zside = tower%2 ? 1 : -1;
+       chn.tower = 0;
+       table.addChannel(chn);
+    }
+    table.finalize();
+    for(unsigned int it=0; it<table.towers().size(); it++) table.setTowerConstituents(it, 25);
+  }
+
+  // Masked crystals (some twice), unmasked ones and not recovered ones
+  void makeHits(const EcalDeadChannelTable &table, Random &rnd, std::vector<Hit> &hits){
+    hits.clear();
+    const unsigned int nHits = rnd.index(60);
+    for(unsigned int ih=0; ih<nHits; ih++){
+       Hit hit;
+       const unsigned int kind = rnd.index(10);
+       hit.detId.id = kind == 0 ? 0x10000000 + rnd.index(100000) : table.channels()[rnd.index(table.size())].rawId;
+       hit.e = 40.*rnd.uniform();
+       hit.recovered = kind != 1;
+       hits.push_back(hit);
+       if( kind == 2 ) hits.push_back(hit);
+    }
+  }
+
+  // The sums of the producer before EcalDeadTowerEtSum : maps keyed by tower, a list against duplicates
+  struct Baseline {
+    std::map<uint32_t, double> towerEt;
+    std::map<uint32_t, int> towerZside;
+
+    Baseline(const EcalDeadChannelTable &table, const EcalDeadChannelSelection &selection, bool doEEfilter, const std::vector<Hit> &hits){
+      std::vector<uint32_t> avoidDuplicate;
+      for(unsigned int ih=0; ih<hits.size(); ih++){
+         const int ic = table.channelIndex(hits[ih].detId.id);
+         if( ic < 0 || !selection.selected(ic) || !hits[ih].recovered ) continue;
+         const EcalDeadChannelTable::Channel &chn = table.channels()[ic];
+         if( !doEEfilter && chn.subdet != 1 ) continue;
+         bool duplicate = false;
+         for(unsigned int id=0; id<avoidDuplicate.size(); id++) if( avoidDuplicate[id] == chn.rawId ) duplicate = true;
+         if( duplicate ) continue;
+         avoidDuplicate.push_back(chn.rawId);
+         towerEt[chn.ttRawId] += hits[ih].e*std::sin(chn.theta);
+         towerZside[chn.ttRawId] = chn.zside;
+      }
+    }
+
+    int status(double etCut) const {
+      int isPassCut = 0;
+      for(std::map<uint32_t, double>::const_iterator it = towerEt.begin(); it != towerEt.end(); ++it){
+         if( it->second >= etCut ){ isPassCut = 1; isPassCut *= towerZside.find(it->first)->second; }
+      }
+      return isPassCut;
+    }
+
+    int towersAboveCut(double etCut) const {
+      int n = 0;
+      for(std::map<uint32_t, double>::const_iterator it = towerEt.begin(); it != towerEt.end(); ++it) if( it->second >= etCut ) n++;
+      return n;
+    }
+  };
+}
+
+int main(){
+
+  Random rnd(20240611);
+  EcalDeadChannelTable small, large;
+  makeTable(small, 20, 60, rnd);
+  makeTable(large, 60, 400, rnd);
+  EcalDeadChannelSelection smallSelection, largeSelection;
+  smallSelection.build(small, 13);
+  largeSelection.build(large, 13);
+
+  const double cuts[4] = { 0., 5., 8., 20. };
+
+  EcalDeadTowerEtSum sum;
+  std::vector<Hit> hits;
+  unsigned int mismatches = 0, tagged = 0;
+  for(unsigned int iev=0; iev<600; iev++){
+
+// Table change every 100 events, EE off for every third event
+     const bool useLarge = (iev/100)%2;
+     const EcalDeadChannelTable &table = useLarge ? large : small;
+     const EcalDeadChannelSelection &selection = useLarge ? largeSelection : smallSelection;
+     const bool doEEfilter = iev%3 != 0;
+
+     makeHits(table, rnd, hits);
+     sum.reset(table, selection, 13, doEEfilter);
+     if( iev%2 ) sum.addHits(hits.begin(), hits.end());
+     else for(unsigned int ih=0; ih<hits.size(); ih++) sum.add(hits[ih].detId.id, hits[ih].e, hits[ih].recovered);
+
+     const Baseline baseline(table, selection, doEEfilter, hits);
+
+     const std::vector<unsigned int> &touched = sum.touchedTowers();
+     if( touched.size() != baseline.towerEt.size() ) mismatches++;
+     std::map<uint32_t, double>::const_iterator expected = baseline.towerEt.begin();
+     for(unsigned int it=0; it<touched.size() && expected != baseline.towerEt.end(); it++, ++expected){
+        if( table.towers()[touched[it]].rawId != expected->first ) mismatches++;
+        if( std::abs(sum.towerEt(touched[it]) - expected->second) > 1e-9*(1. + expected->second) ) mismatches++;
+     }
+
+     for(unsigned int ic=0; ic<4; ic++){
+        int nTowersAboveCut = -1;
+        const int status = sum.evaluate(cuts[ic], nTowersAboveCut, 0., 0);
+        if( status != baseline.status(cuts[ic]) ) mismatches++;
+        if( nTowersAboveCut != ( status ? baseline.towersAboveCut(cuts[ic]) : 0 ) ) mismatches++;
+        if( sum.towersAboveCut(cuts[ic]) != baseline.towersAboveCut(cuts[ic]) ) mismatches++;
+        if( ic == 2 && status ) tagged++;
+     }
+  }
+
+  METFLAGS_CHECK( mismatches == 0 );
+// The events must exercise both outcomes
+  METFLAGS_CHECK( tagged > 0 && tagged < 600 );
+
+  return metFlagsTestResult("testEcalDeadTowerEtSum");
+}
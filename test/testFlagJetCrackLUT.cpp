@@ -0,0 +1,75 @@
+// FlagJetCrackLUT against the direct crack check of simpleDRFlagProducer (lo < |eta| < hi), on a
+// fine eta grid, on the crack edges and next to them, and on the status of jet lists.
+
+#include "MyAnalysis/METFlags/interface/EcalDeadCellAlgos.h"
+#include "MyAnalysis/METFlags/test/METFlagsTestCheck.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+  unsigned int bruteForceBits(double eta, const double cracks[4]){
+    const double absEta = std::abs(eta);
+    return ( absEta > cracks[0] && absEta < cracks[1] ? FlagJetCrackLUT::kHBHE : 0 )
+         | ( absEta > cracks[2] && absEta < cracks[3] ? FlagJetCrackLUT::kHEHF : 0 );
+  }
+
+  int bruteForceStatus(const std::vector<FlagJet> &jets, const double cracks[4]){
+    int status = 0;
+    for(unsigned int ij=0; ij<jets.size(); ij++){
+       const unsigned int bits = bruteForceBits(jets[ij].eta, cracks);
+       if( bits ) status |= ij < FlagJetCrackLUT::maxJets ? int(bits << (2*ij)) : FlagJetCrackLUT::kOverflow;
+    }
+    return status;
+  }
+
+  unsigned int checkCracks(const double cracks[4]){
+
+    FlagJetCrackLUT lut;
+    lut.build(cracks[0], cracks[1], cracks[2], cracks[3]);
+
+    unsigned int mismatches = 0;
+    for(int i=-60000; i<=60000; i++){
+       const double eta = i*1e-4 + 3e-5;
+       if( lut.crackBits(eta) != bruteForceBits(eta, cracks) ) mismatches++;
+    }
+    for(unsigned int ic=0; ic<4; ic++){
+       const double edges[5] = { cracks[ic], std::nextafter(cracks[ic], 0.), std::nextafter(cracks[ic], 10.), cracks[ic] - 1e-9, cracks[ic] + 1e-9 };
+       for(unsigned int ie=0; ie<5; ie++){
+          if( lut.crackBits(edges[ie]) != bruteForceBits(edges[ie], cracks) ) mismatches++;
+          if( lut.crackBits(-edges[ie]) != bruteForceBits(-edges[ie], cracks) ) mismatches++;
+       }
+    }
+
+// Jet lists longer than maxJets, so that the overflow bit is used
+    unsigned long long state = 12345;
+    for(unsigned int iev=0; iev<2000; iev++){
+       std::vector<FlagJet> jets(iev % 20);
+       for(unsigned int ij=0; ij<jets.size(); ij++){
+          state = state*6364136223846793005ULL + 1442695040888963407ULL;
+          FlagJet jet = { 30., ((state >> 11)*(1.0/9007199254740992.0) - 0.5)*10., 0. };
+          jets[ij] = jet;
+       }
+       if( lut.status(jets) != bruteForceStatus(jets, cracks) ) mismatches++;
+    }
+
+    return mismatches;
+  }
+}
+
+int main(){
+
+// simpleDRFlagProducer defaults, edges on bin boundaries, overlapping cracks, and an empty one
+  const double defaults[4] = { 1.3, 1.7, 2.8, 3.2 };
+  const double onBins[4] = { 1.0, 2.0, 2.5, 3.0 };
+  const double overlapping[4] = { 1.234567, 2.9, 2.5, 4.999 };
+  const double empty[4] = { 1.5, 1.5, 0., 0. };
+
+  METFLAGS_CHECK( checkCracks(defaults) == 0 );
+  METFLAGS_CHECK( checkCracks(onBins) == 0 );
+  METFLAGS_CHECK( checkCracks(overlapping) == 0 );
+  METFLAGS_CHECK( checkCracks(empty) == 0 );
+
+  return metFlagsTestResult("testFlagJetCrackLUT");
+}
@@ -0,0 +1,76 @@
+// METFlagsEntryBitmap : the entries read back from a file are those added, in array and bitmap
+// containers, and a bitmap is only read from an intact file of the same format.
+
+#include "MyAnalysis/METFlags/interface/METFlagsEntryBitmap.h"
+#include "MyAnalysis/METFlags/test/METFlagsTestCheck.h"
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+int main(){
+
+  char name[64];
+  std::snprintf(name, sizeof(name), "testMETFlagsEntryBitmap_%d.bin", (int)getpid());
+  const std::string fileName = name;
+
+// Sparse entries in a few groups, one dense group above kArrayMax, one entry added out of order
+  std::set<uint64_t> expected;
+  METFlagsEntryBitmap bitmap;
+  for(uint64_t entry=3; entry<200000; entry+=977){ bitmap.add(entry); expected.insert(entry); }
+  for(uint64_t entry=(5ULL<<16); entry<(5ULL<<16) + 3*METFlagsEntryBitmap::kArrayMax; entry+=2){ bitmap.add(entry); expected.insert(entry); }
+  bitmap.add(7ULL<<32); expected.insert(7ULL<<32);
+  bitmap.add(10); expected.insert(10);
+  bitmap.add(10);
+
+  METFLAGS_CHECK( bitmap.cardinality() == expected.size() );
+  std::vector<uint64_t> entries;
+  bitmap.entries(entries);
+  METFLAGS_CHECK( entries == std::vector<uint64_t>(expected.begin(), expected.end()) );
+
+  const std::string guid = "0A1B2C3D-0000-1111-2222-333344445555";
+  METFLAGS_CHECK( bitmap.write(fileName, guid, 123456789) );
+
+  METFlagsEntryBitmap read;
+  std::string readGuid;
+  uint64_t nEntries = 0;
+  METFLAGS_CHECK( read.read(fileName, readGuid, nEntries) );
+  METFLAGS_CHECK( readGuid == guid && nEntries == 123456789 );
+  METFLAGS_CHECK( read.cardinality() == bitmap.cardinality() );
+  std::vector<uint64_t> readEntries;
+  read.entries(readEntries);
+  METFLAGS_CHECK( readEntries == entries );
+
+  bool same = true;
+  for(uint64_t entry=0; entry<(6ULL<<16); entry++){
+     if( read.contains(entry) != ( expected.count(entry) > 0 ) ) same = false;
+  }
+  METFLAGS_CHECK( same );
+  METFLAGS_CHECK( read.contains(7ULL<<32) && !read.contains((7ULL<<32) + 1) );
+
+// Truncated file
+  std::FILE *f = std::fopen(fileName.c_str(), "rb");
+  std::vector<char> content;
+  if( f ){
+     char buffer[4096];
+     size_t n = 0;
+     while( (n = std::fread(buffer, 1, sizeof(buffer), f)) > 0 ) content.insert(content.end(), buffer, buffer + n);
+     std::fclose(f);
+  }
+  METFLAGS_CHECK( content.size() > 16 );
+  f = std::fopen(fileName.c_str(), "wb");
+  if( f ){ std::fwrite(&content[0], 1, content.size()/2, f); std::fclose(f); }
+  METFlagsEntryBitmap truncated;
+  METFLAGS_CHECK( !truncated.read(fileName, readGuid, nEntries) && !truncated.error().empty() );
+
+// Not a bitmap file
+  f = std::fopen(fileName.c_str(), "wb");
+  if( f ){ std::fputs("not a bitmap", f); std::fclose(f); }
+  METFlagsEntryBitmap other;
+  METFLAGS_CHECK( !other.read(fileName, readGuid, nEntries) );
+
+  std::remove(fileName.c_str());
+  return metFlagsTestResult("testMETFlagsEntryBitmap");
+}
@@ -0,0 +1,109 @@
+// METFlagsShardMerger : the merge does not depend on how the lumis were split nor on the order the
+// shards are added, and two shards holding the same event are refused.
+
+#include "MyAnalysis/METFlags/interface/METFlagsShardMerge.h"
+#include "MyAnalysis/METFlags/test/METFlagsTestCheck.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+  struct Shard {
+    std::vector<METFlagsShardEvent> events;
+    std::vector<std::pair<METFlagsShardMerger::LumiKey, std::vector<uint32_t> > > lumis;
+    std::vector<METFlagsProfileRow> profile;
+  };
+
+  METFlagsShardRun runInfo(){
+    METFlagsShardRun info;
+    info.tableVersion = 2;
+    info.flagNames.push_back("EcalDeadCell"); info.flagNames.push_back("simpleDR");
+    return info;
+  }
+
+  // Events of file 0, run 1, lumis [firstLumi, lastLumi], 4 events per lumi; the last lumi of the
+  // file continues in file 1
+  Shard makeShard(uint32_t firstLumi, uint32_t lastLumi){
+    Shard shard;
+    for(uint32_t lumi=firstLumi; lumi<=lastLumi; lumi++){
+       for(uint32_t seq=0; seq<4; seq++){
+          METFlagsShardEvent evt = { 1, lumi, 1000*lumi + 7 - seq, uint64_t(seq%2), lumi == 6 && seq >= 2 ? 1u : 0u, 4*lumi + seq };
+          shard.events.push_back(evt);
+          METFlagsProfileRow row;
+          row.run = 1; row.lumi = lumi; row.event = uint32_t(evt.event);
+          row.cutFlowFlag.push_back(int(seq));
+          row.cutFlowStr.push_back("cut");
+          shard.profile.push_back(row);
+       }
+       std::vector<uint32_t> values(2, 0);
+       values[0] = 4; values[1] = lumi;
+       shard.lumis.push_back(std::make_pair(METFlagsShardMerger::LumiKey(1, lumi), values));
+    }
+    return shard;
+  }
+
+  bool add(METFlagsShardMerger &merger, const Shard &shard, bool reverse){
+    std::vector<std::string> names(1, "processed"); names.push_back("tagged");
+    bool ok = merger.setSummaryNames(names) && merger.addRun(1, runInfo());
+    std::vector<METFlagsShardEvent> events = shard.events;
+    std::vector<METFlagsProfileRow> profile = shard.profile;
+    if( reverse ){ std::reverse(events.begin(), events.end()); std::reverse(profile.begin(), profile.end()); }
+    for(unsigned int ie=0; ie<events.size(); ie++) merger.addEvent(events[ie]);
+    for(unsigned int ir=0; ir<profile.size(); ir++) merger.addProfileRow(profile[ir]);
+    for(unsigned int il=0; il<shard.lumis.size(); il++) ok = merger.addLumi(shard.lumis[il].first.first, shard.lumis[il].first.second, shard.lumis[il].second) && ok;
+    return ok;
+  }
+}
+
+int main(){
+
+  const Shard serial = makeShard(1, 9);
+  const Shard a = makeShard(1, 3), b = makeShard(4, 6), c = makeShard(7, 9);
+
+  METFlagsShardMerger serialMerger;
+  METFLAGS_CHECK( add(serialMerger, serial, false) && serialMerger.finalize() );
+
+// Serial order : by file, then run, lumi and position in the file
+  const std::vector<METFlagsShardEvent> &events = serialMerger.events();
+  METFLAGS_CHECK( events.size() == 36 );
+  bool ordered = true;
+  for(unsigned int ie=1; ie<events.size(); ie++) if( !(events[ie-1] < events[ie]) ) ordered = false;
+  METFLAGS_CHECK( ordered );
+  METFLAGS_CHECK( !events.empty() && events.back().fileIndex == 1 && events.back().lumi == 6 );
+
+// Profile rows follow the merged events
+  const std::vector<METFlagsProfileRow> &rows = serialMerger.profileRows();
+  bool rowsFollow = rows.size() == events.size();
+  for(unsigned int ir=0; rowsFollow && ir<rows.size(); ir++) rowsFollow = rows[ir].event == uint32_t(events[ir].event);
+  METFLAGS_CHECK( rowsFollow );
+
+// Any shard order, any insertion order
+  METFlagsShardMerger forward, backward;
+  METFLAGS_CHECK( add(forward, a, false) && add(forward, b, false) && add(forward, c, false) && forward.finalize() );
+  METFLAGS_CHECK( add(backward, c, true) && add(backward, a, true) && add(backward, b, false) && backward.finalize() );
+  METFLAGS_CHECK( forward.digest() == serialMerger.digest() );
+  METFLAGS_CHECK( backward.digest() == serialMerger.digest() );
+  METFLAGS_CHECK( forward.lumis() == serialMerger.lumis() );
+
+// A lumi split between two shards (two input files) is summed
+  METFlagsShardMerger split;
+  Shard d = makeShard(10, 10), e = makeShard(10, 10);
+  for(unsigned int ie=0; ie<e.events.size(); ie++){ e.events[ie].fileIndex = 2; e.events[ie].event += 100; }
+  METFLAGS_CHECK( add(split, d, false) && add(split, e, false) && split.finalize() );
+  METFLAGS_CHECK( split.lumis().size() == 1 && split.lumis().begin()->second[0] == 8 && split.lumis().begin()->second[1] == 20 );
+
+// Overlapping lumi ranges : the same event in two shards
+  METFlagsShardMerger overlap;
+  METFLAGS_CHECK( add(overlap, makeShard(1, 4), false) && add(overlap, makeShard(4, 6), false) );
+  METFLAGS_CHECK( !overlap.finalize() && !overlap.error().empty() );
+
+// Different bitword layouts of a run
+  METFlagsShardMerger layouts;
+  METFlagsShardRun other = runInfo();
+  other.flagNames.push_back("CSCHalo");
+  METFLAGS_CHECK( layouts.addRun(1, runInfo()) && !layouts.addRun(1, other) );
+
+  return metFlagsTestResult("testMETFlagsShardMerge");
+}
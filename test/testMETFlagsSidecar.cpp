@@ -0,0 +1,89 @@
+// Round trip of METFlagsSidecar : records written by one job are found by the next one with the
+// same configuration and conditions, and only then. Blocks of several records so that the block
+// index of lookup() is used.
+
+#include "MyAnalysis/METFlags/interface/METFlagsSidecar.h"
+#include "MyAnalysis/METFlags/test/METFlagsTestCheck.h"
+
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+int main(){
+
+  char name[64];
+  std::snprintf(name, sizeof(name), "testMETFlagsSidecar_%d.bin", (int)getpid());
+  const std::string fileName = name;
+
+  const uint64_t config = metFlagsHash(std::string("config"));
+  const uint64_t conditions = metFlagsHash(std::string("conditions"));
+  const unsigned int nEvents = 3*METFlagsSidecar::blockSize + 17;
+
+// Written in decreasing order : write() sorts
+  {
+     METFlagsSidecar out("", fileName, config);
+     out.beginRun(2, conditions);
+     for(unsigned int ie=nEvents; ie>0; ie--) out.record(2, 1 + ie/100, ie, int32_t(ie%3), -int32_t(ie));
+     out.beginRun(1, conditions);
+     out.record(1, 1, 5, 7, 8);
+     METFLAGS_CHECK( out.write() );
+  }
+
+  {
+     METFlagsSidecar in(fileName, "", config);
+     METFLAGS_CHECK( in.inputValid() );
+     in.beginRun(2, conditions);
+     bool all = true;
+     for(unsigned int ie=1; ie<=nEvents; ie++){
+        int32_t value = -1, aux = 0;
+        if( !in.lookup(2, 1 + ie/100, ie, value, aux) || value != int32_t(ie%3) || aux != -int32_t(ie) ) all = false;
+     }
+     METFLAGS_CHECK( all );
+     int32_t value = 0, aux = 0;
+     METFLAGS_CHECK( !in.lookup(2, 1, nEvents + 1, value, aux) );
+     METFLAGS_CHECK( !in.lookup(2, 99, 1, value, aux) );
+     METFLAGS_CHECK( !in.lookup(1, 1, 5, value, aux) );   // not the current run
+     in.beginRun(1, conditions);
+     METFLAGS_CHECK( in.lookup(1, 1, 5, value, aux) && value == 7 && aux == 8 );
+     METFLAGS_CHECK( in.hits() == nEvents + 1 );
+  }
+
+// Other conditions of the run : nothing is reused
+  {
+     METFlagsSidecar in(fileName, "", config);
+     in.beginRun(2, conditions + 1);
+     int32_t value = 0, aux = 0;
+     METFLAGS_CHECK( !in.lookup(2, 1, 5, value, aux) );
+  }
+
+// Other configuration : the input is refused
+  {
+     METFlagsSidecar in(fileName, "", config + 1);
+     METFLAGS_CHECK( !in.inputValid() && !in.error().empty() );
+     in.beginRun(2, conditions);
+     int32_t value = 0, aux = 0;
+     METFLAGS_CHECK( !in.lookup(2, 1, 5, value, aux) );
+  }
+
+// Same file as input and output : the records of the unchanged run are carried over, those of
+// the run with new conditions dropped, new records win
+  {
+     METFlagsSidecar both(fileName, fileName, config);
+     both.beginRun(1, conditions + 1);
+     both.beginRun(2, conditions);
+     both.record(2, 1, 5, 42, 0);
+     METFLAGS_CHECK( both.write() );
+  }
+  {
+     METFlagsSidecar in(fileName, "", config);
+     int32_t value = 0, aux = 0;
+     in.beginRun(2, conditions);
+     METFLAGS_CHECK( in.lookup(2, 1, 5, value, aux) && value == 42 );
+     METFLAGS_CHECK( in.lookup(2, 1, 6, value, aux) && value == 0 && aux == -6 );
+     in.beginRun(1, conditions);
+     METFLAGS_CHECK( !in.lookup(1, 1, 5, value, aux) );
+  }
+
+  std::remove(fileName.c_str());
+  return metFlagsTestResult("testMETFlagsSidecar");
+}